@@ -0,0 +1,299 @@
+#pragma once
+
+// Monotonic bump allocation for short-lived object graphs.  Everything
+// allocated from an arena is freed at once by resetting it, or rolled back
+// to a marker, instead of object by object:
+//
+//   auto a = txl::arena{};
+//   auto res = txl::arena_resource{a};
+//   auto headers = txl::pmr::vector<std::pmr::string>{&res};
+//   ... parse a request into headers ...
+//   a.reset();                            // headers must be gone by now
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Monotonic bump allocator over a chain of heap blocks.
+     *
+     * Allocating moves a pointer through the current block and starts a new
+     * block once it is full; requests larger than a block get a block of
+     * their own.  Nothing is freed individually.  rollback() frees back to
+     * a marker and reset() frees everything, keeping the blocks for reuse
+     * so a reset arena serving similar requests stops calling the heap.
+     *
+     * Not thread safe, give each thread or request its own arena.
+     */
+    class arena final
+    {
+    public:
+        static constexpr size_t default_block_size = 64 * 1024;
+
+        /**
+         * Position to roll an arena back to, see mark().
+         */
+        struct marker final
+        {
+            void * block = nullptr;
+            std::byte * ptr = nullptr;
+        };
+    private:
+        struct block final
+        {
+            block * prev;
+            size_t size;
+
+            auto begin() -> std::byte * { return reinterpret_cast<std::byte *>(this + 1); }
+            auto end() -> std::byte * { return reinterpret_cast<std::byte *>(this) + size; }
+        };
+
+        // Current block, blocks in use chain back from it
+        block * head_ = nullptr;
+        // Blocks freed by rollback or reset, kept for reuse
+        block * spare_ = nullptr;
+        std::byte * ptr_ = nullptr;
+        std::byte * end_ = nullptr;
+        size_t block_size_;
+        size_t num_bytes_reserved_ = 0;
+
+        static auto free_chain(block * b) -> void
+        {
+            while (b)
+            {
+                ::operator delete(std::exchange(b, b->prev));
+            }
+        }
+
+        auto take_block(size_t min_size) -> block *
+        {
+            for (auto p = &spare_; *p; p = &(*p)->prev)
+            {
+                if ((*p)->size >= min_size)
+                {
+                    return std::exchange(*p, (*p)->prev);
+                }
+            }
+            auto size = std::max(block_size_, min_size);
+            auto b = static_cast<block *>(::operator new(size));
+            b->size = size;
+            num_bytes_reserved_ += size;
+            return b;
+        }
+
+        auto allocate_slow(size_t size, size_t alignment) -> void *
+        {
+            auto b = take_block(sizeof(block) + size + alignment);
+            b->prev = head_;
+            head_ = b;
+            ptr_ = b->begin();
+            end_ = b->end();
+            return allocate(size, alignment);
+        }
+
+        /**
+         * Moves blocks in use after b to the spare list.
+         */
+        auto unwind_to(block * b) -> void
+        {
+            while (head_ != b)
+            {
+                auto prev = head_->prev;
+                head_->prev = spare_;
+                spare_ = head_;
+                head_ = prev;
+            }
+        }
+    public:
+        /**
+         * \param block_size bytes per block, including a small header
+         */
+        arena(size_t block_size = default_block_size)
+            : block_size_(std::max(block_size, sizeof(block) + alignof(std::max_align_t)))
+        {
+        }
+
+        arena(arena const &) = delete;
+
+        arena(arena && other)
+            : head_(std::exchange(other.head_, nullptr))
+            , spare_(std::exchange(other.spare_, nullptr))
+            , ptr_(std::exchange(other.ptr_, nullptr))
+            , end_(std::exchange(other.end_, nullptr))
+            , block_size_(other.block_size_)
+            , num_bytes_reserved_(std::exchange(other.num_bytes_reserved_, 0))
+        {
+        }
+
+        ~arena()
+        {
+            release();
+        }
+
+        auto operator=(arena const &) -> arena & = delete;
+
+        auto operator=(arena && other) -> arena &
+        {
+            if (this != &other)
+            {
+                release();
+                head_ = std::exchange(other.head_, nullptr);
+                spare_ = std::exchange(other.spare_, nullptr);
+                ptr_ = std::exchange(other.ptr_, nullptr);
+                end_ = std::exchange(other.end_, nullptr);
+                block_size_ = other.block_size_;
+                num_bytes_reserved_ = std::exchange(other.num_bytes_reserved_, 0);
+            }
+            return *this;
+        }
+
+        /**
+         * \param alignment power of two
+         */
+        auto allocate(size_t size, size_t alignment = alignof(std::max_align_t)) -> void *
+        {
+            auto p = reinterpret_cast<std::byte *>((reinterpret_cast<uintptr_t>(ptr_) + alignment - 1) & ~(alignment - 1));
+            if (head_ == nullptr or p > end_ or static_cast<size_t>(end_ - p) < size)
+            {
+                return allocate_slow(size, alignment);
+            }
+            ptr_ = p + size;
+            return p;
+        }
+
+        template<class T, class... Args>
+        auto make(Args && ... args) -> T *
+        {
+            return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        auto mark() const -> marker
+        {
+            return {head_, ptr_};
+        }
+
+        /**
+         * Frees everything allocated since m was taken.  Objects allocated
+         * since must already be destroyed.
+         */
+        auto rollback(marker m) -> void
+        {
+            unwind_to(static_cast<block *>(m.block));
+            if (head_)
+            {
+                ptr_ = m.ptr;
+                end_ = head_->end();
+            }
+            else
+            {
+                ptr_ = end_ = nullptr;
+            }
+        }
+
+        /**
+         * Frees everything, keeping the blocks for reuse.
+         */
+        auto reset() -> void
+        {
+            rollback({});
+        }
+
+        /**
+         * Frees everything and hands every block back to the heap.
+         */
+        auto release() -> void
+        {
+            reset();
+            free_chain(std::exchange(spare_, nullptr));
+            num_bytes_reserved_ = 0;
+        }
+
+        /**
+         * Bytes handed out from blocks in use, counting alignment padding
+         * and the unused tails of full blocks.
+         */
+        auto num_bytes_used() const -> size_t
+        {
+            size_t res = 0;
+            for (auto b = head_; b; b = b->prev)
+            {
+                res += b == head_ ? static_cast<size_t>(ptr_ - b->begin()) : b->size - sizeof(block);
+            }
+            return res;
+        }
+
+        /**
+         * Bytes held from the heap, in use or spare.
+         */
+        auto num_bytes_reserved() const -> size_t
+        {
+            return num_bytes_reserved_;
+        }
+
+        auto block_size() const -> size_t { return block_size_; }
+    };
+
+    /**
+     * Rolls an arena back to where it was when the scope was entered.
+     */
+    class arena_scope final
+    {
+    private:
+        arena & arena_;
+        arena::marker marker_;
+    public:
+        arena_scope(arena & a)
+            : arena_(a)
+            , marker_(a.mark())
+        {
+        }
+
+        arena_scope(arena_scope const &) = delete;
+        arena_scope(arena_scope &&) = delete;
+
+        ~arena_scope()
+        {
+            arena_.rollback(marker_);
+        }
+
+        auto operator=(arena_scope const &) -> arena_scope & = delete;
+        auto operator=(arena_scope &&) -> arena_scope & = delete;
+    };
+
+    /**
+     * std::pmr::memory_resource allocating from an arena, for pmr containers
+     * and strings.  Deallocation does nothing, memory comes back when the
+     * arena is reset.
+     */
+    class arena_resource final : public std::pmr::memory_resource
+    {
+    private:
+        arena & arena_;
+    protected:
+        auto do_allocate(size_t bytes, size_t alignment) -> void * override
+        {
+            return arena_.allocate(bytes, alignment);
+        }
+
+        auto do_deallocate(void *, size_t, size_t) -> void override
+        {
+        }
+
+        auto do_is_equal(std::pmr::memory_resource const & other) const noexcept -> bool override
+        {
+            return this == &other;
+        }
+    public:
+        arena_resource(arena & a)
+            : arena_(a)
+        {
+        }
+
+        auto get_arena() -> arena & { return arena_; }
+    };
+}
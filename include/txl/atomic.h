@@ -1,7 +1,18 @@
 #pragma once
 
+#include <txl/futex.h>
+#include <txl/reclaim.h>
+
 #include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace txl
 {
@@ -178,11 +189,249 @@ namespace txl
         T const * operator->() const { return &new_value_; }
     };
 
+    /**
+     * Sequence lock publishing a trivially copyable value, such as a
+     * multi-word config struct, to readers that never write shared memory.
+     *
+     * A writer makes the sequence odd while it copies the value in, and a
+     * reader retries a copy that a writer overlapped.  Reads are a copy and
+     * two loads, writes are serialized by the sequence itself.
+     *
+     * \tparam T value type, copied with memcpy
+     */
+    template<class T>
+    class seqlock final
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "seqlock values are copied while they may be written, they must be trivially copyable");
+    private:
+        std::atomic<uint64_t> seq_{0};
+        alignas(T) unsigned char value_[sizeof(T)];
+
+        auto begin_write() -> uint64_t
+        {
+            auto seq = seq_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                if (seq & 1)
+                {
+                    cpu_relax();
+                    seq = seq_.load(std::memory_order_relaxed);
+                }
+                else if (seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            // Keep the value's stores after the odd sequence
+            std::atomic_thread_fence(std::memory_order_release);
+            return seq + 1;
+        }
+
+        auto end_write(uint64_t seq) -> void
+        {
+            seq_.store(seq + 1, std::memory_order_release);
+        }
+    public:
+        seqlock(T const & value = T{})
+        {
+            std::memcpy(value_, &value, sizeof(T));
+        }
+
+        seqlock(seqlock const &) = delete;
+        seqlock(seqlock &&) = delete;
+
+        auto operator=(seqlock const &) -> seqlock & = delete;
+        auto operator=(seqlock &&) -> seqlock & = delete;
+
+        /**
+         * Copies the value, retrying while a writer overlaps.
+         */
+        auto load() const -> T
+        {
+            alignas(T) unsigned char buf[sizeof(T)];
+            while (true)
+            {
+                auto seq = seq_.load(std::memory_order_acquire);
+                if (seq & 1)
+                {
+                    cpu_relax();
+                    continue;
+                }
+                std::memcpy(buf, value_, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq_.load(std::memory_order_relaxed) == seq)
+                {
+                    return *std::launder(reinterpret_cast<T *>(buf));
+                }
+            }
+        }
+
+        auto store(T const & value) -> void
+        {
+            auto seq = begin_write();
+            std::memcpy(value_, &value, sizeof(T));
+            end_write(seq);
+        }
+
+        /**
+         * Modifies the value in place, excluding other writers.
+         *
+         * \param func function of type: (T &) -> void
+         */
+        template<class Func>
+        auto update(Func && func) -> void
+        {
+            auto seq = begin_write();
+            alignas(T) unsigned char buf[sizeof(T)];
+            std::memcpy(buf, value_, sizeof(T));
+            func(*std::launder(reinterpret_cast<T *>(buf)));
+            std::memcpy(value_, buf, sizeof(T));
+            end_write(seq);
+        }
+
+        /**
+         * Number of completed writes.
+         */
+        auto version() const -> uint64_t
+        {
+            return seq_.load(std::memory_order_acquire) / 2;
+        }
+    };
+
+    /**
+     * Read-copy-update pointer to an immutable value, such as a routing table,
+     * read far more often than it is replaced.
+     *
+     * Readers hold a read guard while they use the value, which costs a
+     * store and a fence but no read-modify-write.  Writers publish a new
+     * value with one exchange and retire the old one through Reclaimer, so
+     * it is freed only once no reader can still see it.
+     *
+     * \tparam T value type
+     * \tparam Reclaimer epoch_reclaimer or hazard_reclaimer
+     */
+    template<class T, class Reclaimer = epoch_reclaimer>
+    class rcu_ptr final
+    {
+    private:
+        std::atomic<T *> ptr_;
+        // Serializes update() so no copy-modify-publish is lost
+        std::mutex update_mut_{};
+    public:
+        /**
+         * Keeps the value it was created with alive while it exists.
+         */
+        class read_guard final
+        {
+        private:
+            typename Reclaimer::guard guard_{};
+            T const * ptr_;
+        public:
+            read_guard(std::atomic<T *> const & src)
+                : ptr_{guard_.protect(src)}
+            {
+            }
+
+            read_guard(read_guard const &) = delete;
+            read_guard(read_guard &&) = delete;
+
+            auto operator=(read_guard const &) -> read_guard & = delete;
+            auto operator=(read_guard &&) -> read_guard & = delete;
+
+            auto get() const -> T const * { return ptr_; }
+            auto operator*() const -> T const & { return *ptr_; }
+            auto operator->() const -> T const * { return ptr_; }
+            explicit operator bool() const { return ptr_ != nullptr; }
+        };
+
+        rcu_ptr(std::unique_ptr<T> value = nullptr)
+            : ptr_{value.release()}
+        {
+        }
+
+        rcu_ptr(rcu_ptr const &) = delete;
+        rcu_ptr(rcu_ptr &&) = delete;
+
+        ~rcu_ptr()
+        {
+            // Readers can't outlive the pointer they read from
+            delete ptr_.load(std::memory_order_acquire);
+        }
+
+        auto operator=(rcu_ptr const &) -> rcu_ptr & = delete;
+        auto operator=(rcu_ptr &&) -> rcu_ptr & = delete;
+
+        auto read() const -> read_guard
+        {
+            return read_guard{ptr_};
+        }
+
+        /**
+         * Calls func with the current value under a read guard.
+         *
+         * \param func function of type: (T const *) -> R
+         */
+        template<class Func>
+        auto read(Func && func) const -> decltype(func(std::declval<T const *>()))
+        {
+            auto g = read();
+            return func(g.get());
+        }
+
+        /**
+         * Publishes a new value, retiring the previous one.
+         */
+        auto store(std::unique_ptr<T> value) -> void
+        {
+            if (auto old = ptr_.exchange(value.release(), std::memory_order_acq_rel); old)
+            {
+                Reclaimer::retire(old);
+            }
+        }
+
+        template<class... Args>
+        auto emplace(Args && ... args) -> void
+        {
+            store(std::make_unique<T>(std::forward<Args>(args)...));
+        }
+
+        /**
+         * Publishes a modified copy of the current value.  Updates are
+         * serialized with each other but not with store().
+         *
+         * \param func function of type: (T &) -> void
+         */
+        template<class Func>
+        auto update(Func && func) -> void
+        {
+            auto lock = std::unique_lock<std::mutex>{update_mut_};
+            auto current = ptr_.load(std::memory_order_acquire);
+            auto value = current ? std::make_unique<T>(*current) : std::make_unique<T>();
+            func(*value);
+            store(std::move(value));
+        }
+    };
+
+    /**
+     * Pointer to a value created on first access by a factory, once, however
+     * many threads race for it.
+     *
+     * Once the value exists an access is a single acquire load.  Threads
+     * arriving while another runs the factory spin briefly and then sleep
+     * on a futex, so a factory doing slow I/O doesn't burn the other cores.
+     * If the factory throws the exception reaches its caller and the next
+     * access tries again.
+     *
+     * \tparam Value value type
+     */
     template<class Value>
     class lazy_atomic final
     {
     public:
         using factory_type = std::function<Value*()>;
+
+        static constexpr uint32_t spin_limit = 128;
+        static constexpr uint32_t yield_limit = 4;
     private:
         struct init_ready final
         {
@@ -218,14 +467,71 @@ namespace txl
             auto get() const { return reinterpret_cast<Value const *>(ptr_); }
             auto get() { return reinterpret_cast<Value *>(ptr_); }
         };
+        // Read on every access, keep it clear of the waiter bookkeeping
+        alignas(64) std::atomic<node> value_;
+        // Futex word bumped whenever a pending node is resolved
+        alignas(64) std::atomic<uint32_t> num_resolved_{0};
+        std::atomic<uint32_t> num_waiters_{0};
         factory_type factory_;
-        std::atomic<node> value_;
+
+        /**
+         * Replaces the pending node and wakes threads waiting on it.
+         */
+        auto resolve(node n) -> void
+        {
+            value_.store(n, std::memory_order_release);
+            num_resolved_.fetch_add(1, std::memory_order_seq_cst);
+            if (num_waiters_.load(std::memory_order_seq_cst) > 0)
+            {
+                futex_wake(num_resolved_);
+            }
+        }
+
+        /**
+         * Waits for a pending node to be resolved.
+         */
+        auto wait_while_pending() -> node
+        {
+            auto current = node{};
+            for (uint32_t i = 0; i < spin_limit; ++i)
+            {
+                current = value_.load(std::memory_order_acquire);
+                if (not current.is_pending())
+                {
+                    return current;
+                }
+                cpu_relax();
+            }
+
+            for (uint32_t i = 0; i < yield_limit; ++i)
+            {
+                std::this_thread::yield();
+                current = value_.load(std::memory_order_acquire);
+                if (not current.is_pending())
+                {
+                    return current;
+                }
+            }
+
+            num_waiters_.fetch_add(1, std::memory_order_seq_cst);
+            while (true)
+            {
+                auto num_resolved = num_resolved_.load(std::memory_order_seq_cst);
+                current = value_.load(std::memory_order_acquire);
+                if (not current.is_pending())
+                {
+                    break;
+                }
+                futex_wait(num_resolved_, num_resolved);
+            }
+            num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+            return current;
+        }
     public:
         lazy_atomic(factory_type fac)
-            : factory_{std::move(fac)}
+            : value_{node{}}
+            , factory_{std::move(fac)}
         {
-            // Empty
-            value_.store(node{}, std::memory_order_release);
         }
 
         lazy_atomic(lazy_atomic const &) = delete;
@@ -277,12 +583,16 @@ namespace txl
             if (replaced)
             {
                 // We captured the spot (already), let's get the pointer or initialize it first
-                desired = node{std::move(v)};
-                do
+                try
                 {
-                    expected = value_.load(std::memory_order_acquire);
+                    desired = node{std::move(v)};
                 }
-                while (not value_.compare_exchange_weak(expected, desired, std::memory_order_release, std::memory_order_relaxed));
+                catch (...)
+                {
+                    resolve(node{});
+                    throw;
+                }
+                resolve(desired);
             }
             
             return *this;
@@ -290,39 +600,57 @@ namespace txl
 
         auto ptr() -> Value *
         {
-            node expected, desired{init_ready{}};
-            // Perform a swap just to reserve the spot -- we'll init later
-            bool replaced = false;
-            do
+            // Fast path once initialized
+            auto expected = value_.load(std::memory_order_acquire);
+            if (expected.has_value())
             {
-                replaced = false;
-                expected = value_.load(std::memory_order_acquire);
-                if (not expected.is_empty())
-                {
-                    break;
-                }
-                replaced = true;
+                return expected.get();
             }
-            while (not value_.compare_exchange_weak(expected, desired, std::memory_order_release, std::memory_order_relaxed));
 
-            if (replaced)
+            while (true)
             {
-                // We captured the spot (already), let's get the pointer or initialize it first
-                desired = node{factory_};
+                node desired{init_ready{}};
+                // Perform a swap just to reserve the spot -- we'll init later
+                bool replaced = false;
                 do
                 {
+                    replaced = false;
                     expected = value_.load(std::memory_order_acquire);
+                    if (not expected.is_empty())
+                    {
+                        break;
+                    }
+                    replaced = true;
                 }
-                while (not value_.compare_exchange_weak(expected, desired, std::memory_order_release, std::memory_order_relaxed));
-            }
-            
-            // Spin until we get a node that isn't pending
-            do
-            {
-                expected = value_.load(std::memory_order_relaxed);
+                while (not value_.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+                if (replaced)
+                {
+                    // We captured the spot (already), initialize it
+                    try
+                    {
+                        desired = node{factory_};
+                    }
+                    catch (...)
+                    {
+                        // Let the next caller try again
+                        resolve(node{});
+                        throw;
+                    }
+                    resolve(desired);
+                    return desired.get();
+                }
+
+                if (expected.is_pending())
+                {
+                    expected = wait_while_pending();
+                }
+                if (expected.has_value())
+                {
+                    return expected.get();
+                }
+                // The factory threw or the value was cleared, take our turn
             }
-            while (expected.is_pending());
-            return expected.get();
         }
 
         auto get() -> Value &
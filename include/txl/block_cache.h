@@ -0,0 +1,210 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Recycles small heap blocks by size class.
+     *
+     * Each thread keeps a free list per size class.  When a thread's list
+     * grows past its limit a batch of blocks is moved to a shared depot, and
+     * a thread that runs dry takes a batch back before falling back to the
+     * global allocator.  Blocks freed on a consumer thread therefore find
+     * their way back to the producer, so producer/consumer pairs reach a
+     * steady state with no calls to the global allocator.
+     *
+     * Blocks are always obtained from ::operator new individually, so they
+     * may be freed from any thread, including after the owning thread exits.
+     */
+    class block_cache final
+    {
+    public:
+        static constexpr size_t granularity = 16;
+        static constexpr size_t num_classes = 64;
+        static constexpr size_t max_block_size = granularity * num_classes;
+        static constexpr size_t batch_size = 32;
+    private:
+        struct free_block
+        {
+            free_block * next;
+            // Set on the first block of each batch held by the depot
+            free_block * next_batch;
+        };
+
+        struct thread_list
+        {
+            free_block * head = nullptr;
+            size_t count = 0;
+        };
+
+        struct depot_list
+        {
+            std::mutex mut{};
+            free_block * batches = nullptr;
+        };
+
+        static inline thread_local bool alive_ = false;
+
+        std::array<thread_list, num_classes> lists_{};
+
+        block_cache()
+        {
+            alive_ = true;
+        }
+
+        static auto class_of(size_t num_bytes) -> size_t
+        {
+            return num_bytes == 0 ? 0 : (num_bytes - 1) / granularity;
+        }
+
+        static auto class_size(size_t index) -> size_t
+        {
+            return (index + 1) * granularity;
+        }
+
+        static auto depot() -> std::array<depot_list, num_classes> &
+        {
+            // Never destroyed, threads may return blocks during static destruction
+            static auto d = new std::array<depot_list, num_classes>{};
+            return *d;
+        }
+
+        static auto local() -> block_cache *
+        {
+            thread_local block_cache cache{};
+            return alive_ ? &cache : nullptr;
+        }
+
+        auto pop(size_t index) -> void *
+        {
+            auto & l = lists_[index];
+            if (not l.head)
+            {
+                auto & d = depot()[index];
+                auto lock = std::unique_lock<std::mutex>{d.mut};
+                if (not d.batches)
+                {
+                    return nullptr;
+                }
+                l.head = std::exchange(d.batches, d.batches->next_batch);
+                l.count = batch_size;
+            }
+            --l.count;
+            return std::exchange(l.head, l.head->next);
+        }
+
+        auto push(size_t index, void * p) -> void
+        {
+            auto & l = lists_[index];
+            l.head = new (p) free_block{l.head, nullptr};
+            ++l.count;
+            if (l.count < 2 * batch_size)
+            {
+                return;
+            }
+
+            // Hand the most recently freed batch to the depot
+            auto batch = l.head;
+            auto last = batch;
+            for (size_t i = 1; i < batch_size; ++i)
+            {
+                last = last->next;
+            }
+            l.head = std::exchange(last->next, nullptr);
+            l.count -= batch_size;
+
+            auto & d = depot()[index];
+            auto lock = std::unique_lock<std::mutex>{d.mut};
+            batch->next_batch = std::exchange(d.batches, batch);
+        }
+    public:
+        block_cache(block_cache const &) = delete;
+        block_cache(block_cache &&) = delete;
+
+        ~block_cache()
+        {
+            alive_ = false;
+            for (auto & l : lists_)
+            {
+                while (l.head)
+                {
+                    ::operator delete(std::exchange(l.head, l.head->next));
+                }
+                l.count = 0;
+            }
+        }
+
+        auto operator=(block_cache const &) -> block_cache & = delete;
+        auto operator=(block_cache &&) -> block_cache & = delete;
+
+        static auto allocate(size_t num_bytes) -> void *
+        {
+            auto index = class_of(num_bytes);
+            if (index >= num_classes)
+            {
+                return ::operator new(num_bytes);
+            }
+            if (auto c = local(); c)
+            {
+                if (auto p = c->pop(index); p)
+                {
+                    return p;
+                }
+            }
+            // Always the full class size so the block can be reused by any
+            // allocation in the class
+            return ::operator new(class_size(index));
+        }
+
+        static auto deallocate(void * p, size_t num_bytes) -> void
+        {
+            auto index = class_of(num_bytes);
+            auto c = local();
+            if (index >= num_classes or not c)
+            {
+                ::operator delete(p);
+                return;
+            }
+            c->push(index, p);
+        }
+
+        /**
+         * Number of blocks held by the calling thread, excluding the depot.
+         */
+        static auto num_cached() -> size_t
+        {
+            size_t res = 0;
+            if (auto c = local(); c)
+            {
+                for (auto const & l : c->lists_)
+                {
+                    res += l.count;
+                }
+            }
+            return res;
+        }
+    };
+
+    /**
+     * Base class routing a type's heap allocations through block_cache.
+     * Polymorphic types should inherit it at the root so deletes through a
+     * base pointer see the full object size.
+     */
+    struct block_cache_allocated
+    {
+        static auto operator new(size_t num_bytes) -> void *
+        {
+            return block_cache::allocate(num_bytes);
+        }
+
+        static auto operator delete(void * p, size_t num_bytes) -> void
+        {
+            block_cache::deallocate(p, num_bytes);
+        }
+    };
+}
@@ -1,14 +1,21 @@
 #pragma once
 
+#include <txl/object_pool.h>
 #include <txl/vector.h>
 
+#include <iostream>
 #include <memory>
 #include <optional>
 #include <stdexcept>
+#include <string>
 
 namespace txl
 {
-    template<class Key, class Value>
+    /**
+     * \tparam NodePolicy heap_nodes, or slab_nodes to keep nodes together in
+     *                    memory
+     */
+    template<class Key, class Value, class NodePolicy = heap_nodes>
     class btree final
     {
     private:
@@ -16,7 +23,7 @@ namespace txl
 
         struct node;
 
-        using node_ptr = std::unique_ptr<node>;
+        using node_ptr = node_unique_ptr<node, NodePolicy>;
 
         struct index_of_result final
         {
@@ -86,11 +93,11 @@ namespace txl
             {
                 auto mid = values.size() / 2;
 
-                auto left = std::make_unique<node>();
+                auto left = make_node<node, NodePolicy>();
                 std::move(values.begin(), std::next(values.begin(), mid), std::back_inserter(left->values));
                 std::move(children.begin(), std::next(children.begin(), mid+1), std::back_inserter(left->children));
                 
-                auto right = std::make_unique<node>();
+                auto right = make_node<node, NodePolicy>();
                 std::move(std::next(values.begin(), mid+1), values.end(), std::back_inserter(right->values));
                 std::move(std::next(children.begin(), mid+1), children.end(), std::back_inserter(right->children));
 
@@ -355,7 +362,7 @@ namespace txl
             return curr.values.size() < degree_-1;
         }
 
-        std::unique_ptr<node> root_;
+        node_ptr root_;
         size_t degree_;
     public:
         btree(size_t degree)
@@ -391,11 +398,11 @@ namespace txl
         {
             if (root_ == nullptr)
             {
-                root_ = std::make_unique<node>();
+                root_ = make_node<node, NodePolicy>();
             }
             if (not insert_into_leaf(*root_, value))
             {
-                auto new_root = std::make_unique<node>();
+                auto new_root = make_node<node, NodePolicy>();
                 root_->split_into(*new_root);
                 root_ = std::move(new_root);
             }
@@ -405,12 +412,12 @@ namespace txl
         {
             if (root_ == nullptr)
             {
-                root_ = std::make_unique<node>();
+                root_ = make_node<node, NodePolicy>();
             }
             auto data = std::make_pair(std::move(key), std::move(value));
             if (not insert_into_leaf(*root_, data))
             {
-                auto new_root = std::make_unique<node>();
+                auto new_root = make_node<node, NodePolicy>();
                 root_->split_into(*new_root);
                 root_ = std::move(new_root);
             }
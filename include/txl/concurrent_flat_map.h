@@ -0,0 +1,538 @@
+#pragma once
+
+// Hash map for read-mostly tables shared between threads
+
+#include <txl/futex.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace txl
+{
+    /**
+     * Open addressing, linear probing hash map like flat_map, safe to share
+     * between threads.
+     *
+     * Lookups take no lock.  Every slot carries a sequence number that a
+     * writer makes odd while it changes the slot, and a lookup retries a
+     * slot whose number moved while it copied the entry.  Writers lock one of
+     * a fixed set of stripes picked by the key's hash, so writers of
+     * different keys rarely meet.
+     *
+     * Growing is incremental: a resize allocates the next table and every
+     * write migrates a few slots into it, while lookups check the old table
+     * and then the new one.  Outgrown tables are kept until the map is
+     * destroyed so a lookup never reads freed memory, together they are
+     * smaller than the current table.
+     *
+     * Entries are copied in and out with memcpy, so keys and values must be
+     * trivially copyable; store handles or indices to larger objects.
+     */
+    template<class Key, class Value, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>>
+    class concurrent_flat_map final
+    {
+        static_assert(std::is_trivially_copyable_v<Key> and std::is_trivially_copyable_v<Value>, "Entries are read while they may be written, they must be trivially copyable");
+    public:
+        // Slots each write migrates while the map is resizing
+        static constexpr size_t migrate_step = 32;
+    private:
+        enum slot_state : uint8_t
+        {
+            state_empty,
+            // Claimed by an insert that hasn't written the entry yet
+            state_busy,
+            state_full,
+            state_deleted,
+            // Copied to the next table
+            state_moved,
+        };
+
+        struct slot final
+        {
+            std::atomic<uint32_t> seq{0};
+            std::atomic<uint8_t> state{state_empty};
+            alignas(Key) unsigned char key[sizeof(Key)];
+            alignas(Value) unsigned char value[sizeof(Value)];
+        };
+
+        struct table final
+        {
+            size_t mask;
+            std::unique_ptr<slot[]> slots;
+            std::atomic<table *> next{nullptr};
+            // Full or deleted slots, the table resizes past the max load
+            std::atomic<size_t> num_used{0};
+            std::atomic<size_t> migrate_pos{0};
+            std::atomic<size_t> num_migrated{0};
+
+            table(size_t capacity)
+                : mask(capacity - 1)
+                , slots(new slot[capacity])
+            {
+            }
+
+            auto capacity() const -> size_t { return mask + 1; }
+        };
+
+        struct alignas(64) stripe final
+        {
+            std::mutex mut{};
+        };
+
+        Hash hash_;
+        KeyEqual eq_;
+        double max_load_;
+        size_t stripe_mask_;
+        std::unique_ptr<stripe[]> stripes_;
+        std::mutex resize_mut_{};
+        std::vector<std::unique_ptr<table>> tables_{};
+        // Oldest table lookups must check, later tables hang off its next
+        std::atomic<table *> table_{nullptr};
+        std::atomic<size_t> size_{0};
+
+        static auto round_up(size_t n) -> size_t
+        {
+            size_t res = 8;
+            while (res < n)
+            {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        template<class T>
+        static auto load_bytes(unsigned char const * p) -> T
+        {
+            alignas(T) unsigned char buf[sizeof(T)];
+            std::memcpy(buf, p, sizeof(T));
+            return *std::launder(reinterpret_cast<T *>(buf));
+        }
+
+        auto mixed_hash(Key const & key) const -> uint64_t
+        {
+            auto h = static_cast<uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ull;
+            return h ^ (h >> 29);
+        }
+
+        auto stripe_of(uint64_t h) -> std::mutex &
+        {
+            return stripes_[(h >> 40) & stripe_mask_].mut;
+        }
+
+        static auto begin_write(slot & s) -> void
+        {
+            s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        static auto end_write(slot & s) -> void
+        {
+            s.seq.store(s.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        /**
+         * Copies a consistent state and, for a full slot, entry out of a
+         * slot, retrying while a writer changes it.
+         */
+        static auto read_slot(slot const & s, unsigned char * key, unsigned char * value) -> uint8_t
+        {
+            while (true)
+            {
+                auto seq = s.seq.load(std::memory_order_acquire);
+                if (seq & 1)
+                {
+                    cpu_relax();
+                    continue;
+                }
+                auto state = s.state.load(std::memory_order_relaxed);
+                if (state == state_full)
+                {
+                    std::memcpy(key, s.key, sizeof(Key));
+                    if (value)
+                    {
+                        std::memcpy(value, s.value, sizeof(Value));
+                    }
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (s.seq.load(std::memory_order_relaxed) == seq)
+                {
+                    return state;
+                }
+            }
+        }
+
+        auto find_in(table const & t, Key const & key, uint64_t h) const -> std::optional<Value>
+        {
+            alignas(Key) unsigned char k[sizeof(Key)];
+            alignas(Value) unsigned char v[sizeof(Value)];
+            for (size_t n = 0, i = h & t.mask; n <= t.mask; ++n, i = (i + 1) & t.mask)
+            {
+                auto state = read_slot(t.slots[i], k, v);
+                if (state == state_empty)
+                {
+                    break;
+                }
+                if (state == state_full and eq_(*std::launder(reinterpret_cast<Key *>(k)), key))
+                {
+                    return *std::launder(reinterpret_cast<Value *>(v));
+                }
+            }
+            return {};
+        }
+
+        /**
+         * Slot holding key in t.  Only called with the key's stripe held, so
+         * the slot can't change hands under the caller.
+         */
+        auto find_slot(table & t, Key const & key, uint64_t h) -> slot *
+        {
+            alignas(Key) unsigned char k[sizeof(Key)];
+            for (size_t n = 0, i = h & t.mask; n <= t.mask; ++n, i = (i + 1) & t.mask)
+            {
+                auto & s = t.slots[i];
+                auto state = read_slot(s, k, nullptr);
+                if (state == state_empty)
+                {
+                    break;
+                }
+                if (state == state_full and eq_(*std::launder(reinterpret_cast<Key *>(k)), key))
+                {
+                    return &s;
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Claims a free slot in t and writes the entry.
+         *
+         * \return false if t is full or the probe ran into migrated slots
+         */
+        auto insert_slot(table & t, Key const & key, Value const & value, uint64_t h) -> bool
+        {
+            for (size_t n = 0, i = h & t.mask; n <= t.mask; ++n, i = (i + 1) & t.mask)
+            {
+                auto & s = t.slots[i];
+                auto state = s.state.load(std::memory_order_acquire);
+                while (state == state_empty or state == state_deleted)
+                {
+                    auto claimed = state;
+                    if (s.state.compare_exchange_weak(state, state_busy, std::memory_order_acquire, std::memory_order_acquire))
+                    {
+                        begin_write(s);
+                        std::memcpy(s.key, &key, sizeof(Key));
+                        std::memcpy(s.value, &value, sizeof(Value));
+                        s.state.store(state_full, std::memory_order_relaxed);
+                        end_write(s);
+                        if (claimed == state_empty)
+                        {
+                            t.num_used.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        return true;
+                    }
+                }
+                if (state == state_moved)
+                {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Copies a slot to the next table and marks it moved.
+         *
+         * \param held stripe the caller already holds, if any
+         */
+        auto migrate_slot(table & from, slot & s, std::mutex * held) -> void
+        {
+            auto state = s.state.load(std::memory_order_acquire);
+            while (true)
+            {
+                if (state == state_moved)
+                {
+                    return;
+                }
+                if (state == state_busy)
+                {
+                    // An insert is writing the entry, it won't be long
+                    cpu_relax();
+                    state = s.state.load(std::memory_order_acquire);
+                    continue;
+                }
+                if (state == state_empty or state == state_deleted)
+                {
+                    if (s.state.compare_exchange_weak(state, state_moved, std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        return;
+                    }
+                    continue;
+                }
+
+                alignas(Key) unsigned char k[sizeof(Key)];
+                if (read_slot(s, k, nullptr) != state_full)
+                {
+                    state = s.state.load(std::memory_order_acquire);
+                    continue;
+                }
+                auto const & key = *std::launder(reinterpret_cast<Key *>(k));
+                auto h = mixed_hash(key);
+                auto & m = stripe_of(h);
+                auto lock = std::unique_lock<std::mutex>{m, std::defer_lock};
+                if (&m != held)
+                {
+                    lock.lock();
+                }
+
+                // Erased, moved or reused for another key while we waited
+                state = s.state.load(std::memory_order_acquire);
+                if (state != state_full or not eq_(load_bytes<Key>(s.key), key))
+                {
+                    continue;
+                }
+                auto inserted = insert_slot(*from.next.load(std::memory_order_acquire), key, load_bytes<Value>(s.value), h);
+                assert(inserted and "Next table filled up during a resize");
+                (void)inserted;
+                begin_write(s);
+                s.state.store(state_moved, std::memory_order_relaxed);
+                end_write(s);
+                return;
+            }
+        }
+
+        /**
+         * Migrates the next few slots of the table being resized, if any.
+         */
+        auto help_migrate() -> void
+        {
+            auto t = table_.load(std::memory_order_acquire);
+            if (not t->next.load(std::memory_order_acquire))
+            {
+                return;
+            }
+            auto first = t->migrate_pos.fetch_add(migrate_step, std::memory_order_relaxed);
+            if (first >= t->capacity())
+            {
+                return;
+            }
+            auto last = std::min(first + migrate_step, t->capacity());
+            for (auto i = first; i < last; ++i)
+            {
+                migrate_slot(*t, t->slots[i], nullptr);
+            }
+            auto num_migrated = last - first;
+            if (t->num_migrated.fetch_add(num_migrated, std::memory_order_acq_rel) + num_migrated == t->capacity())
+            {
+                // Nothing is left in t, lookups can start at the next table
+                table_.store(t->next.load(std::memory_order_relaxed), std::memory_order_release);
+            }
+        }
+
+        auto finish_migration() -> void
+        {
+            while (table_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire))
+            {
+                help_migrate();
+                std::this_thread::yield();
+            }
+        }
+
+        /**
+         * Starts moving t to a new table, twice the size unless t is mostly
+         * tombstones.  Only one resize runs at a time.
+         */
+        auto start_resize(table & t) -> void
+        {
+            auto lock = std::unique_lock<std::mutex>{resize_mut_};
+            if (table_.load(std::memory_order_acquire) != &t or t.next.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            auto capacity = t.capacity();
+            if (size_.load(std::memory_order_relaxed) * 4 >= capacity)
+            {
+                capacity *= 2;
+            }
+            tables_.emplace_back(std::make_unique<table>(capacity));
+            t.next.store(tables_.back().get(), std::memory_order_release);
+        }
+
+        /**
+         * Moves key out of the tables being resized.
+         *
+         * \return the newest table
+         */
+        auto settle(Key const & key, uint64_t h, std::mutex & held) -> table &
+        {
+            auto t = table_.load(std::memory_order_acquire);
+            for (auto n = t->next.load(std::memory_order_acquire); n; t = n, n = t->next.load(std::memory_order_acquire))
+            {
+                if (auto s = find_slot(*t, key, h); s)
+                {
+                    migrate_slot(*t, *s, &held);
+                }
+            }
+            return *t;
+        }
+
+        auto write(Key const & key, Value const & value, bool assign) -> bool
+        {
+            help_migrate();
+            auto h = mixed_hash(key);
+            auto & m = stripe_of(h);
+            auto lock = std::unique_lock<std::mutex>{m};
+            while (true)
+            {
+                auto & t = settle(key, h, m);
+                if (auto s = find_slot(t, key, h); s)
+                {
+                    if (assign)
+                    {
+                        begin_write(*s);
+                        std::memcpy(s->value, &value, sizeof(Value));
+                        end_write(*s);
+                    }
+                    return false;
+                }
+                if (insert_slot(t, key, value, h))
+                {
+                    size_.fetch_add(1, std::memory_order_relaxed);
+                    if (t.num_used.load(std::memory_order_relaxed) > max_load_ * t.capacity())
+                    {
+                        start_resize(t);
+                    }
+                    return true;
+                }
+                if (not t.next.load(std::memory_order_acquire))
+                {
+                    // t filled up before a resize could finish, migrators
+                    // need the stripes so let go of ours meanwhile
+                    lock.unlock();
+                    finish_migration();
+                    start_resize(*table_.load(std::memory_order_acquire));
+                    lock.lock();
+                }
+            }
+        }
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+
+        /**
+         * \param capacity initial number of slots, rounded up to a power of two
+         * \param num_stripes number of writer locks, rounded up to a power of two
+         * \param max_load fraction of used slots that triggers a resize
+         */
+        concurrent_flat_map(size_t capacity = 16, size_t num_stripes = 64, double max_load = 0.5)
+            : hash_()
+            , eq_()
+            , max_load_(max_load)
+            , stripe_mask_(round_up(num_stripes) - 1)
+            , stripes_(new stripe[stripe_mask_ + 1])
+        {
+            tables_.emplace_back(std::make_unique<table>(round_up(capacity)));
+            table_.store(tables_.back().get(), std::memory_order_release);
+        }
+
+        concurrent_flat_map(concurrent_flat_map const &) = delete;
+        concurrent_flat_map(concurrent_flat_map &&) = delete;
+
+        auto operator=(concurrent_flat_map const &) -> concurrent_flat_map & = delete;
+        auto operator=(concurrent_flat_map &&) -> concurrent_flat_map & = delete;
+
+        auto size() const -> size_t
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        auto empty() const -> bool
+        {
+            return size() == 0;
+        }
+
+        /**
+         * Number of slots in the newest table.
+         */
+        auto capacity() const -> size_t
+        {
+            auto t = table_.load(std::memory_order_acquire);
+            while (auto n = t->next.load(std::memory_order_acquire))
+            {
+                t = n;
+            }
+            return t->capacity();
+        }
+
+        auto is_resizing() const -> bool
+        {
+            return table_.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) != nullptr;
+        }
+
+        auto find(Key const & key) const -> std::optional<Value>
+        {
+            auto h = mixed_hash(key);
+            // A key missing from a table being resized may already be in the
+            // next one
+            for (auto t = table_.load(std::memory_order_acquire); t; t = t->next.load(std::memory_order_acquire))
+            {
+                if (auto v = find_in(*t, key, h); v)
+                {
+                    return v;
+                }
+            }
+            return {};
+        }
+
+        auto contains(Key const & key) const -> bool
+        {
+            return find(key).has_value();
+        }
+
+        /**
+         * Inserts the entry unless the key is present.
+         *
+         * \return true if inserted
+         */
+        auto insert(Key const & key, Value const & value) -> bool
+        {
+            return write(key, value, false);
+        }
+
+        /**
+         * \return true if inserted, false if an existing value was replaced
+         */
+        auto insert_or_assign(Key const & key, Value const & value) -> bool
+        {
+            return write(key, value, true);
+        }
+
+        auto erase(Key const & key) -> bool
+        {
+            help_migrate();
+            auto h = mixed_hash(key);
+            auto & m = stripe_of(h);
+            auto lock = std::unique_lock<std::mutex>{m};
+            auto s = find_slot(settle(key, h, m), key, h);
+            if (not s)
+            {
+                return false;
+            }
+            begin_write(*s);
+            s->state.store(state_deleted, std::memory_order_relaxed);
+            end_write(*s);
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    };
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <txl/block_cache.h>
+#include <txl/tasks.h>
+
+#if not defined(__cpp_impl_coroutine)
+#error "txl/coroutine.h requires C++20 coroutine support"
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Resumes a suspended coroutine as a unit of work on a task_runner.
+     */
+    class coroutine_resume_closure final : public closure
+    {
+    private:
+        std::coroutine_handle<> handle_;
+    public:
+        coroutine_resume_closure(std::coroutine_handle<> h)
+            : handle_(h)
+        {
+        }
+
+        auto move() const -> std::unique_ptr<closure> override
+        {
+            auto c = std::make_unique<coroutine_resume_closure>(handle_);
+            c->set_priority(priority());
+            return c;
+        }
+
+        auto execute() -> void override
+        {
+            handle_.resume();
+        }
+
+        auto next() -> bool override
+        {
+            return false;
+        }
+
+        auto complete() -> void override
+        {
+        }
+    };
+
+    /**
+     * State shared by all task coroutine promises, independent of the
+     * result type.  Coroutine frames are recycled through block_cache.
+     */
+    class coroutine_task_promise_base : public block_cache_allocated
+    {
+    protected:
+        task_runner * runner_ = nullptr;
+        size_t priority_ = 0;
+    public:
+        /**
+         * Runner the coroutine was started on; awaited tasks run, and the
+         * coroutine resumes, on this runner.
+         */
+        auto runner() const -> task_runner &
+        {
+            return runner_ ? *runner_ : task_runner::global();
+        }
+
+        // Priority the coroutine was started with, shared by what it awaits
+        auto priority() const -> size_t { return priority_; }
+
+        // Coroutine tasks are lazy, like chained tasks they start when run
+        auto initial_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+    };
+
+    template<class ReturnType>
+    class task_promise_base : public coroutine_task_promise_base
+    {
+    protected:
+        task_resumer<ReturnType> target_{};
+    private:
+        struct final_awaiter
+        {
+            auto await_ready() noexcept -> bool { return false; }
+
+            auto await_suspend(std::coroutine_handle<>) noexcept -> void
+            {
+                // The frame stays alive until the owning task is destroyed,
+                // which may happen as soon as the target is resumed
+                target.resume();
+            }
+
+            auto await_resume() noexcept -> void {}
+
+            task_resumer<ReturnType> target;
+        };
+    public:
+        auto bind(task_resumer<ReturnType> target, task_runner * runner, size_t priority) -> void
+        {
+            target_ = target;
+            runner_ = runner;
+            this->priority_ = priority;
+        }
+
+        auto final_suspend() noexcept -> final_awaiter
+        {
+            return {target_};
+        }
+
+        auto unhandled_exception() -> void
+        {
+            target_.get_promise().set_exception(std::current_exception(), false);
+        }
+    };
+
+    template<class ReturnType>
+    class task_promise;
+
+    /**
+     * First step of a coroutine task's chain.  Starts the coroutine and
+     * detaches; the coroutine fulfils the task's promise when it finishes,
+     * from whichever thread it was last resumed on, and resumes the steps
+     * chained after it.
+     */
+    template<class ReturnType>
+    class coroutine_task_function final : public task_function<ReturnType>
+    {
+    private:
+        std::coroutine_handle<task_promise<ReturnType>> handle_;
+    public:
+        coroutine_task_function(std::coroutine_handle<task_promise<ReturnType>> h)
+            : handle_(h)
+        {
+        }
+
+        coroutine_task_function(coroutine_task_function const &) = delete;
+
+        ~coroutine_task_function()
+        {
+            handle_.destroy();
+        }
+
+        auto operator=(coroutine_task_function const &) -> coroutine_task_function & = delete;
+
+        auto execute(task_context<ReturnType> & ctx) -> void override
+        {
+            if (handle_.done())
+            {
+                throw std::logic_error{"coroutine task can only be run once"};
+            }
+            handle_.promise().bind(ctx.resumer(), ctx.runner(), ctx.priority());
+            ctx.detach();
+            // Nothing may be touched after resuming, the task can be
+            // destroyed as soon as the coroutine completes
+            auto h = handle_;
+            h.resume();
+        }
+    };
+
+    template<class ReturnType>
+    class task_promise final : public task_promise_base<ReturnType>
+    {
+    public:
+        auto get_return_object() -> task<ReturnType>
+        {
+            auto h = std::coroutine_handle<task_promise>::from_promise(*this);
+            return {std::unique_ptr<task_function<ReturnType>>{new coroutine_task_function<ReturnType>{h}}};
+        }
+
+        auto return_value(ReturnType v) -> void
+        {
+            this->target_.get_promise().set_value(std::move(v), false);
+        }
+    };
+
+    template<>
+    class task_promise<void> final : public task_promise_base<void>
+    {
+    public:
+        auto get_return_object() -> task<void>
+        {
+            auto h = std::coroutine_handle<task_promise>::from_promise(*this);
+            return {std::unique_ptr<task_function<void>>{new coroutine_task_function<void>{h}}};
+        }
+
+        auto return_void() -> void
+        {
+            target_.get_promise().set_value(false);
+        }
+    };
+
+    /**
+     * Awaits a task from a coroutine.  The task runs on the awaiting
+     * coroutine's runner and the coroutine is resumed there once the task
+     * completes, rather than blocking a thread on the task's future.
+     */
+    template<class ReturnType>
+    class task_awaitable final
+    {
+    private:
+        task<ReturnType> & task_;
+        task_runner * runner_ = nullptr;
+        size_t priority_ = 0;
+        std::coroutine_handle<> continuation_{};
+        // Set by whichever of await_suspend and completion finishes first
+        std::atomic<bool> ready_{false};
+
+        static auto on_complete(void * arg) -> void
+        {
+            auto self = static_cast<task_awaitable *>(arg);
+            if (self->ready_.exchange(true, std::memory_order_acq_rel))
+            {
+                // Already suspended, resume on the runner
+                auto c = coroutine_resume_closure{self->continuation_};
+                c.set_priority(self->priority_);
+                self->runner_->run(std::move(c));
+            }
+        }
+    public:
+        task_awaitable(task<ReturnType> & t)
+            : task_(t)
+        {
+        }
+
+        auto await_ready() -> bool
+        {
+            return false;
+        }
+
+        template<class Promise>
+        auto await_suspend(std::coroutine_handle<Promise> h) -> bool
+        {
+            if constexpr (std::is_base_of_v<coroutine_task_promise_base, Promise>)
+            {
+                runner_ = &h.promise().runner();
+                priority_ = h.promise().priority();
+            }
+            else
+            {
+                runner_ = &task_runner::global();
+            }
+            continuation_ = h;
+            task_.get_promise().set_continuation({&on_complete, this});
+            task_.run(*runner_, priority_);
+            // Keep going without suspending if the task finished inline
+            return not ready_.exchange(true, std::memory_order_acq_rel);
+        }
+
+        auto await_resume() -> ReturnType
+        {
+            auto & prom = task_.get_promise();
+            prom.rethrow_if_exception();
+            if constexpr (not std::is_void_v<ReturnType>)
+            {
+                return prom.release_value();
+            }
+        }
+    };
+
+    template<class ReturnType>
+    inline auto operator co_await(task<ReturnType> & t) -> task_awaitable<ReturnType>
+    {
+        return {t};
+    }
+
+    template<class ReturnType>
+    inline auto operator co_await(task<ReturnType> && t) -> task_awaitable<ReturnType>
+    {
+        return {t};
+    }
+}
+
+template<class ReturnType, class... Args>
+struct std::coroutine_traits<txl::task<ReturnType>, Args...>
+{
+    using promise_type = txl::task_promise<ReturnType>;
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <bitset>
+#include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <map>
 #include <vector>
@@ -9,14 +11,14 @@
 
 namespace txl
 {
-	template<class K, class V>
+	template<class K, class V, class Alloc = std::allocator<std::pair<K const, V>>>
 	class flat_map
 	{
 	public:
 	  struct bucket final
 	  {
-		char key_[sizeof(K)];
-		char value_[sizeof(V)];
+		alignas(K) char key_[sizeof(K)];
+		alignas(V) char value_[sizeof(V)];
 
 		bucket() = default;
 
@@ -43,18 +45,18 @@ namespace txl
       };
 
       using bucket_flags = std::bitset<2>;
-	  std::vector<bucket> buckets_;
-	  std::vector<bucket_flags> emplaced_;
+	  using bucket_vector = std::vector<bucket, typename std::allocator_traits<Alloc>::template rebind_alloc<bucket>>;
+	  using flags_vector = std::vector<bucket_flags, typename std::allocator_traits<Alloc>::template rebind_alloc<bucket_flags>>;
+	  bucket_vector buckets_;
+	  flags_vector emplaced_;
 	  double threshold_;
 	  size_t size_ = 0;
 	  size_t max_size_ = 0;
 
 	  auto resize(size_t new_size) -> void
 	  {
-		std::vector<bucket> new_buckets{};
-		new_buckets.resize(new_size);
-		std::vector<bucket_flags> new_emplaced{};
-		new_emplaced.resize(new_size);
+		bucket_vector new_buckets(new_size, buckets_.get_allocator());
+		flags_vector new_emplaced(new_size, emplaced_.get_allocator());
 
 		for (size_t i = 0; i < buckets_.size(); ++i)
 		{
@@ -70,13 +72,13 @@ namespace txl
 		max_size_ = buckets_.size() * threshold_;
 	  }
 
-	  static auto emplace(std::vector<bucket> & buckets, std::vector<bucket_flags> & emplaced, K && key, V && value, int max_tries) -> bool
+	  static auto emplace(bucket_vector & buckets, flags_vector & emplaced, K && key, V && value, int max_tries) -> bool
 	  {
 		auto h = std::hash<K>{}(key);
 
 
 		auto p = h % buckets.size();
-		size_t num_tries = 0;
+		int num_tries = 0;
 		while (emplaced[p][VISITED] && num_tries < max_tries)
 		{
 		  ++num_tries;
@@ -144,6 +146,7 @@ namespace txl
 	public:
 	  using key_type = K;
       using mapped_type = V;
+      using allocator_type = Alloc;
 
       auto end() const -> bucket const *
 	  {
@@ -161,11 +164,11 @@ namespace txl
 		return linear_find(key);
 	  }
 
-	  flat_map(size_t s = 17, double threshold = 0.45)
-		: threshold_(threshold)
+	  flat_map(size_t s = 17, double threshold = 0.45, Alloc const & alloc = Alloc{})
+		: buckets_(s, alloc)
+		, emplaced_(s, alloc)
+		, threshold_(threshold)
 	  {
-		buckets_.resize(s);
-		emplaced_.resize(s);
 		max_size_ = s * threshold_;
 	  }
 
@@ -189,4 +192,14 @@ namespace txl
 		size_ += s;
 	  }
 	};
+
+	namespace pmr
+	{
+	  /**
+	   * flat_map allocating from a std::pmr::memory_resource, such as an
+	   * arena_resource.
+	   */
+	  template<class K, class V>
+	  using flat_map = txl::flat_map<K, V, std::pmr::polymorphic_allocator<std::pair<K const, V>>>;
+	}
 }
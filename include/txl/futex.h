@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace txl
+{
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+    /**
+     * Hints to the CPU that the caller is in a spin-wait loop.
+     */
+    inline auto cpu_relax() -> void
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    /**
+     * Blocks the calling thread while the futex word holds the expected value.
+     * May return spuriously; callers must re-check their condition.
+     *
+     * \param word 32-bit futex word
+     * \param expected value the word must hold for the thread to sleep
+     */
+    inline auto futex_wait(std::atomic<uint32_t> & word, uint32_t expected) -> void
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    /**
+     * Wakes threads blocked on the futex word.
+     *
+     * \param word 32-bit futex word
+     * \param num_waiters maximum number of threads to wake
+     */
+    inline auto futex_wake(std::atomic<uint32_t> & word, int num_waiters = INT_MAX) -> void
+    {
+        ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, num_waiters, nullptr, nullptr, 0);
+    }
+}
@@ -109,6 +109,11 @@ namespace txl
             {
                 auto to_read = std::min(static_cast<size_t>(4096), num_total_ - num_read_);
                 auto mem_buf = mem_pool.allocate(to_read);
+                if (mem_buf.empty())
+                {
+                    // Pool exhausted, try again on the next pass
+                    return true;
+                }
 
                 auto bytes_read = file_.read(buffer_ref{mem_buf.data(), mem_buf.size()}.slice(0, to_read)).or_throw();
                 
@@ -146,6 +151,11 @@ namespace txl
             {
                 auto to_write = std::min(static_cast<size_t>(4096), num_total_ - num_written_);
                 auto mem_buf = mem_pool.allocate(to_write);
+                if (mem_buf.empty())
+                {
+                    // Pool exhausted, try again on the next pass
+                    return true;
+                }
 
                 // TODO: Notify and close on another thread
                 auto bytes_to_write = get_data_(buffer_ref{mem_buf.data(), mem_buf.size()}.slice(0, to_write));
@@ -232,9 +242,17 @@ namespace txl
 
             }
         }
+
+        static auto make_buffer_pool_options() -> memory_pool_options
+        {
+            // Sized for typical load, growing under bursts of readers
+            auto options = memory_pool_options{};
+            options.max_arenas = 16;
+            return options;
+        }
     public:
         io_reactor()
-            : buf_in_(16, 4096)
+            : buf_in_(16, 4096, make_buffer_pool_options())
             , file_proc_(buf_in_)
         {
         }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <txl/atomic.h>
+#include <txl/object_pool.h>
+#include <txl/reclaim.h>
 
 #include <atomic>
 #include <cassert>
@@ -8,14 +10,240 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 namespace txl
 {
-    // NOTE: For ABA problem, can we allocate a chunk of sizeof(Value)*N and use it
-    //       like an arena?
-    template<class Value>
+    /**
+     * Lock-free pool of Node sized blocks shared by every user of the same
+     * Node type.
+     *
+     * Blocks are carved out of slabs that are never returned to the system,
+     * so a block stays readable after it is freed; lock-free lists may read
+     * the link of a node another thread just popped without faulting, and
+     * the generation counter in the freelist head catches the reuse.
+     *
+     * Each thread keeps a small cache of free blocks and trades them with
+     * the shared freelist in batches, so the common allocate/free pair
+     * touches no shared state.
+     */
+    template<class Node>
+    class atomic_node_pool final
+    {
+    public:
+        static constexpr size_t slab_size = 64;
+        static constexpr size_t batch_size = 32;
+    private:
+        union free_node
+        {
+            free_node * next;
+            alignas(Node) unsigned char storage[sizeof(Node)];
+        };
+
+        struct alignas(16) tagged_head final
+        {
+            free_node * ptr;
+            uint64_t ctr;
+        };
+
+        struct thread_cache final
+        {
+            free_node * head = nullptr;
+            size_t count = 0;
+
+            ~thread_cache()
+            {
+                if (head)
+                {
+                    auto last = head;
+                    while (last->next)
+                    {
+                        last = last->next;
+                    }
+                    push_shared(head, last);
+                }
+                alive() = false;
+            }
+        };
+
+        static auto shared_head() -> tagged_head &
+        {
+            // Outlives every thread cache handing blocks back at exit
+            static tagged_head head{nullptr, 0};
+            return head;
+        }
+
+        static auto alive() -> bool &
+        {
+            static thread_local bool alive = true;
+            return alive;
+        }
+
+        static auto local() -> thread_cache *
+        {
+            static thread_local thread_cache cache{};
+            return alive() ? &cache : nullptr;
+        }
+
+        static auto push_shared(free_node * first, free_node * last) -> void
+        {
+            auto & target = shared_head();
+            tagged_head head, next;
+            __atomic_load(&target, &head, __ATOMIC_RELAXED);
+            do
+            {
+                last->next = head.ptr;
+                next = tagged_head{first, head.ctr + 1};
+            }
+            while (not __atomic_compare_exchange(&target, &head, &next, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+        }
+
+        static auto pop_shared() -> free_node *
+        {
+            auto & target = shared_head();
+            tagged_head head, next;
+            __atomic_load(&target, &head, __ATOMIC_ACQUIRE);
+            do
+            {
+                if (not head.ptr)
+                {
+                    return nullptr;
+                }
+                // Safe even if another thread won the block, slabs are never
+                // freed and the counter rejects a stale link
+                next = tagged_head{head.ptr->next, head.ctr + 1};
+            }
+            while (not __atomic_compare_exchange(&target, &head, &next, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+            return head.ptr;
+        }
+
+        static auto refill(thread_cache & c) -> void
+        {
+            while (c.count < batch_size)
+            {
+                auto n = pop_shared();
+                if (not n)
+                {
+                    break;
+                }
+                n->next = c.head;
+                c.head = n;
+                ++c.count;
+            }
+            if (c.head)
+            {
+                return;
+            }
+
+            auto slab = static_cast<free_node *>(::operator new(slab_size * sizeof(free_node)));
+            for (size_t i = 0; i < slab_size; ++i)
+            {
+                slab[i].next = c.head;
+                c.head = &slab[i];
+            }
+            c.count = slab_size;
+        }
+    public:
+        static auto allocate() -> void *
+        {
+            auto c = local();
+            if (not c)
+            {
+                // Thread is exiting, skip the cache
+                if (auto n = pop_shared(); n)
+                {
+                    return n;
+                }
+                return ::operator new(sizeof(free_node));
+            }
+            if (not c->head)
+            {
+                refill(*c);
+            }
+            --c->count;
+            return std::exchange(c->head, c->head->next);
+        }
+
+        static auto deallocate(void * p) -> void
+        {
+            auto n = static_cast<free_node *>(p);
+            auto c = local();
+            if (not c)
+            {
+                push_shared(n, n);
+                return;
+            }
+            n->next = c->head;
+            c->head = n;
+            ++c->count;
+            if (c->count < 2 * batch_size)
+            {
+                return;
+            }
+
+            // Keep the most recently freed, still cache hot, blocks and hand
+            // the older ones to the other threads
+            auto keep = c->head;
+            for (size_t i = 1; i < batch_size; ++i)
+            {
+                keep = keep->next;
+            }
+            auto first = std::exchange(keep->next, nullptr);
+            auto last = first;
+            while (last->next)
+            {
+                last = last->next;
+            }
+            c->count = batch_size;
+            push_shared(first, last);
+        }
+
+        /**
+         * Number of free blocks cached by the calling thread.
+         */
+        static auto num_cached() -> size_t
+        {
+            auto c = local();
+            return c ? c->count : 0;
+        }
+    };
+
+    /**
+     * Node allocation policy recycling nodes through atomic_node_pool.
+     * Nodes are never returned to the system, which also makes reading the
+     * link of a concurrently popped head safe.
+     */
+    struct pooled_nodes final
+    {
+        static constexpr bool stable_memory = true;
+
+        template<class Node>
+        using allocator = atomic_node_pool<Node>;
+    };
+
+    /**
+     * Lock-free LIFO list.  The head carries a generation counter so a head
+     * that was popped and pushed back between a load and a CAS is detected.
+     *
+     * Popping reads the head's link before the CAS that unlinks it, so a
+     * popped node is retired through Reclaimer rather than freed while
+     * another pop may still be reading it.  A popped value is destroyed
+     * straight away, only the node's memory is deferred.
+     *
+     * \tparam Value stored value type
+     * \tparam NodePolicy heap_nodes, pooled_nodes or slab_nodes
+     * \tparam Reclaimer epoch_reclaimer, hazard_reclaimer, or
+     *                   immediate_reclaimer for policies whose nodes are
+     *                   never unmapped
+     */
+    template<class Value, class NodePolicy = heap_nodes, class Reclaimer = epoch_reclaimer>
     class atomic_linked_list final
     {
+        // A pop racing another pop may read a node that was just freed
+        static_assert(NodePolicy::stable_memory or not std::is_same_v<Reclaimer, immediate_reclaimer>,
+                      "immediate_reclaimer requires a node policy whose memory is never unmapped");
     private:
         struct value_node final
         {
@@ -29,13 +257,16 @@ namespace txl
             }
         };
 
-        struct node_gen final
+        // 16-byte atomics require 16-byte alignment wherever the list is embedded
+        struct alignas(16) node_gen final
         {
             value_node * ptr;
             uint64_t ctr;
         };
 
         static_assert(sizeof(node_gen) <= sizeof(__uint128_t), "Generational node cannot exceed 16 bytes");
+
+        using node_allocator = typename NodePolicy::template allocator<value_node>;
         
         node_gen head_;
         std::atomic<size_t> num_inserts_;
@@ -53,7 +284,8 @@ namespace txl
 
         static inline auto compare_and_swap(node_gen & target, node_gen expected, node_gen desired) -> bool
         {
-            return __atomic_compare_exchange(&target, &expected, &desired, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+            // Release publishes a pushed node, acquire sees a popped one
+            return __atomic_compare_exchange(&target, &expected, &desired, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
         }
 
         static inline auto load(node_gen const & target) -> node_gen
@@ -74,6 +306,36 @@ namespace txl
         {
             __atomic_store(&target, &val, __ATOMIC_RELEASE);
         }
+
+        template<class... Args>
+        static auto make_node(Args && ... args) -> value_node *
+        {
+            auto p = node_allocator::allocate();
+            try
+            {
+                return new (p) value_node(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                node_allocator::deallocate(p);
+                throw;
+            }
+        }
+
+        static auto deallocate_node(void * p) -> void
+        {
+            node_allocator::deallocate(p);
+        }
+
+        /**
+         * Destroys the value now and hands the memory to the reclaimer, a
+         * concurrent pop may still read the link.
+         */
+        static auto retire_node(value_node * n) -> void
+        {
+            n->val.~Value();
+            Reclaimer::retire(n, &deallocate_node);
+        }
     public:
         atomic_linked_list()
         {
@@ -135,7 +397,7 @@ namespace txl
                 on_val(p_head->val);
 
                 auto next = p_head->next;
-                delete p_head;
+                retire_node(p_head);
                 ++num_released;
                 p_head = next;
             }
@@ -155,7 +417,7 @@ namespace txl
         template<class... Args>
         auto emplace_front(Args && ... args) -> void
         {
-            auto n = new value_node(std::forward<Args>(args)...);
+            auto n = make_node(std::forward<Args>(args)...);
             node_gen head, next;
             do
             {
@@ -171,10 +433,11 @@ namespace txl
         
         auto pop_and_release_front() -> std::optional<Value>
         {
+            auto g = typename Reclaimer::guard{};
             node_gen head, next;
             do
             {
-                head = load(head_);
+                head = g.protect([this]() { return load(head_); }, [](node_gen const & n) { return n.ptr; });
                 if (not head.ptr)
                 {
                     return {};
@@ -183,12 +446,8 @@ namespace txl
             }
             while (not compare_and_swap(head_, head, next));
             
-            if (not head.ptr)
-            {
-                return {};
-            }
             auto res = std::make_optional<Value>(std::move(head.ptr->val));
-            delete head.ptr;
+            retire_node(head.ptr);
             num_pops_.fetch_add(1, std::memory_order_acq_rel);
             return res;
         }
@@ -58,6 +58,20 @@ namespace txl
             uninitialized = MAP_UNINITIALIZED,
         };
 
+        enum advice_flags : int
+        {
+            normal = MADV_NORMAL,
+            random = MADV_RANDOM,
+            sequential = MADV_SEQUENTIAL,
+            will_need = MADV_WILLNEED,
+            dont_need = MADV_DONTNEED,
+            huge_pages = MADV_HUGEPAGE,
+            no_huge_pages = MADV_NOHUGEPAGE,
+#ifdef MADV_POPULATE_WRITE
+            populate_write = MADV_POPULATE_WRITE,
+#endif
+        };
+
         memory_map() = default;
         memory_map(memory_map const &) = delete;
         memory_map(memory_map && m)
@@ -134,6 +148,24 @@ namespace txl
             auto res = ::msync(mem.data(), mem.size(), flags);
             return handle_system_error(res);
         }
+
+        /**
+         * Changes the protection of a page-aligned range of the map, see
+         * mprotect(2).
+         */
+        auto protect(buffer_ref mem, protection_flags p_flags) -> result<void>
+        {
+            return handle_system_error(::mprotect(mem.data(), mem.size(), static_cast<int>(p_flags)));
+        }
+
+        /**
+         * Advises the kernel how a page-aligned range of the map will be
+         * used, see madvise(2).
+         */
+        auto advise(buffer_ref mem, advice_flags advice) -> result<void>
+        {
+            return handle_system_error(::madvise(mem.data(), mem.size(), static_cast<int>(advice)));
+        }
     };
 
     inline auto operator|(txl::memory_map::protection_flags x, txl::memory_map::protection_flags y) -> txl::memory_map::protection_flags
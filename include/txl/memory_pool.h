@@ -1,11 +1,24 @@
 #pragma once
 
+#include <txl/memory_map.h>
+#include <txl/numa.h>
 #include <txl/types.h>
 
-#include <mutex>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <cmath>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
 
 namespace txl
 {
@@ -13,8 +26,10 @@ namespace txl
     {
         // Memory chunk (rented)
         static constexpr uint16_t MEM_CHUNK = 1;
-        // Free chunk (used, available for rent)
+        // Free chunk (in the buddy bins, may coalesce with its buddy)
         static constexpr uint16_t FREE_CHUNK = 2;
+        // Cached chunk (free in a thread cache, never coalesced)
+        static constexpr uint16_t CACHED_CHUNK = 3;
 
         // "No chunk" identifier
         static constexpr uint32_t NO_CHUNK = 0xFFFFFFFF;
@@ -22,17 +37,79 @@ namespace txl
         // Memory pool chunk administrative header
         struct mempool_chunk_header
         {
-            union
-            {
-                // Free chunk: next chunk identifier (singly-linked list)
-                uint32_t next_chunk;
-                // Memory chunk: number of concurrent handles open to chunk
-                uint32_t num_references;
-            };
-            // Number of pages allocated in chunk
-            uint32_t num_pages;
-            // Chunk type (see constants above)
-            uint16_t type;
+            // Memory chunk: number of concurrent handles open to chunk
+            std::atomic<uint32_t> num_references{0};
+            // Free or cached chunk: next chunk identifier
+            std::atomic<uint32_t> next_chunk{NO_CHUNK};
+            // Free chunk: previous chunk identifier in its bin
+            uint32_t prev_chunk = NO_CHUNK;
+            // Number of pages allocated in chunk, always a power of two
+            uint32_t num_pages = 0;
+            // Chunk type (see constants above), read by a neighbour's free
+            std::atomic<uint16_t> type{FREE_CHUNK};
+        };
+
+        /**
+         * Lock-free LIFO of chunks linked by page id.  The head packs the
+         * first page id with a tag bumped on every change, so a chunk popped
+         * and pushed back between a load and a CAS is detected.  Chunks live
+         * in the pool's pages for its whole lifetime, so reading the link of
+         * a chunk another thread just popped is safe.
+         */
+        class mempool_free_list final
+        {
+        private:
+            std::atomic<uint64_t> head_{NO_CHUNK};
+            // Approximate, only used to decide when to hand chunks back
+            std::atomic<uint32_t> count_{0};
+
+            static uint64_t pack(uint32_t id, uint64_t head)
+            {
+                return (((head >> 32) + 1) << 32) | id;
+            }
+        public:
+            uint32_t count() const
+            {
+                return count_.load(std::memory_order_relaxed);
+            }
+
+            /**
+             * Pushes the chain first..last, already linked through
+             * next_chunk.
+             *
+             * \param get_page function of type: (uint32_t) -> mempool_chunk_header *
+             */
+            template<class GetPage>
+            void push(uint32_t first, uint32_t last, uint32_t num_chunks, GetPage && get_page)
+            {
+                auto tail = get_page(last);
+                auto head = head_.load(std::memory_order_relaxed);
+                do
+                {
+                    tail->next_chunk.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+                }
+                while (not head_.compare_exchange_weak(head, pack(first, head), std::memory_order_release, std::memory_order_relaxed));
+                count_.fetch_add(num_chunks, std::memory_order_relaxed);
+            }
+
+            template<class GetPage>
+            uint32_t pop(GetPage && get_page)
+            {
+                auto head = head_.load(std::memory_order_acquire);
+                uint64_t next;
+                do
+                {
+                    auto id = static_cast<uint32_t>(head);
+                    if (id == NO_CHUNK)
+                    {
+                        return NO_CHUNK;
+                    }
+                    next = pack(get_page(id)->next_chunk.load(std::memory_order_relaxed), head);
+                }
+                while (not head_.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+                count_.fetch_sub(1, std::memory_order_relaxed);
+                return static_cast<uint32_t>(head);
+            }
         };
     }
 
@@ -40,82 +117,544 @@ namespace txl
     class memory_pool_handle;
     class memory_pool_chunk;
 
+    struct memory_pool_stats final
+    {
+        size_t num_pages = 0;
+        // Pages in the buddy bins, not rented or cached by a thread
+        size_t num_free_pages = 0;
+        // Pages free in thread caches, approximate while threads allocate
+        size_t num_cached_pages = 0;
+        // Largest chunk that can be rented without draining thread caches
+        size_t largest_free_chunk_pages = 0;
+        // Most pages ever rented or cached at once
+        size_t high_water_pages = 0;
+        // Arenas currently backed by memory
+        size_t num_arenas = 0;
+    };
+
+    struct memory_pool_options final
+    {
+        // Number of free chunk caches, rounded up to a power of two; zero
+        // gives one per hardware thread
+        size_t num_shards = 0;
+        // Back the pool with an anonymous memory_map rather than the heap,
+        // implied by every option below
+        bool mapped = false;
+        // Map explicitly reserved huge pages (MAP_HUGETLB), falling back to
+        // transparent huge pages when none are available
+        bool huge_pages = false;
+        // Size of the system's default huge pages
+        size_t huge_page_size = 2 * 1024 * 1024;
+        // Ask for transparent huge pages (MADV_HUGEPAGE)
+        bool transparent_huge_pages = false;
+        // Fault every page in up front instead of on first touch
+        bool prefault = false;
+        // Bind the pages to a NUMA node before they are first touched
+        std::optional<size_t> numa_node{};
+        // Arenas of num_pages each the pool may grow to before it runs out
+        // of memory; address space for all of them is reserved up front,
+        // more than one implies mapped
+        size_t max_arenas = 1;
+        // How long an arena beyond the first must stay entirely free before
+        // its pages are handed back to the OS
+        std::chrono::milliseconds arena_cool_down = std::chrono::seconds{1};
+    };
+
     /**
-     * Memory pool implementation with chunks allocated by fixed-size pages
-     * and a LIFO-based free list.
+     * Memory pool implementation with chunks allocated by fixed-size pages.
+     *
+     * The pool is a buddy heap: chunks span a power of two pages, aligned to
+     * their size, with one bin of free chunks per size class.  A request
+     * takes a chunk from the smallest non-empty bin that fits and splits it
+     * down, handing the unused halves to the smaller bins; a freed chunk
+     * merges with its buddy while the buddy is free too, so neighbouring
+     * free chunks coalesce back into large ones.
+     *
+     * Threads don't touch the bins on every call.  Free chunks go to
+     * lock-free per-class caches held by shards, a thread allocating from
+     * and freeing to its own shard, so with no more threads than shards
+     * each thread effectively has a private cache.  Caches move chunks to
+     * and from the bins in batches under the pool mutex, and are drained
+     * back into the bins before the pool reports out of memory.  Reference
+     * counts are atomic, so copying and closing chunks never locks.
+     *
+     * By default the pages come from the heap.  memory_pool_options can
+     * instead map them, on huge pages to save dTLB misses, pre-faulted so
+     * the first rents don't take page faults, and bound to a NUMA node.
+     * Huge pages and NUMA binding are best effort, huge_tlb() and
+     * numa_bound() tell whether they took.
+     *
+     * A pool may also grow: it reserves address space for max_arenas arenas
+     * of num_pages each but only backs the first.  When the bins and thread
+     * caches can't serve a request the next arena is mapped in, and an
+     * arena that has stayed entirely free for arena_cool_down is handed
+     * back to the OS with MADV_DONTNEED, checked whenever chunks return to
+     * the bins and on trim().  Arenas sit back to back, so a page id still
+     * resolves with one multiplication; chunks never span arenas.
      *
      * Layout:
      *
      *      Page
      *       |
-     *   ----+----          +----------------+
-     *  {         }         |                v
-     *   +-+------+-+------+|+--------------+-+------+--------------------
-     *   |H|-mem--|H|-mem--|*|-free---------|*|-free-| - - - - - - - - - -
-     *   +-+------+-+------+-+--------------+-+------+--------------------
-     *                      ^                        ^
-     * Free List: ----------+                        |
-     * Next Alloc: ----------------------------------+
+     *   ----+----
+     *  {         }
+     *   +-+------+-+------+-+---------------+-+--------------------------------+
+     *   |H|-mem--|*|-free-|H|-mem-----------|*|-free---------------------------|
+     *   +-+------+-+------+-+---------------+-+--------------------------------+
+     *   \____1___/\___1___/\_______2________/\_______________4________________/
+     *               ^                         ^
+     * Bin 1: -------+                         |
+     * Bin 4: ---------------------------------+
      */
     class memory_pool final
     {
         friend class memory_pool_chunk;
+    public:
+        // Size classes, class c holds chunks of 2^c pages
+        static constexpr size_t num_classes = 32;
+        // Pages moved between a shard and the bins at once, at least one
+        // chunk whatever its class
+        static constexpr uint32_t batch_pages = 16;
     private:
-        // Allocation mutex
-        std::mutex mutex_;
-        // Raw memory pool
-        byte_vector data_;
-        // Number of pages allocated in memory pool
+        struct alignas(64) shard final
+        {
+            std::array<detail::mempool_free_list, num_classes> free_lists{};
+        };
+
+        // Raw memory pool, from the heap or mapped
+        byte_vector data_{};
+        memory_map map_{};
+        uint8_t * base_ = nullptr;
+        bool huge_tlb_ = false;
+        bool numa_bound_ = false;
+        // Number of pages per arena
         size_t num_pages_;
         // Number of bytes per page
         size_t bytes_per_page_;
-        // Allocation region
-        void * next_alloc_;
-        // Free list page identifier
-        uint32_t free_list_ = detail::NO_CHUNK;
+        // Per-thread free chunk caches, a power of two in number
+        std::unique_ptr<shard[]> shards_;
+        size_t shard_mask_;
+        // Guards the bins and the counters below
+        alignas(64) std::mutex mutex_;
+        // Free chunk bins, one doubly-linked list per size class
+        std::array<uint32_t, num_classes> bins_;
+        // Bit c set while bin c is non-empty
+        uint32_t bin_mask_ = 0;
+        size_t num_free_pages_ = 0;
+        size_t high_water_pages_ = 0;
+
+        enum class arena_state
+        {
+            unmapped,
+            backed,
+            released,
+        };
+
+        struct arena final
+        {
+            arena_state state = arena_state::unmapped;
+            size_t num_free_pages = 0;
+            std::chrono::steady_clock::time_point free_since{};
+        };
+
+        // Growth state, guarded by mutex_
+        std::vector<arena> arenas_;
+        size_t num_backed_pages_ = 0;
+        // Backed arenas beyond the first that are entirely free
+        size_t num_idle_arenas_ = 0;
+        std::chrono::milliseconds arena_cool_down_;
+        // Granularity of the mapping, for madvise and mprotect
+        size_t os_page_size_ = 4096;
+        bool prefault_ = false;
+
+        static size_t default_num_shards()
+        {
+            return std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        static size_t round_up_pow2(size_t n)
+        {
+            size_t res = 1;
+            while (res < n)
+            {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        static size_t class_of(size_t num_pages)
+        {
+            size_t c = 0;
+            while ((size_t{1} << c) < num_pages)
+            {
+                ++c;
+            }
+            return c;
+        }
+
+        static uint32_t batch_chunks(size_t c)
+        {
+            return std::max<uint32_t>(1, batch_pages >> std::min<size_t>(c, 31));
+        }
+
+        static size_t thread_index()
+        {
+            static std::atomic<size_t> next_index{0};
+            static thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        shard & local_shard()
+        {
+            return shards_[thread_index() & shard_mask_];
+        }
 
         detail::mempool_chunk_header * get_page(uint32_t id)
         {
-            return reinterpret_cast<detail::mempool_chunk_header *>(static_cast<uint8_t *>(data_.data()) + (bytes_per_page_ * id));
+            return std::launder(reinterpret_cast<detail::mempool_chunk_header *>(base_ + (bytes_per_page_ * id)));
+        }
+
+        uint32_t page_id(void const * p) const
+        {
+            return (static_cast<uint8_t const *>(p) - base_) / bytes_per_page_;
+        }
+
+        auto page_getter()
+        {
+            return [this](uint32_t id) { return get_page(id); };
+        }
+
+        // Bin operations, mutex_ held
+
+        void bin_push(uint32_t id, size_t c)
+        {
+            auto h = get_page(id);
+            h->num_pages = static_cast<uint32_t>(size_t{1} << c);
+            h->type.store(detail::FREE_CHUNK, std::memory_order_relaxed);
+            h->prev_chunk = detail::NO_CHUNK;
+            h->next_chunk.store(bins_[c], std::memory_order_relaxed);
+            if (bins_[c] != detail::NO_CHUNK)
+            {
+                get_page(bins_[c])->prev_chunk = id;
+            }
+            bins_[c] = id;
+            bin_mask_ |= uint32_t{1} << c;
         }
 
-        void * find_free_list_chunk(size_t size_pages)
+        void bin_remove(uint32_t id, size_t c)
         {
-            uint32_t * p_id = &free_list_;
-            while (*p_id != detail::NO_CHUNK)
+            auto h = get_page(id);
+            auto next = h->next_chunk.load(std::memory_order_relaxed);
+            if (h->prev_chunk == detail::NO_CHUNK)
+            {
+                bins_[c] = next;
+            }
+            else
+            {
+                get_page(h->prev_chunk)->next_chunk.store(next, std::memory_order_relaxed);
+            }
+            if (next != detail::NO_CHUNK)
             {
-                auto p = get_page(*p_id);
-                if (p->num_pages >= size_pages)
+                get_page(next)->prev_chunk = h->prev_chunk;
+            }
+            if (bins_[c] == detail::NO_CHUNK)
+            {
+                bin_mask_ &= ~(uint32_t{1} << c);
+            }
+        }
+
+        /**
+         * Takes a chunk of class c, splitting the smallest larger free chunk
+         * when bin c is empty.
+         */
+        uint32_t heap_take(size_t c)
+        {
+            auto fits = bin_mask_ & ~((uint32_t{1} << c) - 1);
+            if (fits == 0)
+            {
+                return detail::NO_CHUNK;
+            }
+            auto k = static_cast<size_t>(__builtin_ctz(fits));
+            auto id = bins_[k];
+            bin_remove(id, k);
+            while (k > c)
+            {
+                --k;
+                auto half = id + (uint32_t{1} << k);
+                ::new (static_cast<void *>(get_page(half))) detail::mempool_chunk_header{};
+                bin_push(half, k);
+            }
+            get_page(id)->num_pages = static_cast<uint32_t>(size_t{1} << c);
+
+            auto & a = arenas_[id / num_pages_];
+            if (a.num_free_pages == num_pages_ and &a != &arenas_[0])
+            {
+                --num_idle_arenas_;
+            }
+            a.num_free_pages -= size_t{1} << c;
+            num_free_pages_ -= size_t{1} << c;
+            high_water_pages_ = std::max(high_water_pages_, num_backed_pages_ - num_free_pages_);
+            return id;
+        }
+
+        /**
+         * Returns a chunk to the bins, merging it with its buddy for as long
+         * as the buddy is a whole free chunk.
+         */
+        void heap_give(uint32_t id)
+        {
+            auto c = class_of(get_page(id)->num_pages);
+            auto arena_index = id / num_pages_;
+            auto arena_start = arena_index * num_pages_;
+            auto & a = arenas_[arena_index];
+            a.num_free_pages += size_t{1} << c;
+            num_free_pages_ += size_t{1} << c;
+            if (a.num_free_pages == num_pages_ and arena_index != 0)
+            {
+                a.free_since = std::chrono::steady_clock::now();
+                ++num_idle_arenas_;
+            }
+
+            // Buddies are found relative to the arena so chunks never span two
+            auto local = id - arena_start;
+            while (c + 1 < num_classes)
+            {
+                auto size = size_t{1} << c;
+                auto buddy = local ^ size;
+                if (buddy + size > num_pages_)
                 {
-                    return static_cast<void *>(p);
+                    break;
                 }
-                p_id = &p->next_chunk;
+                // The buddy's first page always starts a chunk, though the
+                // chunk may be a smaller split piece
+                auto b = get_page(static_cast<uint32_t>(arena_start + buddy));
+                if (b->type.load(std::memory_order_relaxed) != detail::FREE_CHUNK or b->num_pages != size)
+                {
+                    break;
+                }
+                bin_remove(static_cast<uint32_t>(arena_start + buddy), c);
+                local = std::min(local, buddy);
+                ++c;
             }
+            bin_push(static_cast<uint32_t>(arena_start + local), c);
+        }
 
-            return nullptr;
+        /**
+         * Tiles an arena with the largest chunks aligned to their size.
+         */
+        void tile_arena(size_t arena_index)
+        {
+            auto arena_start = arena_index * num_pages_;
+            size_t local = 0;
+            while (local < num_pages_)
+            {
+                auto c = num_classes - 1;
+                while ((local & ((size_t{1} << c) - 1)) != 0 or local + (size_t{1} << c) > num_pages_)
+                {
+                    --c;
+                }
+                auto id = static_cast<uint32_t>(arena_start + local);
+                ::new (static_cast<void *>(get_page(id))) detail::mempool_chunk_header{};
+                bin_push(id, c);
+                local += size_t{1} << c;
+            }
+
+            auto & a = arenas_[arena_index];
+            a.state = arena_state::backed;
+            a.num_free_pages = num_pages_;
+            a.free_since = std::chrono::steady_clock::now();
+            num_free_pages_ += num_pages_;
+            num_backed_pages_ += num_pages_;
+            if (arena_index != 0)
+            {
+                ++num_idle_arenas_;
+            }
         }
 
-        uint32_t page_id(void const * p) const
+        /**
+         * Bytes of an arena, widened to whole OS pages when outward is set
+         * and narrowed to the OS pages entirely inside it otherwise.
+         */
+        buffer_ref arena_memory(size_t arena_index, bool outward)
         {
-            return (static_cast<uint8_t const *>(p) - static_cast<uint8_t const *>(data_.data())) / bytes_per_page_;
+            auto arena_bytes = num_pages_ * bytes_per_page_;
+            auto first = arena_index * arena_bytes;
+            auto last = first + arena_bytes;
+            if (outward)
+            {
+                first = first / os_page_size_ * os_page_size_;
+                last = std::min((last + os_page_size_ - 1) / os_page_size_ * os_page_size_, map_.size());
+            }
+            else
+            {
+                first = (first + os_page_size_ - 1) / os_page_size_ * os_page_size_;
+                last = std::max(first, last / os_page_size_ * os_page_size_);
+            }
+            return buffer_ref{base_ + first, last - first};
+        }
+
+        /**
+         * Backs the first arena that isn't, if the pool may still grow.
+         */
+        bool grow()
+        {
+            for (size_t i = 1; i < arenas_.size(); ++i)
+            {
+                if (arenas_[i].state == arena_state::backed)
+                {
+                    continue;
+                }
+                auto mem = arena_memory(i, true);
+                if (map_.protect(mem, memory_map::read | memory_map::write).is_error())
+                {
+                    return false;
+                }
+                if (prefault_)
+                {
+                    prefault(mem);
+                }
+                tile_arena(i);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * Hands arenas that have been entirely free for the cool-down back
+         * to the OS.
+         */
+        void release_idle_arenas()
+        {
+            if (num_idle_arenas_ == 0)
+            {
+                return;
+            }
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 1; i < arenas_.size(); ++i)
+            {
+                auto & a = arenas_[i];
+                if (a.state != arena_state::backed or a.num_free_pages != num_pages_ or now - a.free_since < arena_cool_down_)
+                {
+                    continue;
+                }
+
+                // An entirely free arena is a handful of free chunks
+                auto arena_start = i * num_pages_;
+                for (size_t local = 0; local < num_pages_;)
+                {
+                    auto h = get_page(static_cast<uint32_t>(arena_start + local));
+                    bin_remove(static_cast<uint32_t>(arena_start + local), class_of(h->num_pages));
+                    local += h->num_pages;
+                }
+                // Best effort, the pages are unused either way.  The range
+                // stays readable, a thread cache pop may still read a stale
+                // link from it before its CAS fails
+                map_.advise(arena_memory(i, false), memory_map::dont_need);
+
+                a.state = arena_state::released;
+                a.num_free_pages = 0;
+                num_free_pages_ -= num_pages_;
+                num_backed_pages_ -= num_pages_;
+                --num_idle_arenas_;
+            }
+        }
+
+        /**
+         * Hands every chunk cached by any shard back to the bins so they can
+         * coalesce.
+         */
+        void drain_shards()
+        {
+            for (size_t i = 0; i <= shard_mask_; ++i)
+            {
+                for (auto & list : shards_[i].free_lists)
+                {
+                    for (auto id = list.pop(page_getter()); id != detail::NO_CHUNK; id = list.pop(page_getter()))
+                    {
+                        heap_give(id);
+                    }
+                }
+            }
+        }
+
+        void * rent_chunk(uint32_t id)
+        {
+            auto h = get_page(id);
+            h->type.store(detail::MEM_CHUNK, std::memory_order_relaxed);
+            h->num_references.store(1, std::memory_order_relaxed);
+            return static_cast<void *>(h + 1);
+        }
+
+        /**
+         * Takes a chunk of class c from the bins along with up to a batch
+         * more for the calling thread's cache.
+         */
+        uint32_t refill(size_t c)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto id = heap_take(c);
+            if (id == detail::NO_CHUNK)
+            {
+                // Cached chunks may coalesce into one that fits
+                drain_shards();
+                id = heap_take(c);
+                if (id == detail::NO_CHUNK and grow())
+                {
+                    id = heap_take(c);
+                }
+                return id;
+            }
+
+            auto & list = local_shard().free_lists[c];
+            for (uint32_t n = 1; n < batch_chunks(c); ++n)
+            {
+                auto extra = heap_take(c);
+                if (extra == detail::NO_CHUNK)
+                {
+                    break;
+                }
+                get_page(extra)->type.store(detail::CACHED_CHUNK, std::memory_order_relaxed);
+                list.push(extra, extra, 1, page_getter());
+            }
+            return id;
+        }
+
+        void free_chunk(detail::mempool_chunk_header * h)
+        {
+            h->type.store(detail::CACHED_CHUNK, std::memory_order_relaxed);
+            auto id = page_id(static_cast<void const *>(h));
+            auto c = class_of(h->num_pages);
+            auto & list = local_shard().free_lists[c];
+            list.push(id, id, 1, page_getter());
+            if (list.count() <= 2 * batch_chunks(c))
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (uint32_t n = 0; n < batch_chunks(c); ++n)
+            {
+                auto extra = list.pop(page_getter());
+                if (extra == detail::NO_CHUNK)
+                {
+                    break;
+                }
+                heap_give(extra);
+            }
+            release_idle_arenas();
         }
 
         bool dec_ref(void * p)
         {
             auto h = static_cast<detail::mempool_chunk_header *>(p)-1;
-            if (h->type != detail::MEM_CHUNK)
+            if (h->type.load(std::memory_order_relaxed) != detail::MEM_CHUNK)
             {
                 return false;
             }
-            
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            h->num_references--;
-            if (h->num_references == 0)
+
+            if (h->num_references.fetch_sub(1, std::memory_order_acq_rel) == 1)
             {
-                h->type = detail::FREE_CHUNK;
-                h->next_chunk = free_list_;
-                free_list_ = page_id(static_cast<void const *>(h));
+                free_chunk(h);
             }
             return true;
         }
@@ -123,62 +662,138 @@ namespace txl
         bool inc_ref(void * p)
         {
             auto h = static_cast<detail::mempool_chunk_header *>(p)-1;
-            if (h->type != detail::MEM_CHUNK)
+            if (h->type.load(std::memory_order_relaxed) != detail::MEM_CHUNK)
             {
                 return false;
             }
-            
-            std::unique_lock<std::mutex> lock(mutex_);
-            
-            h->num_references++;
+
+            h->num_references.fetch_add(1, std::memory_order_relaxed);
             return true;
         }
 
-        void const * end_ptr() const
+        void * get_free_chunk(size_t num_bytes)
         {
-            return static_cast<void const *>(static_cast<uint8_t const *>(data_.data()) + (num_pages_ * bytes_per_page_));
-        }
+            auto num_pages = (num_bytes + sizeof(detail::mempool_chunk_header) + bytes_per_page_ - 1) / bytes_per_page_;
+            auto c = class_of(num_pages);
+            if (c >= num_classes or num_pages > num_pages_)
+            {
+                return nullptr;
+            }
 
-        void const * next_alloc(size_t num_pages) const
+            auto id = local_shard().free_lists[c].pop(page_getter());
+            if (id == detail::NO_CHUNK)
+            {
+                id = refill(c);
+            }
+            return id == detail::NO_CHUNK ? nullptr : rent_chunk(id);
+        }
+        void prefault(buffer_ref mem)
         {
-            return static_cast<void const *>(static_cast<uint8_t const *>(next_alloc_) + (bytes_per_page_ * num_pages));
+#ifdef MADV_POPULATE_WRITE
+            if (not map_.advise(mem, memory_map::populate_write).is_error())
+            {
+                return;
+            }
+#endif
+            auto p = static_cast<uint8_t volatile *>(mem.data());
+            for (size_t offset = 0; offset < mem.size(); offset += os_page_size_)
+            {
+                p[offset] = 0;
+            }
         }
 
-        void * get_free_chunk(size_t num_bytes)
+        void map_pages(memory_pool_options const & options)
         {
-            std::unique_lock<std::mutex> lock(mutex_);
+            auto size = num_pages_ * bytes_per_page_ * arenas_.size();
+            auto growable = arenas_.size() > 1;
+            // Arenas beyond the first are only reserved until the pool grows
+            auto prot = growable ? memory_map::none : memory_map::read | memory_map::write;
+            auto reserve = growable ? memory_map::no_swap : memory_map::anonymous;
+            // MAP_POPULATE would fault pages in before they can be bound or
+            // advised onto huge pages
+            auto can_populate = options.prefault and not options.numa_node and not growable;
 
-            // Find a suitable chunk in the free list
-            auto num_pages = static_cast<uint32_t>(std::ceil((float)(num_bytes+sizeof(detail::mempool_chunk_header)) / bytes_per_page_));
-            auto c = find_free_list_chunk(num_pages);
-            if (c)
+            if (options.huge_pages)
             {
-                auto h = static_cast<detail::mempool_chunk_header *>(c);
-                h->type = detail::MEM_CHUNK;
-                h->num_references = 1;
-                return static_cast<void *>(h + 1);
+                auto flags = memory_map::anonymous | memory_map::huge_tlb | reserve;
+                if (can_populate)
+                {
+                    flags = flags | memory_map::populate;
+                }
+                auto huge_size = (size + options.huge_page_size - 1) / options.huge_page_size * options.huge_page_size;
+                huge_tlb_ = not map_.open(huge_size, prot, false, flags).is_error();
             }
 
-            if (next_alloc(num_pages) > end_ptr())
+            auto transparent = options.transparent_huge_pages or (options.huge_pages and not huge_tlb_);
+            auto populated = huge_tlb_ and can_populate;
+            if (not huge_tlb_)
             {
-                // Out of memory
-                return nullptr;
+                auto flags = memory_map::anonymous | reserve;
+                if (can_populate and not transparent)
+                {
+                    flags = flags | memory_map::populate;
+                    populated = true;
+                }
+                map_.open(size, prot, false, flags).or_throw();
             }
+            base_ = static_cast<uint8_t *>(map_.data());
+            os_page_size_ = huge_tlb_ ? options.huge_page_size : static_cast<size_t>(::sysconf(_SC_PAGESIZE));
 
-            auto h = static_cast<detail::mempool_chunk_header *>(next_alloc_);
-            h->type = detail::MEM_CHUNK;
-            h->num_pages = num_pages;
-            h->num_references = 1;
-            next_alloc_ = static_cast<void *>(static_cast<uint8_t *>(next_alloc_) + (bytes_per_page_ * num_pages));
-            return static_cast<void *>(h + 1);
+            if (transparent)
+            {
+                // Best effort, THP may be disabled system-wide
+                map_.advise(map_.memory(), memory_map::huge_pages);
+            }
+            if (options.numa_node)
+            {
+                numa_bound_ = not bind_to_numa_node(map_.data(), map_.size(), *options.numa_node).is_error();
+            }
+            if (growable)
+            {
+                map_.protect(arena_memory(0, true), memory_map::read | memory_map::write).or_throw();
+            }
+            prefault_ = options.prefault;
+            if (prefault_ and not populated)
+            {
+                prefault(arena_memory(0, true));
+            }
         }
     public:
-        memory_pool(size_t num_pages, size_t bytes_per_page)
-            : data_(num_pages * bytes_per_page)
-            , num_pages_(num_pages)
+        /**
+         * \param num_shards number of free chunk caches, rounded up to a
+         *                   power of two; defaults to one per hardware thread
+         */
+        memory_pool(size_t num_pages, size_t bytes_per_page, size_t num_shards = default_num_shards())
+            : memory_pool(num_pages, bytes_per_page, memory_pool_options{num_shards})
+        {
+        }
+
+        /**
+         * \throw std::system_error if the pool can't be mapped
+         */
+        memory_pool(size_t num_pages, size_t bytes_per_page, memory_pool_options const & options)
+            : num_pages_(num_pages)
             , bytes_per_page_(bytes_per_page)
-            , next_alloc_(data_.data())
+            , shards_(new shard[round_up_pow2(options.num_shards ? options.num_shards : default_num_shards())])
+            , shard_mask_(round_up_pow2(options.num_shards ? options.num_shards : default_num_shards()) - 1)
+            , arenas_(std::max<size_t>(1, options.max_arenas))
+            , arena_cool_down_(options.arena_cool_down)
         {
+            if (num_pages_ * arenas_.size() >= detail::NO_CHUNK)
+            {
+                throw std::length_error{"memory_pool: too many pages"};
+            }
+            if (options.mapped or options.huge_pages or options.transparent_huge_pages or options.prefault or options.numa_node or arenas_.size() > 1)
+            {
+                map_pages(options);
+            }
+            else
+            {
+                data_.resize(num_pages * bytes_per_page);
+                base_ = data_.data();
+            }
+            bins_.fill(detail::NO_CHUNK);
+            tile_arena(0);
         }
 
         memory_pool(memory_pool const &) = delete;
@@ -187,6 +802,51 @@ namespace txl
         memory_pool & operator=(memory_pool const &) = delete;
         memory_pool & operator=(memory_pool &&) = delete;
 
+        // Pages per arena
+        size_t num_pages() const { return num_pages_; }
+        size_t max_arenas() const { return arenas_.size(); }
+        size_t bytes_per_page() const { return bytes_per_page_; }
+        size_t num_shards() const { return shard_mask_ + 1; }
+        bool is_mapped() const { return map_.is_open(); }
+        // Whether the pool sits on explicitly reserved huge pages
+        bool huge_tlb() const { return huge_tlb_; }
+        // Whether the pool's pages are bound to the requested NUMA node
+        bool numa_bound() const { return numa_bound_; }
+
+        memory_pool_stats stats()
+        {
+            auto res = memory_pool_stats{};
+            for (size_t i = 0; i <= shard_mask_; ++i)
+            {
+                for (size_t c = 0; c < num_classes; ++c)
+                {
+                    res.num_cached_pages += size_t{shards_[i].free_lists[c].count()} << c;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            res.num_pages = num_backed_pages_;
+            res.num_arenas = num_backed_pages_ / num_pages_;
+            res.num_free_pages = num_free_pages_;
+            res.high_water_pages = high_water_pages_;
+            if (bin_mask_ != 0)
+            {
+                res.largest_free_chunk_pages = size_t{1} << (31 - __builtin_clz(bin_mask_));
+            }
+            return res;
+        }
+
+        /**
+         * Hands the chunks cached by every thread back to the bins, letting
+         * them coalesce, then releases arenas past their cool-down.
+         */
+        void trim()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            drain_shards();
+            release_idle_arenas();
+        }
+
         inline memory_pool_chunk allocate(size_t num_bytes);
         inline memory_pool_handle rent(size_t num_bytes);
         inline void release(memory_pool_handle & h);
@@ -232,7 +892,7 @@ namespace txl
         void const * data() const { return data_; }
         size_t size() const { return size_; }
     };
-    
+
     class memory_pool_chunk final
     {
         friend class memory_pool;
@@ -283,7 +943,7 @@ namespace txl
         void const * data() const { return data_; }
         size_t size() const { return size_; }
     };
-    
+
     memory_pool_handle memory_pool::rent(size_t num_bytes)
     {
         auto h = get_free_chunk(num_bytes);
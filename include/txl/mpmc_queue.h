@@ -0,0 +1,336 @@
+#pragma once
+
+#include <txl/threading.h>
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Bounded lock-free multi-producer multi-consumer FIFO queue (Vyukov's
+     * array queue).
+     *
+     * Each slot carries a sequence number telling producers and consumers
+     * whose turn it is, so a push or pop is one CAS on a shared position and
+     * never allocates.  Slots sit on their own cache lines so neighbouring
+     * producers and consumers don't contend.
+     *
+     * The try_ variants fail rather than wait; push() and pop() park on an
+     * awaiter while the queue is full or empty.
+     *
+     * \tparam Value queued value type
+     */
+    template<class Value>
+    class mpmc_queue final
+    {
+    private:
+        struct alignas(64) slot final
+        {
+            std::atomic<size_t> seq{0};
+            alignas(Value) unsigned char storage[sizeof(Value)];
+
+            auto value() -> Value &
+            {
+                return *std::launder(reinterpret_cast<Value *>(storage));
+            }
+        };
+
+        std::unique_ptr<slot[]> slots_;
+        size_t mask_;
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) std::atomic<size_t> dequeue_pos_{0};
+        // Blocking callers, producers only signal when someone is waiting
+        alignas(64) std::atomic<size_t> num_pop_waiters_{0};
+        std::atomic<size_t> num_push_waiters_{0};
+        awaiter not_empty_{};
+        awaiter not_full_{};
+
+        static auto round_up_capacity(size_t capacity) -> size_t
+        {
+            if (capacity < 2)
+            {
+                return 2;
+            }
+            size_t res = 1;
+            while (res < capacity)
+            {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        auto signal(std::atomic<size_t> & num_waiters, awaiter & a) -> void
+        {
+            // Pairs with the waiter registering before it re-checks
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (num_waiters.load(std::memory_order_relaxed) > 0)
+            {
+                a.set();
+            }
+        }
+
+        /**
+         * Claims up to max_slots consecutive slots whose sequence is
+         * pos + offset, advancing pos past them.
+         *
+         * \return first claimed position and number of slots claimed
+         */
+        auto claim(std::atomic<size_t> & pos, size_t offset, size_t max_slots) -> std::pair<size_t, size_t>
+        {
+            auto p = pos.load(std::memory_order_relaxed);
+            while (true)
+            {
+                size_t n = 0;
+                while (n < max_slots)
+                {
+                    auto & s = slots_[(p + n) & mask_];
+                    auto seq = s.seq.load(std::memory_order_acquire);
+                    if (seq != p + n + offset)
+                    {
+                        break;
+                    }
+                    ++n;
+                }
+
+                if (n == 0)
+                {
+                    auto & s = slots_[p & mask_];
+                    auto seq = s.seq.load(std::memory_order_acquire);
+                    if (static_cast<std::ptrdiff_t>(seq - (p + offset)) < 0)
+                    {
+                        // Full for producers, empty for consumers
+                        return {p, 0};
+                    }
+                    // Another thread claimed p, catch up
+                    p = pos.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                // Slots we saw ready can only change hands by moving pos, so
+                // winning the CAS makes them ours
+                if (pos.compare_exchange_weak(p, p + n, std::memory_order_relaxed, std::memory_order_relaxed))
+                {
+                    return {p, n};
+                }
+            }
+        }
+
+        template<class... Args>
+        auto push_at(size_t pos, Args && ... args) -> void
+        {
+            auto & s = slots_[pos & mask_];
+            ::new (static_cast<void *>(s.storage)) Value(std::forward<Args>(args)...);
+            s.seq.store(pos + 1, std::memory_order_release);
+        }
+
+        auto pop_at(size_t pos) -> Value
+        {
+            auto & s = slots_[pos & mask_];
+            auto res = std::move(s.value());
+            s.value().~Value();
+            // Free for the producer one lap ahead
+            s.seq.store(pos + mask_ + 1, std::memory_order_release);
+            return res;
+        }
+    public:
+        /**
+         * \param capacity maximum number of queued values, rounded up to a
+         *                 power of two
+         */
+        mpmc_queue(size_t capacity)
+            : slots_(new slot[round_up_capacity(capacity)])
+            , mask_(round_up_capacity(capacity) - 1)
+        {
+            for (size_t i = 0; i <= mask_; ++i)
+            {
+                slots_[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpmc_queue(mpmc_queue const &) = delete;
+        mpmc_queue(mpmc_queue &&) = delete;
+
+        ~mpmc_queue()
+        {
+            clear();
+        }
+
+        auto operator=(mpmc_queue const &) -> mpmc_queue & = delete;
+        auto operator=(mpmc_queue &&) -> mpmc_queue & = delete;
+
+        auto capacity() const -> size_t
+        {
+            return mask_ + 1;
+        }
+
+        /**
+         * Number of claimed slots; approximate while other threads are
+         * pushing or popping.
+         */
+        auto size() const -> size_t
+        {
+            auto dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+            auto enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        auto empty() const -> bool
+        {
+            return size() == 0;
+        }
+
+        template<class... Args>
+        auto try_emplace(Args && ... args) -> bool
+        {
+            auto [pos, n] = claim(enqueue_pos_, 0, 1);
+            if (n == 0)
+            {
+                return false;
+            }
+            push_at(pos, std::forward<Args>(args)...);
+            signal(num_pop_waiters_, not_empty_);
+            return true;
+        }
+
+        auto try_push(Value const & v) -> bool
+        {
+            return try_emplace(v);
+        }
+
+        auto try_push(Value && v) -> bool
+        {
+            return try_emplace(std::move(v));
+        }
+
+        /**
+         * Pushes as many of [first, last) as fit, claiming their slots with a
+         * single CAS.  Values are moved from.
+         *
+         * \return number of values pushed, from the front of the range
+         */
+        template<class It>
+        auto try_push_n(It first, It last) -> size_t
+        {
+            auto num_values = static_cast<size_t>(std::distance(first, last));
+            if (num_values == 0)
+            {
+                return 0;
+            }
+            auto [pos, n] = claim(enqueue_pos_, 0, num_values);
+            for (size_t i = 0; i < n; ++i, ++first)
+            {
+                push_at(pos + i, std::move(*first));
+            }
+            if (n > 0)
+            {
+                signal(num_pop_waiters_, not_empty_);
+            }
+            return n;
+        }
+
+        auto try_pop() -> std::optional<Value>
+        {
+            auto [pos, n] = claim(dequeue_pos_, 1, 1);
+            if (n == 0)
+            {
+                return {};
+            }
+            auto res = std::make_optional<Value>(pop_at(pos));
+            signal(num_push_waiters_, not_full_);
+            return res;
+        }
+
+        /**
+         * Pops up to max_values of the oldest values in order, claiming their
+         * slots with a single CAS.
+         *
+         * \param on_value function of type: (Value &&) -> void
+         * \return number of values popped
+         */
+        template<class OnValueFunc>
+        auto try_pop_n(size_t max_values, OnValueFunc && on_value) -> size_t
+        {
+            if (max_values == 0)
+            {
+                return 0;
+            }
+            auto [pos, n] = claim(dequeue_pos_, 1, max_values);
+            for (size_t i = 0; i < n; ++i)
+            {
+                on_value(pop_at(pos + i));
+            }
+            if (n > 0)
+            {
+                signal(num_push_waiters_, not_full_);
+            }
+            return n;
+        }
+
+        /**
+         * Pushes a value, waiting while the queue is full.
+         */
+        auto push(Value v) -> void
+        {
+            if (try_push(std::move(v)))
+            {
+                return;
+            }
+            num_push_waiters_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (true)
+            {
+                not_full_.reset();
+                if (try_push(std::move(v)))
+                {
+                    break;
+                }
+                not_full_.wait();
+            }
+            num_push_waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (size() < capacity())
+            {
+                // Our reset may have eaten a wakeup meant for another waiter
+                signal(num_push_waiters_, not_full_);
+            }
+        }
+
+        /**
+         * Pops the oldest value, waiting while the queue is empty.
+         */
+        auto pop() -> Value
+        {
+            if (auto v = try_pop(); v)
+            {
+                return std::move(*v);
+            }
+            num_pop_waiters_.fetch_add(1, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (true)
+            {
+                not_empty_.reset();
+                if (auto v = try_pop(); v)
+                {
+                    num_pop_waiters_.fetch_sub(1, std::memory_order_relaxed);
+                    if (not empty())
+                    {
+                        // Our reset may have eaten a wakeup meant for another waiter
+                        signal(num_pop_waiters_, not_empty_);
+                    }
+                    return std::move(*v);
+                }
+                not_empty_.wait();
+            }
+        }
+
+        auto clear() -> size_t
+        {
+            return try_pop_n(capacity(), [](auto &&) {});
+        }
+    };
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <txl/block_cache.h>
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Unbounded lock-free multi-producer queue with FIFO ordering
+     * (Vyukov's node-based MPSC queue).
+     *
+     * Producers append with a single atomic exchange.  Consumption is
+     * guarded by a try-lock so that any thread may attempt to pop, but only
+     * one consumer runs at a time; a pop that loses the race returns empty
+     * rather than blocking.
+     *
+     * \tparam Value queued value type
+     */
+    template<class Value>
+    class mpsc_queue final
+    {
+    private:
+        // Nodes are freed by the consumer, block_cache returns them to producers
+        struct value_node final : block_cache_allocated
+        {
+            std::atomic<value_node *> next{nullptr};
+            std::optional<Value> val{};
+
+            value_node() = default;
+
+            template<class... Args>
+            value_node(std::in_place_t, Args && ... args)
+                : val(std::in_place, std::forward<Args>(args)...)
+            {
+            }
+        };
+
+        // Producer end, most recently pushed node
+        alignas(64) std::atomic<value_node *> head_;
+        // Consumer end, stub node whose successor is the front of the queue
+        alignas(64) value_node * tail_;
+        std::atomic_flag consuming_ = ATOMIC_FLAG_INIT;
+        std::atomic<size_t> size_{0};
+
+        auto pop_locked() -> std::optional<Value>
+        {
+            auto next = tail_->next.load(std::memory_order_acquire);
+            if (not next)
+            {
+                return {};
+            }
+            auto res = std::move(next->val);
+            next->val.reset();
+            delete tail_;
+            // Successor becomes the new stub
+            tail_ = next;
+            size_.fetch_sub(1, std::memory_order_acq_rel);
+            return res;
+        }
+    public:
+        mpsc_queue()
+        {
+            auto stub = new value_node{};
+            tail_ = stub;
+            head_.store(stub, std::memory_order_release);
+        }
+
+        mpsc_queue(mpsc_queue const &) = delete;
+        mpsc_queue(mpsc_queue &&) = delete;
+
+        ~mpsc_queue()
+        {
+            clear();
+            delete tail_;
+        }
+
+        auto operator=(mpsc_queue const &) -> mpsc_queue & = delete;
+        auto operator=(mpsc_queue &&) -> mpsc_queue & = delete;
+
+        /**
+         * Approximate while producers are pushing: values are counted just
+         * before they become visible, so a pop may briefly find nothing
+         * when size() is non-zero.
+         */
+        auto size() const -> size_t
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        auto empty() const -> bool
+        {
+            return size() == 0;
+        }
+
+        auto push_back(Value const & v) -> void
+        {
+            emplace_back(v);
+        }
+
+        template<class... Args>
+        auto emplace_back(Args && ... args) -> void
+        {
+            auto n = new value_node(std::in_place, std::forward<Args>(args)...);
+            // Counted before it can be popped so the count never drops below
+            // zero
+            size_.fetch_add(1, std::memory_order_acq_rel);
+            auto prev = head_.exchange(n, std::memory_order_acq_rel);
+            // Between the exchange and this store the queue appears to end at
+            // prev; consumers simply see fewer items until the link lands
+            prev->next.store(n, std::memory_order_release);
+        }
+
+        /**
+         * Pops the oldest value.  Returns empty if the queue is empty or
+         * another consumer is currently popping.
+         */
+        auto try_pop_front() -> std::optional<Value>
+        {
+            if (consuming_.test_and_set(std::memory_order_acquire))
+            {
+                return {};
+            }
+            auto res = pop_locked();
+            consuming_.clear(std::memory_order_release);
+            return res;
+        }
+
+        /**
+         * Pops up to max_values of the oldest values in order under a single
+         * acquisition of the consumer lock.
+         *
+         * \param max_values maximum number of values to pop
+         * \param on_value function of type: (Value &&) -> void
+         * \return number of values popped
+         */
+        template<class OnValueFunc>
+        auto pop_front_n(size_t max_values, OnValueFunc && on_value) -> size_t
+        {
+            if (consuming_.test_and_set(std::memory_order_acquire))
+            {
+                return 0;
+            }
+            size_t num_popped = 0;
+            while (num_popped < max_values)
+            {
+                auto v = pop_locked();
+                if (not v)
+                {
+                    break;
+                }
+                on_value(std::move(*v));
+                ++num_popped;
+            }
+            consuming_.clear(std::memory_order_release);
+            return num_popped;
+        }
+
+        auto clear() -> size_t
+        {
+            return pop_front_n(static_cast<size_t>(-1), [](auto &&) {});
+        }
+    };
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+// NUMA topology discovery and thread/memory placement for Linux
+
+#include <txl/handle_error.h>
+#include <txl/result.h>
+#include <txl/system_error.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace txl
+{
+    struct numa_node final
+    {
+        size_t id = 0;
+        std::vector<size_t> cpus{};
+    };
+
+    /**
+     * Parses a Linux cpu list such as "0-3,8,10-11".  Malformed entries are
+     * skipped.
+     */
+    inline auto parse_cpu_list(std::string_view list) -> std::vector<size_t>
+    {
+        auto res = std::vector<size_t>{};
+        auto parse_number = [](std::string_view s, size_t & value) {
+            if (s.empty())
+            {
+                return false;
+            }
+            value = 0;
+            for (auto c : s)
+            {
+                if (c < '0' or c > '9')
+                {
+                    return false;
+                }
+                value = value * 10 + static_cast<size_t>(c - '0');
+            }
+            return true;
+        };
+
+        while (not list.empty())
+        {
+            auto comma = list.find(',');
+            auto entry = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+            while (not entry.empty() and (entry.back() == '\n' or entry.back() == ' '))
+            {
+                entry.remove_suffix(1);
+            }
+
+            size_t first = 0;
+            size_t last = 0;
+            auto dash = entry.find('-');
+            if (dash == std::string_view::npos)
+            {
+                if (not parse_number(entry, first))
+                {
+                    continue;
+                }
+                last = first;
+            }
+            else if (not parse_number(entry.substr(0, dash), first) or not parse_number(entry.substr(dash + 1), last) or last < first)
+            {
+                continue;
+            }
+
+            for (auto cpu = first; cpu <= last; ++cpu)
+            {
+                res.emplace_back(cpu);
+            }
+        }
+        return res;
+    }
+
+    namespace detail
+    {
+        inline auto read_first_line(std::string const & path) -> std::optional<std::string>
+        {
+            auto in = std::ifstream{path};
+            auto line = std::string{};
+            if (not in or not std::getline(in, line))
+            {
+                return {};
+            }
+            return line;
+        }
+    }
+
+    /**
+     * Reads the NUMA topology from sysfs.  Nodes without CPUs are left out.
+     * Falls back to a single node holding every CPU when the topology is
+     * unavailable.
+     *
+     * \param root sysfs node directory
+     */
+    inline auto read_numa_nodes(std::string const & root = "/sys/devices/system/node") -> std::vector<numa_node>
+    {
+        auto res = std::vector<numa_node>{};
+        if (auto online = detail::read_first_line(root + "/online"); online)
+        {
+            for (auto id : parse_cpu_list(*online))
+            {
+                auto cpus = detail::read_first_line(root + "/node" + std::to_string(id) + "/cpulist");
+                if (not cpus)
+                {
+                    continue;
+                }
+                auto node = numa_node{id, parse_cpu_list(*cpus)};
+                if (not node.cpus.empty())
+                {
+                    res.emplace_back(std::move(node));
+                }
+            }
+        }
+
+        if (res.empty())
+        {
+            auto node = numa_node{};
+            auto num_cpus = std::max<size_t>(1, std::thread::hardware_concurrency());
+            for (size_t cpu = 0; cpu < num_cpus; ++cpu)
+            {
+                node.cpus.emplace_back(cpu);
+            }
+            res.emplace_back(std::move(node));
+        }
+        return res;
+    }
+
+    /**
+     * Restricts the calling thread to the given CPUs.
+     */
+    inline auto set_current_thread_affinity(std::vector<size_t> const & cpus) -> result<void>
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : cpus)
+        {
+            if (cpu < CPU_SETSIZE)
+            {
+                CPU_SET(cpu, &set);
+            }
+        }
+        return handle_system_error(::sched_setaffinity(0, sizeof(set), &set));
+    }
+
+    /**
+     * CPUs the calling thread may run on.
+     */
+    inline auto get_current_thread_affinity() -> result<std::vector<size_t>>
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        auto cpus = std::vector<size_t>{};
+        auto res = ::sched_getaffinity(0, sizeof(set), &set);
+        if (res == 0)
+        {
+            for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    cpus.emplace_back(cpu);
+                }
+            }
+        }
+        return handle_system_error(res, std::move(cpus));
+    }
+
+    /**
+     * NUMA node backing the page that holds p, if the kernel can tell.
+     */
+    inline auto numa_node_of(void const * p) -> std::optional<size_t>
+    {
+        int node = -1;
+        auto res = ::syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void *>(p), MPOL_F_NODE | MPOL_F_ADDR);
+        if (res != 0 or node < 0)
+        {
+            return {};
+        }
+        return static_cast<size_t>(node);
+    }
+
+    /**
+     * Binds the pages of [p, p + size) to one NUMA node, see mbind(2).
+     * Pages already faulted in elsewhere stay where they are, so bind a
+     * mapping before touching it.
+     *
+     * \param p page-aligned start of the range
+     */
+    inline auto bind_to_numa_node(void * p, size_t size, size_t node) -> result<void>
+    {
+        constexpr auto bits_per_mask = sizeof(unsigned long) * 8;
+        if (node >= bits_per_mask)
+        {
+            return {get_system_error(EINVAL)};
+        }
+        unsigned long mask = 1ul << node;
+        return handle_system_error(static_cast<int>(::syscall(SYS_mbind, p, size, MPOL_BIND, &mask, bits_per_mask, 0)));
+    }
+
+    /**
+     * Prefers allocating memory for the calling thread from one NUMA node
+     * for the lifetime of the scope, then restores the thread's previous
+     * policy, e.g. one set by numactl.  Best effort: does nothing on kernels
+     * or containers without NUMA memory policy support.
+     */
+    class numa_preferred_scope final
+    {
+    private:
+        static constexpr size_t bits_per_mask = sizeof(unsigned long) * 8;
+        // Enough for the kernel's largest node count
+        static constexpr size_t num_mask_words = 16;
+        static constexpr size_t max_nodes = num_mask_words * bits_per_mask;
+
+        bool active_ = false;
+        int prev_mode_ = MPOL_DEFAULT;
+        unsigned long prev_mask_[num_mask_words] = {};
+    public:
+        numa_preferred_scope(size_t node)
+        {
+            if (node >= bits_per_mask)
+            {
+                return;
+            }
+            // Without the previous policy it can't be put back, leave it be
+            if (::syscall(SYS_get_mempolicy, &prev_mode_, prev_mask_, max_nodes, nullptr, 0) != 0)
+            {
+                return;
+            }
+            unsigned long mask = 1ul << node;
+            active_ = ::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, bits_per_mask) == 0;
+        }
+
+        numa_preferred_scope(numa_preferred_scope const &) = delete;
+        numa_preferred_scope(numa_preferred_scope &&) = delete;
+
+        ~numa_preferred_scope()
+        {
+            if (active_)
+            {
+                // The kernel reads one bit fewer than maxnode
+                ::syscall(SYS_set_mempolicy, prev_mode_, prev_mode_ == MPOL_DEFAULT ? nullptr : prev_mask_, prev_mode_ == MPOL_DEFAULT ? 0 : max_nodes + 1);
+            }
+        }
+
+        auto operator=(numa_preferred_scope const &) -> numa_preferred_scope & = delete;
+        auto operator=(numa_preferred_scope &&) -> numa_preferred_scope & = delete;
+
+        auto is_active() const -> bool { return active_; }
+    };
+}
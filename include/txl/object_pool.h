@@ -0,0 +1,391 @@
+#pragma once
+
+// Slab allocation for fixed-size objects such as tree and list nodes.
+// Objects of one type are carved out of page-sized slabs, so nodes built
+// together sit next to each other in memory instead of scattering across
+// the heap:
+//
+//   auto pool = txl::object_pool<node>{};
+//   auto n = pool.make(key, value);
+//   ...
+//   pool.destroy(n);
+//
+// Containers take a node policy instead, heap_nodes or slab_nodes:
+//
+//   auto t = txl::btree<int, int, txl::slab_nodes>{3};
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace txl
+{
+    /**
+     * Slab allocator for objects of type T.
+     *
+     * Slabs are page aligned, a whole number of pages, and hold as many
+     * objects as fit.  Freed objects go on an intrusive freelist threaded
+     * through their own storage and are handed out again, most recently
+     * freed first; fresh objects are taken from the newest slab in address
+     * order.  Slabs are returned to the heap when the pool is destroyed.
+     *
+     * Not thread safe, see shared_object_pool.
+     */
+    template<class T>
+    class object_pool final
+    {
+    public:
+        static constexpr size_t page_size = 4096;
+        static constexpr size_t default_slab_size = page_size;
+    private:
+        union slot
+        {
+            slot * next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        struct slab final
+        {
+            slab * prev;
+        };
+
+        static constexpr size_t slots_offset = (sizeof(slab) + alignof(slot) - 1) / alignof(slot) * alignof(slot);
+        static constexpr size_t slab_alignment = std::max(page_size, alignof(slot));
+
+        slab * slabs_ = nullptr;
+        slot * free_ = nullptr;
+        // Untouched slots of the newest slab
+        slot * next_ = nullptr;
+        slot * end_ = nullptr;
+        size_t slab_size_;
+        size_t num_slabs_ = 0;
+        size_t num_allocated_ = 0;
+
+        auto slots_per_slab() const -> size_t
+        {
+            return (slab_size_ - slots_offset) / sizeof(slot);
+        }
+
+        auto add_slab() -> void
+        {
+            auto s = static_cast<slab *>(::operator new(slab_size_, std::align_val_t{slab_alignment}));
+            s->prev = slabs_;
+            slabs_ = s;
+            ++num_slabs_;
+            next_ = reinterpret_cast<slot *>(reinterpret_cast<unsigned char *>(s) + slots_offset);
+            end_ = next_ + slots_per_slab();
+        }
+    public:
+        /**
+         * \param slab_size bytes per slab, rounded up to whole pages holding
+         *                  at least one object
+         */
+        object_pool(size_t slab_size = default_slab_size)
+            : slab_size_((std::max(slab_size, slots_offset + sizeof(slot)) + page_size - 1) / page_size * page_size)
+        {
+        }
+
+        object_pool(object_pool const &) = delete;
+        object_pool(object_pool &&) = delete;
+
+        /**
+         * Objects still allocated must already be destroyed.
+         */
+        ~object_pool()
+        {
+            while (slabs_)
+            {
+                ::operator delete(std::exchange(slabs_, slabs_->prev), std::align_val_t{slab_alignment});
+            }
+        }
+
+        auto operator=(object_pool const &) -> object_pool & = delete;
+        auto operator=(object_pool &&) -> object_pool & = delete;
+
+        /**
+         * Uninitialized storage for one T.
+         */
+        auto allocate() -> void *
+        {
+            ++num_allocated_;
+            if (free_)
+            {
+                return std::exchange(free_, free_->next);
+            }
+            if (next_ == end_)
+            {
+                add_slab();
+            }
+            return next_++;
+        }
+
+        auto deallocate(void * p) -> void
+        {
+            --num_allocated_;
+            free_ = ::new (p) slot{free_};
+        }
+
+        template<class... Args>
+        auto make(Args && ... args) -> T *
+        {
+            auto p = allocate();
+            try
+            {
+                return ::new (p) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(p);
+                throw;
+            }
+        }
+
+        auto destroy(T * p) -> void
+        {
+            p->~T();
+            deallocate(p);
+        }
+
+        auto num_allocated() const -> size_t { return num_allocated_; }
+        auto num_slabs() const -> size_t { return num_slabs_; }
+        auto slab_size() const -> size_t { return slab_size_; }
+        auto capacity() const -> size_t { return num_slabs_ * slots_per_slab(); }
+    };
+
+    /**
+     * Process wide object_pool per type, fronted by a magazine of free
+     * objects per thread.
+     *
+     * A thread allocates from and frees to its own magazine.  A thread that
+     * runs dry takes a batch of objects from the shared pool under its lock,
+     * and one whose magazine grows past its limit hands a batch back, so
+     * objects freed on another thread find their way back and the common
+     * allocate/free pair takes no lock.
+     *
+     * Slabs are never returned to the system.
+     */
+    template<class T>
+    class shared_object_pool final
+    {
+    public:
+        static constexpr size_t batch_size = 32;
+    private:
+        struct free_block final
+        {
+            free_block * next;
+        };
+
+        static_assert(sizeof(free_block) <= std::max(sizeof(T), sizeof(void *)));
+
+        struct depot final
+        {
+            std::mutex mut{};
+            object_pool<T> pool{};
+        };
+
+        struct magazine final
+        {
+            free_block * head = nullptr;
+            size_t count = 0;
+
+            magazine()
+            {
+                alive_ = true;
+            }
+
+            ~magazine()
+            {
+                alive_ = false;
+                auto & d = shared();
+                auto lock = std::unique_lock<std::mutex>{d.mut};
+                while (head)
+                {
+                    d.pool.deallocate(std::exchange(head, head->next));
+                }
+                count = 0;
+            }
+        };
+
+        static inline thread_local bool alive_ = false;
+
+        static auto shared() -> depot &
+        {
+            // Never destroyed, threads may return objects during static destruction
+            static auto d = new depot{};
+            return *d;
+        }
+
+        static auto local() -> magazine *
+        {
+            thread_local magazine m{};
+            return alive_ ? &m : nullptr;
+        }
+
+        static auto refill(magazine & m) -> void
+        {
+            auto & d = shared();
+            auto lock = std::unique_lock<std::mutex>{d.mut};
+            for (; m.count < batch_size; ++m.count)
+            {
+                m.head = ::new (d.pool.allocate()) free_block{m.head};
+            }
+        }
+
+        static auto flush(magazine & m) -> void
+        {
+            // Keep the most recently freed, still cache hot, objects
+            auto keep = m.head;
+            for (size_t i = 1; i < batch_size; ++i)
+            {
+                keep = keep->next;
+            }
+            auto rest = std::exchange(keep->next, nullptr);
+            m.count = batch_size;
+
+            auto & d = shared();
+            auto lock = std::unique_lock<std::mutex>{d.mut};
+            while (rest)
+            {
+                d.pool.deallocate(std::exchange(rest, rest->next));
+            }
+        }
+    public:
+        static auto allocate() -> void *
+        {
+            auto m = local();
+            if (not m)
+            {
+                // Thread is exiting, skip the magazine
+                auto & d = shared();
+                auto lock = std::unique_lock<std::mutex>{d.mut};
+                return d.pool.allocate();
+            }
+            if (not m->head)
+            {
+                refill(*m);
+            }
+            --m->count;
+            return std::exchange(m->head, m->head->next);
+        }
+
+        static auto deallocate(void * p) -> void
+        {
+            auto m = local();
+            if (not m)
+            {
+                auto & d = shared();
+                auto lock = std::unique_lock<std::mutex>{d.mut};
+                d.pool.deallocate(p);
+                return;
+            }
+            m->head = ::new (p) free_block{m->head};
+            ++m->count;
+            if (m->count >= 2 * batch_size)
+            {
+                flush(*m);
+            }
+        }
+
+        /**
+         * Number of free objects held by the calling thread's magazine.
+         */
+        static auto num_cached() -> size_t
+        {
+            auto m = local();
+            return m ? m->count : 0;
+        }
+    };
+
+    /**
+     * Node allocation policy allocating every node from the heap.
+     */
+    struct heap_nodes final
+    {
+        // Freed nodes go back to the heap and may be unmapped
+        static constexpr bool stable_memory = false;
+
+        template<class Node>
+        struct allocator final
+        {
+            static auto allocate() -> void * { return ::operator new(sizeof(Node)); }
+            static auto deallocate(void * p) -> void { ::operator delete(p); }
+        };
+    };
+
+    /**
+     * Node allocation policy carving nodes out of slabs through
+     * shared_object_pool, so nodes allocated together are adjacent.
+     */
+    struct slab_nodes final
+    {
+        // Slabs are never freed, a freed node stays readable
+        static constexpr bool stable_memory = true;
+
+        template<class Node>
+        using allocator = shared_object_pool<Node>;
+    };
+
+    /**
+     * Deleter for nodes allocated through a node policy, for use with
+     * std::unique_ptr.
+     */
+    template<class Node, class NodePolicy>
+    struct node_deleter final
+    {
+        auto operator()(Node * n) const -> void
+        {
+            n->~Node();
+            NodePolicy::template allocator<Node>::deallocate(n);
+        }
+    };
+
+    template<class Node, class NodePolicy>
+    using node_unique_ptr = std::unique_ptr<Node, node_deleter<Node, NodePolicy>>;
+
+    template<class Node, class NodePolicy, class... Args>
+    auto make_node(Args && ... args) -> node_unique_ptr<Node, NodePolicy>
+    {
+        using allocator = typename NodePolicy::template allocator<Node>;
+        auto p = allocator::allocate();
+        try
+        {
+            return node_unique_ptr<Node, NodePolicy>(::new (p) Node(std::forward<Args>(args)...));
+        }
+        catch (...)
+        {
+            allocator::deallocate(p);
+            throw;
+        }
+    }
+
+    /**
+     * Base class routing a type's heap allocations through
+     * shared_object_pool.  Allocations of other sizes, such as of a derived
+     * type, go to the global allocator.
+     */
+    template<class T>
+    struct object_pool_allocated
+    {
+        static auto operator new(size_t num_bytes) -> void *
+        {
+            if (num_bytes != sizeof(T))
+            {
+                return ::operator new(num_bytes);
+            }
+            return shared_object_pool<T>::allocate();
+        }
+
+        static auto operator delete(void * p, size_t num_bytes) -> void
+        {
+            if (num_bytes != sizeof(T))
+            {
+                ::operator delete(p);
+                return;
+            }
+            shared_object_pool<T>::deallocate(p);
+        }
+    };
+}
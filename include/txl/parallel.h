@@ -0,0 +1,425 @@
+#pragma once
+
+// Fork-join parallel algorithms on top of thread_pool
+
+#include <txl/array_view.h>
+#include <txl/futex.h>
+#include <txl/threading.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace txl
+{
+    /**
+     * Set of jobs spawned on a thread_pool that can be joined.
+     *
+     * Waiting helps run queued pool work rather than blocking, so a group
+     * may be waited on from inside a pool job without starving the pool.
+     * The first exception thrown by a job is rethrown from wait().
+     */
+    class parallel_group final
+    {
+    private:
+        thread_pool & pool_;
+        std::atomic<size_t> pending_{0};
+        std::mutex error_mut_{};
+        std::exception_ptr error_{};
+
+        auto set_error(std::exception_ptr && e) -> void
+        {
+            auto lock = std::unique_lock<std::mutex>{error_mut_};
+            if (not error_)
+            {
+                error_ = std::move(e);
+            }
+        }
+    public:
+        parallel_group(thread_pool & pool)
+            : pool_(pool)
+        {
+        }
+
+        parallel_group(parallel_group const &) = delete;
+        parallel_group(parallel_group &&) = delete;
+
+        ~parallel_group()
+        {
+            // Jobs reference the group, never let them outlive it
+            wait_no_throw();
+        }
+
+        auto operator=(parallel_group const &) -> parallel_group & = delete;
+        auto operator=(parallel_group &&) -> parallel_group & = delete;
+
+        auto pool() -> thread_pool & { return pool_; }
+
+        /**
+         * Posts func to the pool as part of this group.  Runs it on the
+         * calling thread if the pool will not accept it.
+         */
+        template<class Func>
+        auto spawn(Func && func) -> void
+        {
+            pending_.fetch_add(1, std::memory_order_acq_rel);
+            auto job = make_thread_pool_lambda([this, func=std::forward<Func>(func)]() mutable {
+                try
+                {
+                    func();
+                }
+                catch (...)
+                {
+                    set_error(std::current_exception());
+                }
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            });
+
+            if (not pool_.post_work(std::move(job)))
+            {
+                // Rejected work is left with us
+                job->execute();
+            }
+        }
+
+        /**
+         * Waits for every spawned job, running pool work in the meantime.
+         */
+        auto wait_no_throw() -> void
+        {
+            size_t num_idle = 0;
+            while (pending_.load(std::memory_order_acquire) > 0)
+            {
+                if (pool_.try_run_one())
+                {
+                    num_idle = 0;
+                }
+                else if (++num_idle < 64)
+                {
+                    cpu_relax();
+                }
+                else
+                {
+                    // Our jobs are running elsewhere
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        auto wait() -> void
+        {
+            wait_no_throw();
+            auto lock = std::unique_lock<std::mutex>{error_mut_};
+            if (error_)
+            {
+                std::rethrow_exception(std::exchange(error_, nullptr));
+            }
+        }
+    };
+
+    namespace detail
+    {
+        // Enough chunks per thread to rebalance when chunks are uneven
+        inline constexpr size_t parallel_chunks_per_thread = 8;
+
+        inline auto auto_grain(thread_pool const & pool, size_t num_items) -> size_t
+        {
+            auto num_chunks = std::max<size_t>(1, pool.num_threads() * parallel_chunks_per_thread);
+            return std::max<size_t>(1, (num_items + num_chunks - 1) / num_chunks);
+        }
+
+        /**
+         * Calls func(chunk_index) for every chunk in [first, last), halving
+         * the range and handing the upper half to the pool until a single
+         * chunk remains.
+         */
+        template<class Func>
+        auto split_chunks(parallel_group & g, size_t first, size_t last, Func const & func) -> void
+        {
+            while (last - first > 1)
+            {
+                auto mid = first + (last - first) / 2;
+                g.spawn([&g, mid, last, &func]() {
+                    split_chunks(g, mid, last, func);
+                });
+                last = mid;
+            }
+            func(first);
+        }
+
+        /**
+         * Runs func(chunk_index, begin, end) over [0, num_items) split into
+         * chunks of at most grain items.  Returns once every chunk has run.
+         */
+        template<class Func>
+        auto for_each_chunk(thread_pool & pool, size_t num_items, size_t grain, Func const & func) -> void
+        {
+            if (num_items == 0)
+            {
+                return;
+            }
+            auto num_chunks = (num_items + grain - 1) / grain;
+            auto chunk = [num_items, grain, &func](size_t index) {
+                auto begin = index * grain;
+                func(index, begin, std::min(begin + grain, num_items));
+            };
+            if (num_chunks == 1)
+            {
+                chunk(0);
+                return;
+            }
+
+            auto g = parallel_group{pool};
+            try
+            {
+                split_chunks(g, 0, num_chunks, chunk);
+            }
+            catch (...)
+            {
+                g.wait_no_throw();
+                throw;
+            }
+            g.wait();
+        }
+
+        /**
+         * Merges two sorted runs into out, moving the values.  The larger
+         * run is split at its middle value, whose place in the other run is
+         * found by binary search; the upper halves are handed to the pool
+         * until both runs together fit in grain.
+         */
+        template<class InIt, class OutIt, class Compare>
+        auto parallel_merge(parallel_group & g, InIt first1, InIt last1, InIt first2, InIt last2, OutIt out, Compare const & comp, size_t grain) -> void
+        {
+            while (true)
+            {
+                auto n1 = static_cast<size_t>(std::distance(first1, last1));
+                auto n2 = static_cast<size_t>(std::distance(first2, last2));
+                if (n1 + n2 <= grain)
+                {
+                    std::merge(std::make_move_iterator(first1), std::make_move_iterator(last1),
+                               std::make_move_iterator(first2), std::make_move_iterator(last2), out, comp);
+                    return;
+                }
+                if (n1 < n2)
+                {
+                    std::swap(first1, first2);
+                    std::swap(last1, last2);
+                    std::swap(n1, n2);
+                }
+
+                // Everything before the split sorts no later than *mid1,
+                // everything after no earlier
+                auto mid1 = std::next(first1, n1 / 2);
+                auto mid2 = std::lower_bound(first2, last2, *mid1, comp);
+                auto out_mid = std::next(out, std::distance(first1, mid1) + std::distance(first2, mid2));
+                *out_mid = std::move(*mid1);
+                g.spawn([&g, first1=std::next(mid1), last1, mid2, last2, out=std::next(out_mid), &comp, grain]() {
+                    parallel_merge(g, first1, last1, mid2, last2, out, comp, grain);
+                });
+                last1 = mid1;
+                last2 = mid2;
+            }
+        }
+    }
+
+    /**
+     * Calls func(value) for each element of a random access range.
+     *
+     * \param pool pool to run on
+     * \param first start of range
+     * \param last end of range
+     * \param func function of type: (value &) -> void
+     * \param grain elements per job, picked from the range size and pool size if zero
+     */
+    template<class RandomIt, class Func, class = std::enable_if_t<not std::is_integral_v<RandomIt>>>
+    auto parallel_for(thread_pool & pool, RandomIt first, RandomIt last, Func && func, size_t grain = 0) -> void
+    {
+        auto num_items = static_cast<size_t>(std::distance(first, last));
+        grain = grain ? grain : detail::auto_grain(pool, num_items);
+        detail::for_each_chunk(pool, num_items, grain, [first, &func](size_t, size_t begin, size_t end) {
+            for (auto it = std::next(first, begin); it != std::next(first, end); ++it)
+            {
+                func(*it);
+            }
+        });
+    }
+
+    /**
+     * Calls func(index) for each index in [first, last).
+     */
+    template<class Index, class Func, std::enable_if_t<std::is_integral_v<Index>, int> = 0>
+    auto parallel_for(thread_pool & pool, Index first, Index last, Func && func, size_t grain = 0) -> void
+    {
+        auto num_items = last > first ? static_cast<size_t>(last - first) : 0;
+        grain = grain ? grain : detail::auto_grain(pool, num_items);
+        detail::for_each_chunk(pool, num_items, grain, [first, &func](size_t, size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i)
+            {
+                func(static_cast<Index>(first + static_cast<Index>(i)));
+            }
+        });
+    }
+
+    template<class Value, class Func>
+    auto parallel_for(thread_pool & pool, array_view<Value> view, Func && func, size_t grain = 0) -> void
+    {
+        parallel_for(pool, view.begin(), view.end(), std::forward<Func>(func), grain);
+    }
+
+    /**
+     * Folds a random access range with an associative operation.  Chunks are
+     * reduced in parallel and their results combined in order, so op need
+     * not be commutative.
+     *
+     * \param init identity value of op
+     * \param op function of type: (T, value) -> T, also used to combine chunk results
+     */
+    template<class RandomIt, class T, class BinaryOp = std::plus<>>
+    auto parallel_reduce(thread_pool & pool, RandomIt first, RandomIt last, T init, BinaryOp && op = {}, size_t grain = 0) -> T
+    {
+        auto num_items = static_cast<size_t>(std::distance(first, last));
+        grain = grain ? grain : detail::auto_grain(pool, num_items);
+        auto partials = std::vector<T>((num_items + grain - 1) / grain, init);
+        detail::for_each_chunk(pool, num_items, grain, [first, &op, &partials](size_t index, size_t begin, size_t end) {
+            auto res = partials[index];
+            for (auto it = std::next(first, begin); it != std::next(first, end); ++it)
+            {
+                res = op(std::move(res), *it);
+            }
+            partials[index] = std::move(res);
+        });
+
+        auto res = std::move(init);
+        for (auto & p : partials)
+        {
+            res = op(std::move(res), std::move(p));
+        }
+        return res;
+    }
+
+    template<class Value, class T, class BinaryOp = std::plus<>>
+    auto parallel_reduce(thread_pool & pool, array_view<Value> view, T init, BinaryOp && op = {}, size_t grain = 0) -> T
+    {
+        return parallel_reduce(pool, view.begin(), view.end(), std::move(init), std::forward<BinaryOp>(op), grain);
+    }
+
+    /**
+     * Writes op(value) for each element of [first, last) to the range
+     * starting at out.
+     *
+     * \return end of the output range
+     */
+    template<class RandomIt, class OutputIt, class UnaryOp>
+    auto parallel_transform(thread_pool & pool, RandomIt first, RandomIt last, OutputIt out, UnaryOp && op, size_t grain = 0) -> OutputIt
+    {
+        auto num_items = static_cast<size_t>(std::distance(first, last));
+        grain = grain ? grain : detail::auto_grain(pool, num_items);
+        detail::for_each_chunk(pool, num_items, grain, [first, out, &op](size_t, size_t begin, size_t end) {
+            auto dst = std::next(out, begin);
+            for (auto it = std::next(first, begin); it != std::next(first, end); ++it, ++dst)
+            {
+                *dst = op(*it);
+            }
+        });
+        return std::next(out, num_items);
+    }
+
+    template<class Value, class OutputValue, class UnaryOp>
+    auto parallel_transform(thread_pool & pool, array_view<Value> in, array_view<OutputValue> out, UnaryOp && op, size_t grain = 0) -> void
+    {
+        parallel_transform(pool, in.begin(), in.begin() + std::min(in.size(), out.size()), out.begin(), std::forward<UnaryOp>(op), grain);
+    }
+
+    /**
+     * Sorts a random access range.  Chunks are sorted in parallel, then
+     * merged pairwise in rounds, each merge itself split across the pool so
+     * the last round is as parallel as the first.  Merging goes back and
+     * forth through a buffer the size of the range, so values must be
+     * default constructible for this; other values are merged in place one
+     * pair per job, which leaves the final merge on a single thread.  Not
+     * stable.
+     */
+    template<class RandomIt, class Compare = std::less<>>
+    auto parallel_sort(thread_pool & pool, RandomIt first, RandomIt last, Compare && comp = {}, size_t grain = 0) -> void
+    {
+        using value_type = typename std::iterator_traits<RandomIt>::value_type;
+
+        auto num_items = static_cast<size_t>(std::distance(first, last));
+        grain = grain ? grain : detail::auto_grain(pool, num_items);
+        detail::for_each_chunk(pool, num_items, grain, [first, &comp](size_t, size_t begin, size_t end) {
+            std::sort(std::next(first, begin), std::next(first, end), comp);
+        });
+        if (grain >= num_items)
+        {
+            return;
+        }
+
+        if constexpr (std::is_default_constructible_v<value_type>)
+        {
+            auto buffer = std::vector<value_type>(num_items);
+            // Each round merges neighbouring runs of width items from src
+            // into dst
+            auto merge_round = [&pool, num_items, grain, &comp](auto src, auto dst, size_t width) {
+                auto g = parallel_group{pool};
+                for (size_t begin = 0; begin < num_items; begin += 2 * width)
+                {
+                    auto mid = std::min(begin + width, num_items);
+                    auto end = std::min(begin + 2 * width, num_items);
+                    g.spawn([&g, src, dst, begin, mid, end, &comp, grain]() {
+                        detail::parallel_merge(g, std::next(src, begin), std::next(src, mid), std::next(src, mid), std::next(src, end), std::next(dst, begin), comp, grain);
+                    });
+                }
+                g.wait();
+            };
+
+            auto in_buffer = false;
+            for (auto width = grain; width < num_items; width *= 2)
+            {
+                if (in_buffer)
+                {
+                    merge_round(buffer.begin(), first, width);
+                }
+                else
+                {
+                    merge_round(first, buffer.begin(), width);
+                }
+                in_buffer = not in_buffer;
+            }
+            if (in_buffer)
+            {
+                auto src = buffer.begin();
+                detail::for_each_chunk(pool, num_items, grain, [src, first](size_t, size_t begin, size_t end) {
+                    std::move(std::next(src, begin), std::next(src, end), std::next(first, begin));
+                });
+            }
+        }
+        else
+        {
+            // Each round merges neighbouring runs of width items
+            for (auto width = grain; width < num_items; width *= 2)
+            {
+                auto num_merges = (num_items + 2 * width - 1) / (2 * width);
+                detail::for_each_chunk(pool, num_merges, 1, [first, num_items, width, &comp](size_t index, size_t, size_t) {
+                    auto begin = index * 2 * width;
+                    auto mid = std::min(begin + width, num_items);
+                    auto end = std::min(begin + 2 * width, num_items);
+                    std::inplace_merge(std::next(first, begin), std::next(first, mid), std::next(first, end), comp);
+                });
+            }
+        }
+    }
+
+    template<class Value, class Compare = std::less<>>
+    auto parallel_sort(thread_pool & pool, array_view<Value> view, Compare && comp = {}, size_t grain = 0) -> void
+    {
+        parallel_sort(pool, view.begin(), view.end(), std::forward<Compare>(comp), grain);
+    }
+}
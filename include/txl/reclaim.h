@@ -0,0 +1,630 @@
+#pragma once
+
+// Safe memory reclamation for lock-free structures.
+//
+// A lock-free structure can't free a node as soon as it unlinks it, another
+// thread may have loaded the pointer just before and is about to read it.
+// Reclaimers defer the free until no thread can still hold the pointer:
+//
+//   typename Reclaimer::guard g{};
+//   auto p = g.protect(head_);           // safe to dereference while g lives
+//   ... unlink p ...
+//   Reclaimer::retire(p);                // freed once no guard can see it
+//
+// epoch_reclaimer makes a guard cheap and frees in bulk, hazard_reclaimer
+// bounds the memory held back by a stalled thread, immediate_reclaimer
+// frees straight away for nodes that are never unmapped.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace txl
+{
+    namespace detail
+    {
+        struct retired_ptr final
+        {
+            void * ptr;
+            void (*deleter)(void *);
+            uint64_t epoch;
+        };
+
+        template<class T>
+        auto delete_retired(void * p) -> void
+        {
+            delete static_cast<T *>(p);
+        }
+
+        /**
+         * Append-only lock-free list of per-thread records.  Records are
+         * never freed, a thread gives its record back when it exits and the
+         * next thread claims it.
+         */
+        template<class Record>
+        class record_registry final
+        {
+        private:
+            std::atomic<Record *> head_{nullptr};
+        public:
+            auto acquire() -> Record &
+            {
+                for (auto r = head_.load(std::memory_order_acquire); r; r = r->next)
+                {
+                    auto in_use = false;
+                    if (not r->in_use.load(std::memory_order_relaxed) and r->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire))
+                    {
+                        return *r;
+                    }
+                }
+
+                auto r = new Record{};
+                r->in_use.store(true, std::memory_order_relaxed);
+                r->next = head_.load(std::memory_order_relaxed);
+                while (not head_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+                {
+                }
+                return *r;
+            }
+
+            static auto release(Record & r) -> void
+            {
+                r.in_use.store(false, std::memory_order_release);
+            }
+
+            template<class Func>
+            auto for_each(Func && func) const -> void
+            {
+                for (auto r = head_.load(std::memory_order_acquire); r; r = r->next)
+                {
+                    if (r->in_use.load(std::memory_order_acquire))
+                    {
+                        func(*r);
+                    }
+                }
+            }
+
+            auto size() const -> size_t
+            {
+                size_t res = 0;
+                for (auto r = head_.load(std::memory_order_acquire); r; r = r->next)
+                {
+                    ++res;
+                }
+                return res;
+            }
+        };
+
+        /**
+         * Pointers retired by threads that exited before they could be
+         * freed, adopted by whichever thread collects next.
+         */
+        class orphan_list final
+        {
+        private:
+            std::mutex mut_{};
+            std::vector<retired_ptr> ptrs_{};
+        public:
+            auto adopt(std::vector<retired_ptr> & ptrs) -> void
+            {
+                if (ptrs.empty())
+                {
+                    return;
+                }
+                auto lock = std::unique_lock<std::mutex>{mut_};
+                ptrs_.insert(ptrs_.end(), ptrs.begin(), ptrs.end());
+                ptrs.clear();
+            }
+
+            /**
+             * Moves the orphans into ptrs unless another thread is already
+             * doing so.
+             */
+            auto try_take(std::vector<retired_ptr> & ptrs) -> void
+            {
+                auto lock = std::unique_lock<std::mutex>{mut_, std::try_to_lock};
+                if (lock and not ptrs_.empty())
+                {
+                    ptrs.insert(ptrs.end(), ptrs_.begin(), ptrs_.end());
+                    ptrs_.clear();
+                }
+            }
+        };
+
+        /**
+         * Frees every retired pointer can_free accepts, keeping the rest.
+         *
+         * \return number of pointers freed
+         */
+        template<class CanFree>
+        auto free_retired(std::vector<retired_ptr> & ptrs, CanFree && can_free) -> size_t
+        {
+            auto kept = std::stable_partition(ptrs.begin(), ptrs.end(), [&](retired_ptr const & r) {
+                return not can_free(r);
+            });
+            auto num_freed = static_cast<size_t>(std::distance(kept, ptrs.end()));
+            auto freed = std::vector<retired_ptr>(kept, ptrs.end());
+            ptrs.erase(kept, ptrs.end());
+            // Deleters may retire more pointers, so run them last
+            for (auto & r : freed)
+            {
+                r.deleter(r.ptr);
+            }
+            return num_freed;
+        }
+    }
+
+    /**
+     * Epoch-based reclamation.
+     *
+     * A guard announces the global epoch its thread entered at.  The epoch
+     * only advances once every thread inside a guard has seen the current
+     * one, so a pointer retired during epoch e is unreachable by the time
+     * the epoch reaches e + 2.
+     *
+     * Guards nest and cost a store and a fence, but one thread stalled
+     * inside a guard holds back every retired pointer.
+     */
+    class epoch_reclaimer final
+    {
+    public:
+        // Retired pointers a thread collects after
+        static constexpr size_t collect_threshold = 64;
+    private:
+        static constexpr uint64_t quiescent = UINT64_MAX;
+
+        struct record final
+        {
+            std::atomic<uint64_t> epoch{quiescent};
+            std::atomic<bool> in_use{false};
+            record * next = nullptr;
+        };
+
+        struct thread_state final
+        {
+            record * rec = nullptr;
+            size_t depth = 0;
+            std::vector<detail::retired_ptr> retired{};
+
+            ~thread_state()
+            {
+                alive() = false;
+                collect(*this);
+                orphans().adopt(retired);
+                if (rec)
+                {
+                    registry().release(*rec);
+                }
+            }
+        };
+
+        static auto global_epoch() -> std::atomic<uint64_t> &
+        {
+            static std::atomic<uint64_t> epoch{0};
+            return epoch;
+        }
+
+        static auto registry() -> detail::record_registry<record> &
+        {
+            static detail::record_registry<record> r{};
+            return r;
+        }
+
+        static auto orphans() -> detail::orphan_list &
+        {
+            // Leaked so threads exiting during static destruction can use it
+            static auto o = new detail::orphan_list{};
+            return *o;
+        }
+
+        static auto alive() -> bool &
+        {
+            static thread_local bool alive = true;
+            return alive;
+        }
+
+        static auto local() -> thread_state *
+        {
+            static thread_local thread_state state{};
+            return alive() ? &state : nullptr;
+        }
+
+        static auto enter(record & r) -> void
+        {
+            r.epoch.store(global_epoch().load(std::memory_order_relaxed), std::memory_order_relaxed);
+            // Announce the epoch before reading any shared pointer
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        static auto exit(record & r) -> void
+        {
+            r.epoch.store(quiescent, std::memory_order_release);
+        }
+
+        static auto try_advance() -> uint64_t
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto e = global_epoch().load(std::memory_order_acquire);
+            auto lagging = false;
+            registry().for_each([&](record const & r) {
+                auto re = r.epoch.load(std::memory_order_acquire);
+                lagging = lagging or (re != quiescent and re != e);
+            });
+            if (not lagging)
+            {
+                // Losing the race means someone else advanced it
+                global_epoch().compare_exchange_strong(e, e + 1, std::memory_order_acq_rel);
+                e = global_epoch().load(std::memory_order_acquire);
+            }
+            return e;
+        }
+
+        static auto collect(thread_state & s) -> size_t
+        {
+            orphans().try_take(s.retired);
+            auto e = try_advance();
+            return detail::free_retired(s.retired, [e](detail::retired_ptr const & r) {
+                return r.epoch + 2 <= e;
+            });
+        }
+    public:
+        class guard final
+        {
+        private:
+            record * owned_ = nullptr;
+        public:
+            guard()
+            {
+                auto s = local();
+                if (not s)
+                {
+                    // Thread is exiting, borrow a record for our lifetime
+                    owned_ = &registry().acquire();
+                    enter(*owned_);
+                    return;
+                }
+                if (not s->rec)
+                {
+                    s->rec = &registry().acquire();
+                }
+                if (s->depth++ == 0)
+                {
+                    enter(*s->rec);
+                }
+            }
+
+            guard(guard const &) = delete;
+            guard(guard &&) = delete;
+
+            ~guard()
+            {
+                if (owned_)
+                {
+                    exit(*owned_);
+                    registry().release(*owned_);
+                    return;
+                }
+                auto s = local();
+                if (s and --s->depth == 0)
+                {
+                    exit(*s->rec);
+                }
+            }
+
+            auto operator=(guard const &) -> guard & = delete;
+            auto operator=(guard &&) -> guard & = delete;
+
+            /**
+             * Loads a value holding a pointer that stays valid for the life
+             * of the guard.
+             *
+             * \param load function of type: () -> V
+             * \param proj function of type: (V const &) -> T *, unused here
+             */
+            template<class Load, class Proj>
+            auto protect(Load && load, Proj &&) -> decltype(load())
+            {
+                return load();
+            }
+
+            template<class T>
+            auto protect(std::atomic<T *> const & src) -> T *
+            {
+                return src.load(std::memory_order_acquire);
+            }
+
+            auto reset() -> void {}
+        };
+
+        /**
+         * Frees p with deleter once no guard can still see it.  Call after p
+         * is unlinked.
+         */
+        static auto retire(void * p, void (*deleter)(void *)) -> void
+        {
+            auto s = local();
+            auto r = detail::retired_ptr{p, deleter, global_epoch().load(std::memory_order_acquire)};
+            if (not s)
+            {
+                auto ptrs = std::vector<detail::retired_ptr>{r};
+                orphans().adopt(ptrs);
+                return;
+            }
+            s->retired.emplace_back(r);
+            if (s->retired.size() >= collect_threshold)
+            {
+                collect(*s);
+            }
+        }
+
+        template<class T>
+        static auto retire(T * p) -> void
+        {
+            retire(p, &detail::delete_retired<T>);
+        }
+
+        /**
+         * Tries to advance the epoch and frees what the calling thread
+         * retired that is no longer reachable.
+         *
+         * \return number of pointers freed
+         */
+        static auto collect() -> size_t
+        {
+            auto s = local();
+            return s ? collect(*s) : 0;
+        }
+
+        /**
+         * Pointers retired by the calling thread and not yet freed.
+         */
+        static auto num_retired() -> size_t
+        {
+            auto s = local();
+            return s ? s->retired.size() : 0;
+        }
+    };
+
+    /**
+     * Hazard pointer reclamation.
+     *
+     * A guard publishes the one pointer it protects, and a retired pointer
+     * is freed once no guard publishes it.  Protecting costs a fence and a
+     * re-load per pointer, but a stalled thread holds back only what its
+     * guards protect.
+     */
+    class hazard_reclaimer final
+    {
+    public:
+        // Retired pointers a thread scans the hazards after, on top of one
+        // per hazard so every scan frees at least half of them
+        static constexpr size_t collect_threshold = 64;
+    private:
+        struct record final
+        {
+            std::atomic<void *> ptr{nullptr};
+            std::atomic<bool> in_use{false};
+            record * next = nullptr;
+        };
+
+        struct thread_state final
+        {
+            std::vector<record *> free_records{};
+            std::vector<detail::retired_ptr> retired{};
+
+            ~thread_state()
+            {
+                alive() = false;
+                collect(*this);
+                orphans().adopt(retired);
+                for (auto r : free_records)
+                {
+                    registry().release(*r);
+                }
+            }
+        };
+
+        static auto registry() -> detail::record_registry<record> &
+        {
+            static detail::record_registry<record> r{};
+            return r;
+        }
+
+        static auto orphans() -> detail::orphan_list &
+        {
+            // Leaked so threads exiting during static destruction can use it
+            static auto o = new detail::orphan_list{};
+            return *o;
+        }
+
+        static auto alive() -> bool &
+        {
+            static thread_local bool alive = true;
+            return alive;
+        }
+
+        static auto local() -> thread_state *
+        {
+            static thread_local thread_state state{};
+            return alive() ? &state : nullptr;
+        }
+
+        static auto collect(thread_state & s) -> size_t
+        {
+            orphans().try_take(s.retired);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto hazards = std::vector<void *>{};
+            registry().for_each([&](record const & r) {
+                if (auto p = r.ptr.load(std::memory_order_acquire); p)
+                {
+                    hazards.emplace_back(p);
+                }
+            });
+            std::sort(hazards.begin(), hazards.end());
+            return detail::free_retired(s.retired, [&](detail::retired_ptr const & r) {
+                return not std::binary_search(hazards.begin(), hazards.end(), r.ptr);
+            });
+        }
+    public:
+        class guard final
+        {
+        private:
+            record * rec_;
+        public:
+            guard()
+            {
+                auto s = local();
+                if (s and not s->free_records.empty())
+                {
+                    rec_ = s->free_records.back();
+                    s->free_records.pop_back();
+                }
+                else
+                {
+                    rec_ = &registry().acquire();
+                }
+            }
+
+            guard(guard const &) = delete;
+            guard(guard &&) = delete;
+
+            ~guard()
+            {
+                reset();
+                if (auto s = local(); s)
+                {
+                    s->free_records.emplace_back(rec_);
+                }
+                else
+                {
+                    registry().release(*rec_);
+                }
+            }
+
+            auto operator=(guard const &) -> guard & = delete;
+            auto operator=(guard &&) -> guard & = delete;
+
+            /**
+             * Loads a value holding a pointer and publishes the pointer,
+             * re-loading until the published pointer is still current.  The
+             * pointer stays valid until the guard protects another one.
+             *
+             * \param load function of type: () -> V
+             * \param proj function of type: (V const &) -> T *
+             */
+            template<class Load, class Proj>
+            auto protect(Load && load, Proj && proj) -> decltype(load())
+            {
+                auto v = load();
+                while (true)
+                {
+                    void * p = proj(v);
+                    rec_->ptr.store(p, std::memory_order_relaxed);
+                    // Publish before re-checking the source
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    auto current = load();
+                    if (static_cast<void *>(proj(current)) == p)
+                    {
+                        return current;
+                    }
+                    v = current;
+                }
+            }
+
+            template<class T>
+            auto protect(std::atomic<T *> const & src) -> T *
+            {
+                return protect([&src]() { return src.load(std::memory_order_acquire); }, [](T * p) { return p; });
+            }
+
+            auto reset() -> void
+            {
+                rec_->ptr.store(nullptr, std::memory_order_release);
+            }
+        };
+
+        static auto retire(void * p, void (*deleter)(void *)) -> void
+        {
+            auto s = local();
+            auto r = detail::retired_ptr{p, deleter, 0};
+            if (not s)
+            {
+                auto ptrs = std::vector<detail::retired_ptr>{r};
+                orphans().adopt(ptrs);
+                return;
+            }
+            s->retired.emplace_back(r);
+            if (s->retired.size() >= collect_threshold + registry().size())
+            {
+                collect(*s);
+            }
+        }
+
+        template<class T>
+        static auto retire(T * p) -> void
+        {
+            retire(p, &detail::delete_retired<T>);
+        }
+
+        /**
+         * Frees what the calling thread retired that no guard protects.
+         *
+         * \return number of pointers freed
+         */
+        static auto collect() -> size_t
+        {
+            auto s = local();
+            return s ? collect(*s) : 0;
+        }
+
+        static auto num_retired() -> size_t
+        {
+            auto s = local();
+            return s ? s->retired.size() : 0;
+        }
+    };
+
+    /**
+     * Frees on retire.  Only safe for nodes whose memory is never returned
+     * to the system, such as pooled_nodes, where a stale read is caught by
+     * a generation counter rather than faulting.
+     */
+    class immediate_reclaimer final
+    {
+    public:
+        class guard final
+        {
+        public:
+            template<class Load, class Proj>
+            auto protect(Load && load, Proj &&) -> decltype(load())
+            {
+                return load();
+            }
+
+            template<class T>
+            auto protect(std::atomic<T *> const & src) -> T *
+            {
+                return src.load(std::memory_order_acquire);
+            }
+
+            auto reset() -> void {}
+        };
+
+        static auto retire(void * p, void (*deleter)(void *)) -> void
+        {
+            deleter(p);
+        }
+
+        template<class T>
+        static auto retire(T * p) -> void
+        {
+            delete p;
+        }
+
+        static auto collect() -> size_t { return 0; }
+        static auto num_retired() -> size_t { return 0; }
+    };
+}
@@ -1,20 +1,29 @@
 #pragma once
 
+#include <txl/linked_list.h>
+#include <txl/reclaim.h>
+#include <txl/telemetry.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <mutex>
 #include <optional>
 #include <memory>
-#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace txl
 {
     // Forward declaration
-    template<class Value, class Factory>
+    template<class Value, class Factory, class Recycler>
     class resource_pool;
 
     template<class Value>
     class resource final
     {
-        template<class V, class F>
+        template<class V, class F, class R>
         friend class resource_pool;
     private:
         std::unique_ptr<Value> data_;
@@ -30,7 +39,7 @@ namespace txl
 
         resource & operator=(resource const &) = delete;
         resource & operator=(resource &&) = default;
-        
+
         Value & operator*() { return *data_; }
         Value * operator->() { return data_.operator->(); }
         Value const & operator*() const { return *data_; }
@@ -52,21 +61,178 @@ namespace txl
         }
     };
 
-    template<class Value, class Factory = resource_factory<Value>>
+    /**
+     * Decides whether a returned resource goes back into the pool, and
+     * resets it if so.  The default keeps everything as is.
+     */
+    template<class Value>
+    struct resource_recycler
+    {
+        bool operator()(Value &) const
+        {
+            return true;
+        }
+    };
+
+    struct resource_pool_options final
+    {
+        // Resources created up front, spread over the shards
+        size_t init_size = 0;
+        // Threads creating the initial resources, only used with
+        // concurrent_factory
+        size_t num_init_threads = 1;
+        // Call the factory from several threads at once instead of one at a
+        // time under a mutex; only for factories that are thread safe
+        bool concurrent_factory = false;
+        // Bound on idle resources kept across all shards, the rest are
+        // destroyed when put back
+        size_t max_retained = std::numeric_limits<size_t>::max();
+        // Number of idle resource queues, rounded up to a power of two;
+        // zero gives one per hardware thread
+        size_t num_shards = 0;
+    };
+
+    struct resource_pool_stats final
+    {
+        // get() served from the pool
+        uint64_t hits = 0;
+        // get() that had to call the factory
+        uint64_t misses = 0;
+        // Resources the factory produced, including the initial ones
+        uint64_t creations = 0;
+        // Resources destroyed on put(), rejected by the recycler or over
+        // max_retained
+        uint64_t discards = 0;
+        // Idle resources when sampled
+        size_t num_retained = 0;
+    };
+
+    /**
+     * Pool of reusable resources such as connections or parse buffers.
+     *
+     * Idle resources sit in lock-free stacks, one per shard; a thread gets
+     * from and puts to its own shard, taking from the others only when its
+     * own is empty, so under contention threads rarely touch the same
+     * stack, and the most recently used, cache-warm resource is reused
+     * first.  The factory is called under a mutex unless the options say it
+     * is thread safe.
+     *
+     * \tparam Factory function of type: () -> std::unique_ptr<Value>, may
+     *                 return nullptr when no more resources can be made
+     * \tparam Recycler function of type: (Value &) -> bool, called on put()
+     *                  to reset a resource or reject it
+     */
+    template<class Value, class Factory = resource_factory<Value>, class Recycler = resource_recycler<Value>>
     class resource_pool
     {
     private:
+        struct alignas(64) shard final
+        {
+            atomic_linked_list<Value *, pooled_nodes, immediate_reclaimer> ready{};
+            telemetry_counter num_hits{};
+            telemetry_counter num_misses{};
+            telemetry_counter num_creations{};
+            telemetry_counter num_discards{};
+
+            ~shard()
+            {
+                ready.release([](Value * v) { delete v; });
+            }
+
+            std::unique_ptr<Value> try_pop()
+            {
+                auto v = ready.pop_and_release_front();
+                return std::unique_ptr<Value>(v ? *v : nullptr);
+            }
+        };
+
         Factory factory_;
-        std::queue<resource<Value>> ready_;
-        std::mutex lock_;
+        Recycler recycler_;
+        std::mutex factory_lock_;
+        std::vector<std::unique_ptr<shard>> shards_;
+        size_t shard_mask_;
+        size_t max_retained_;
+        bool concurrent_factory_;
+        // Idle resources in all shards, counted before they are pushed
+        alignas(64) std::atomic<size_t> num_retained_{0};
+
+        static size_t thread_index()
+        {
+            static std::atomic<size_t> next_index{0};
+            static thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        static size_t round_up_pow2(size_t n)
+        {
+            size_t res = 1;
+            while (res < n)
+            {
+                res <<= 1;
+            }
+            return res;
+        }
+
+        std::unique_ptr<Value> create()
+        {
+            if (concurrent_factory_)
+            {
+                return factory_();
+            }
+            std::unique_lock<std::mutex> lock(factory_lock_);
+            return factory_();
+        }
+
+        /**
+         * Keeps v in s unless max_retained idle resources are already kept.
+         */
+        bool retain(shard & s, std::unique_ptr<Value> & v)
+        {
+            if (num_retained_.fetch_add(1, std::memory_order_relaxed) >= max_retained_)
+            {
+                num_retained_.fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            s.ready.push_front(v.release());
+            return true;
+        }
+
+        void create_into(size_t first_shard, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto & s = *shards_[(first_shard + i) & shard_mask_];
+                auto v = create();
+                if (not v)
+                {
+                    return;
+                }
+                s.num_creations.add();
+                if (not retain(s, v))
+                {
+                    s.num_discards.add();
+                }
+            }
+        }
     public:
-        resource_pool(Factory && factory, size_t init_size = 0)
+        resource_pool(Factory && factory, resource_pool_options const & options, Recycler && recycler = Recycler())
             : factory_(std::move(factory))
+            , recycler_(std::move(recycler))
+            , max_retained_(options.max_retained)
+            , concurrent_factory_(options.concurrent_factory)
         {
-            for (size_t i = 0; i != init_size; ++i)
+            auto num_shards = round_up_pow2(options.num_shards ? options.num_shards : std::max<size_t>(1, std::thread::hardware_concurrency()));
+            shard_mask_ = num_shards - 1;
+            for (size_t i = 0; i < num_shards; ++i)
             {
-                ready_.emplace(resource<Value>(factory_()));
+                shards_.emplace_back(std::make_unique<shard>());
             }
+            prewarm(options.init_size, options.num_init_threads);
+        }
+
+        resource_pool(Factory && factory, size_t init_size = 0)
+            : resource_pool(std::move(factory), resource_pool_options{init_size})
+        {
         }
 
         resource_pool(size_t init_size = 0)
@@ -74,30 +240,96 @@ namespace txl
         {
         }
 
-        resource<Value> get()
+        resource_pool(resource_pool const &) = delete;
+        resource_pool(resource_pool &&) = delete;
+
+        resource_pool & operator=(resource_pool const &) = delete;
+        resource_pool & operator=(resource_pool &&) = delete;
+
+        /**
+         * Creates up to count resources and spreads them over the shards,
+         * so every thread finds some in its own.
+         *
+         * \param num_threads threads creating them, used only when the
+         *                    factory can be called concurrently
+         */
+        void prewarm(size_t count, size_t num_threads = 1)
         {
-            std::unique_lock<std::mutex> lock(lock_);
+            if (not concurrent_factory_ or num_threads <= 1 or count < 2)
+            {
+                create_into(0, count);
+                return;
+            }
 
-            if (ready_.size() != 0)
+            num_threads = std::min(num_threads, count);
+            auto threads = std::vector<std::thread>{};
+            for (size_t t = 0; t < num_threads; ++t)
             {
-                auto e = std::move(ready_.front());
-                ready_.pop();
-                return e;
+                auto first = count * t / num_threads;
+                auto last = count * (t + 1) / num_threads;
+                threads.emplace_back([this, first, last]() {
+                    create_into(first, last - first);
+                });
             }
-            else
+            for (auto & t : threads)
             {
-                return resource<Value>(factory_());
+                t.join();
             }
         }
 
+        resource<Value> get()
+        {
+            auto index = thread_index();
+            auto & own = *shards_[index & shard_mask_];
+            for (size_t i = 0; i <= shard_mask_; ++i)
+            {
+                if (auto v = shards_[(index + i) & shard_mask_]->try_pop(); v)
+                {
+                    num_retained_.fetch_sub(1, std::memory_order_relaxed);
+                    own.num_hits.add();
+                    return resource<Value>(std::move(v));
+                }
+            }
+
+            own.num_misses.add();
+            auto v = create();
+            if (v)
+            {
+                own.num_creations.add();
+            }
+            return resource<Value>(std::move(v));
+        }
+
         void put(resource<Value> && res)
         {
-            std::unique_lock<std::mutex> lock(lock_);
+            if (res.empty())
+            {
+                return;
+            }
+
+            auto & own = *shards_[thread_index() & shard_mask_];
+            if (not recycler_(*res) or not retain(own, res.data_))
+            {
+                own.num_discards.add();
+                res.data_.reset();
+            }
+        }
 
-            if (not res.empty())
+        /**
+         * Counters are left at zero when telemetry is compiled out.
+         */
+        resource_pool_stats stats() const
+        {
+            auto res = resource_pool_stats{};
+            for (auto const & s : shards_)
             {
-                ready_.emplace(std::move(res));
+                res.hits += s->num_hits.load();
+                res.misses += s->num_misses.load();
+                res.creations += s->num_creations.load();
+                res.discards += s->num_discards.load();
             }
+            res.num_retained = num_retained_.load(std::memory_order_relaxed);
+            return res;
         }
     };
 }
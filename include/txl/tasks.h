@@ -1,5 +1,7 @@
 #pragma once
 
+#include <txl/block_cache.h>
+#include <txl/object_pool.h>
 #include <txl/threading.h>
 #include <txl/storage_union.h>
 
@@ -7,18 +9,40 @@
 #include <cassert>
 #include <chrono>
 #include <condition_variable>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
+#include <stdexcept>
 #include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace txl
 {
+    class task_runner;
+
+    template<class ReturnType>
+    class task_chain;
+
+    /**
+     * Callback invoked once when a promise is fulfilled, after its awaiters
+     * are woken.  Lets a waiter be resumed without blocking a thread.
+     */
+    struct promise_continuation
+    {
+        void (*func)(void *) = nullptr;
+        void * arg = nullptr;
+    };
+
     template<class ReturnType>
     class future
     {
@@ -42,16 +66,23 @@ namespace txl
     private:
         storage_union<ReturnType, std::exception_ptr> res_{};
         awaiter awaiter_{};
+        promise_continuation continuation_{};
 
         auto notify_awaiters() -> void
         {
+            auto cont = std::exchange(continuation_, {});
             awaiter_.set();
+            if (cont.func)
+            {
+                cont.func(cont.arg);
+            }
         }
     public:
         promise() = default;
         promise(promise && p)
             : res_(std::move(p.res_))
             , awaiter_(std::move(p.awaiter_))
+            , continuation_(std::exchange(p.continuation_, {}))
         {
         }
 
@@ -67,6 +98,7 @@ namespace txl
             {
                 res_ = std::move(p.res_);
                 awaiter_ = std::move(p.awaiter_);
+                continuation_ = std::exchange(p.continuation_, {});
             }
             return *this;
         }
@@ -76,6 +108,15 @@ namespace txl
             return {awaiter_};
         }
 
+        /**
+         * Registers a callback to run when the promise is next fulfilled.
+         * Survives reset() so it can be set before the task is run.
+         */
+        auto set_continuation(promise_continuation cont) -> void
+        {
+            continuation_ = cont;
+        }
+
         auto release_value() -> ReturnType &&
         {
             return std::move(res_.template ref<ReturnType>());
@@ -132,15 +173,22 @@ namespace txl
         awaiter awaiter_{};
         // TODO: atomic_bool
         storage_union<std::exception_ptr, bool> res_{};
+        promise_continuation continuation_{};
 
         auto notify_awaiters() -> void
         {
+            auto cont = std::exchange(continuation_, {});
             awaiter_.set();
+            if (cont.func)
+            {
+                cont.func(cont.arg);
+            }
         }
     public:
         promise() = default;
         promise(promise && p)
             : awaiter_(std::move(p.awaiter_))
+            , continuation_(std::exchange(p.continuation_, {}))
         {
             std::swap(res_, p.res_);
         }
@@ -157,6 +205,7 @@ namespace txl
             {
                 awaiter_ = std::move(p.awaiter_);
                 std::swap(res_, p.res_);
+                continuation_ = std::exchange(p.continuation_, {});
             }
             return *this;
         }
@@ -166,6 +215,15 @@ namespace txl
             return {awaiter_};
         }
 
+        /**
+         * Registers a callback to run when the promise is next fulfilled.
+         * Survives reset() so it can be set before the task is run.
+         */
+        auto set_continuation(promise_continuation cont) -> void
+        {
+            continuation_ = cont;
+        }
+
         auto has_value() const -> bool { return res_.template has<bool>(); }
         auto has_exception() const -> bool { return res_.has<std::exception_ptr>(); }
         auto get_exception() const -> std::exception_ptr { return res_.get<std::exception_ptr>(); }
@@ -205,22 +263,85 @@ namespace txl
         }
     };
 
+    /**
+     * Completes a task whose current step detached.  The step fulfils the
+     * promise without notifying, then calls resume(), which runs the steps
+     * chained after it or, if there are none, notifies the task's awaiters.
+     */
+    template<class ReturnType>
+    class task_resumer
+    {
+    private:
+        promise<ReturnType> * prom_ = nullptr;
+        task_chain<ReturnType> * rest_ = nullptr;
+        task_runner * runner_ = nullptr;
+        size_t priority_ = 0;
+    public:
+        task_resumer() = default;
+
+        task_resumer(promise<ReturnType> & prom, task_chain<ReturnType> * rest, task_runner * runner, size_t priority)
+            : prom_(&prom)
+            , rest_(rest)
+            , runner_(runner)
+            , priority_(priority)
+        {
+        }
+
+        auto get_promise() -> promise<ReturnType> & { return *prom_; }
+
+        auto resume() -> void;
+    };
+
     template<class ReturnType>
     class task_context
     {
     private:
         promise<ReturnType> * prom_ = nullptr;
+        task_chain<ReturnType> * rest_ = nullptr;
+        task_runner * runner_ = nullptr;
+        size_t priority_ = 0;
         bool success_ = false;
+        bool detached_ = false;
+        std::chrono::nanoseconds delay_{0};
     public:
         task_context() = default;
 
-        task_context(promise<ReturnType> & prom)
+        task_context(promise<ReturnType> & prom, task_runner * runner = nullptr, size_t priority = 0, task_chain<ReturnType> * rest = nullptr)
             : prom_(&prom)
+            , rest_(rest)
+            , runner_(runner)
+            , priority_(priority)
             , success_(true)
         {
         }
 
         auto is_success() const -> bool { return success_; }
+        auto get_promise() -> promise<ReturnType> & { return *prom_; }
+        auto runner() const -> task_runner * { return runner_; }
+        // Priority the task was run with, for running sub-tasks alike
+        auto priority() const -> size_t { return priority_; }
+
+        /**
+         * Hands ownership of the promise to the current step, which will
+         * fulfil it later (e.g. a suspended coroutine) and continue the
+         * chain through resumer().  The runner stops running the chain and
+         * does not touch the promise again.
+         */
+        auto detach() -> void
+        {
+            detached_ = true;
+        }
+
+        auto is_detached() const -> bool { return detached_; }
+
+        /**
+         * Handle for a detached step to complete the task with, carrying on
+         * with the steps chained after it.
+         */
+        auto resumer() const -> task_resumer<ReturnType>
+        {
+            return {*prom_, rest_, runner_, priority_};
+        }
 
         auto result() const -> ReturnType const &
         {
@@ -236,6 +357,26 @@ namespace txl
         {
             prom_->set_exception(std::move(p), false);
         }
+
+        /**
+         * Asks the runner to wait before running the next step of the chain.
+         * The runner decides how to wait; a thread pool parks the chain on
+         * its timer rather than sleeping a worker.
+         */
+        auto suspend_for(std::chrono::nanoseconds delay) -> void
+        {
+            delay_ = delay;
+        }
+
+        auto take_delay() -> std::chrono::nanoseconds
+        {
+            return std::exchange(delay_, std::chrono::nanoseconds{0});
+        }
+
+        auto has_delay() const -> bool
+        {
+            return delay_.count() > 0;
+        }
     };
 
     template<>
@@ -243,17 +384,51 @@ namespace txl
     {
     private:
         promise<void> * prom_ = nullptr;
+        task_chain<void> * rest_ = nullptr;
+        task_runner * runner_ = nullptr;
+        size_t priority_ = 0;
         bool success_ = false;
+        bool detached_ = false;
+        std::chrono::nanoseconds delay_{0};
     public:
         task_context() = default;
 
-        task_context(promise<void> & prom)
+        task_context(promise<void> & prom, task_runner * runner = nullptr, size_t priority = 0, task_chain<void> * rest = nullptr)
             : prom_(&prom)
+            , rest_(rest)
+            , runner_(runner)
+            , priority_(priority)
             , success_(true)
         {
         }
 
         auto is_success() const -> bool { return success_; }
+        auto get_promise() -> promise<void> & { return *prom_; }
+        auto runner() const -> task_runner * { return runner_; }
+        // Priority the task was run with, for running sub-tasks alike
+        auto priority() const -> size_t { return priority_; }
+
+        /**
+         * Hands ownership of the promise to the current step, which will
+         * fulfil it later (e.g. a suspended coroutine) and continue the
+         * chain through resumer().  The runner stops running the chain and
+         * does not touch the promise again.
+         */
+        auto detach() -> void
+        {
+            detached_ = true;
+        }
+
+        auto is_detached() const -> bool { return detached_; }
+
+        /**
+         * Handle for a detached step to complete the task with, carrying on
+         * with the steps chained after it.
+         */
+        auto resumer() const -> task_resumer<void>
+        {
+            return {*prom_, rest_, runner_, priority_};
+        }
         
         auto set_result() -> void
         {
@@ -264,13 +439,42 @@ namespace txl
         {
             prom_->set_exception(std::move(p), false);
         }
+
+        /**
+         * Asks the runner to wait before running the next step of the chain.
+         * The runner decides how to wait; a thread pool parks the chain on
+         * its timer rather than sleeping a worker.
+         */
+        auto suspend_for(std::chrono::nanoseconds delay) -> void
+        {
+            delay_ = delay;
+        }
+
+        auto take_delay() -> std::chrono::nanoseconds
+        {
+            return std::exchange(delay_, std::chrono::nanoseconds{0});
+        }
+
+        auto has_delay() const -> bool
+        {
+            return delay_.count() > 0;
+        }
     };
 
     template<class ReturnType>
-    struct task_function
+    struct task_function : block_cache_allocated
     {
         virtual ~task_function() = default;
         virtual auto execute(task_context<ReturnType> & ctx) -> void = 0;
+
+        /**
+         * Move-constructs this function into buffer.  Only functions that
+         * task_function_storage keeps inline need to support this.
+         */
+        virtual auto move_to(void *) -> task_function *
+        {
+            return nullptr;
+        }
     };
 
     template<class ReturnType, class Func>
@@ -284,6 +488,11 @@ namespace txl
         {
         }
 
+        auto move_to(void * buffer) -> task_function<ReturnType> * override
+        {
+            return ::new (buffer) task_lambda_function(std::move(*this));
+        }
+
         auto execute(task_context<ReturnType> & ctx) -> void override
         {
             if constexpr (std::is_void_v<ReturnType>)
@@ -302,16 +511,123 @@ namespace txl
         }
     };
 
+    /**
+     * Owns a task_function, stored inline when it fits in the small buffer
+     * and can be relocated without throwing, on the heap otherwise.
+     */
     template<class ReturnType>
-    class task_chain
+    class task_function_storage
+    {
+    public:
+        static constexpr size_t inline_size = 56;
+    private:
+        alignas(std::max_align_t) unsigned char buffer_[inline_size];
+        task_function<ReturnType> * func_ = nullptr;
+
+        auto is_inline() const -> bool
+        {
+            return static_cast<void const *>(func_) == static_cast<void const *>(buffer_);
+        }
+
+        auto take(task_function_storage & s) -> void
+        {
+            if (s.is_inline())
+            {
+                func_ = s.func_->move_to(buffer_);
+                s.reset();
+            }
+            else
+            {
+                func_ = std::exchange(s.func_, nullptr);
+            }
+        }
+    public:
+        template<class Func>
+        static constexpr bool fits_inline = sizeof(Func) <= inline_size
+            and alignof(Func) <= alignof(std::max_align_t)
+            and std::is_nothrow_move_constructible_v<Func>;
+
+        task_function_storage() = default;
+
+        task_function_storage(std::unique_ptr<task_function<ReturnType>> && f)
+            : func_(f.release())
+        {
+        }
+
+        task_function_storage(task_function_storage const &) = delete;
+
+        task_function_storage(task_function_storage && s)
+        {
+            take(s);
+        }
+
+        ~task_function_storage()
+        {
+            reset();
+        }
+
+        auto operator=(task_function_storage const &) -> task_function_storage & = delete;
+
+        auto operator=(task_function_storage && s) -> task_function_storage &
+        {
+            if (this != &s)
+            {
+                reset();
+                take(s);
+            }
+            return *this;
+        }
+
+        template<class Func, class... Args>
+        auto emplace(Args && ... args) -> void
+        {
+            reset();
+            if constexpr (fits_inline<Func>)
+            {
+                func_ = ::new (static_cast<void *>(buffer_)) Func(std::forward<Args>(args)...);
+            }
+            else
+            {
+                func_ = new Func(std::forward<Args>(args)...);
+            }
+        }
+
+        auto reset() -> void
+        {
+            if (is_inline())
+            {
+                func_->~task_function();
+            }
+            else
+            {
+                delete func_;
+            }
+            func_ = nullptr;
+        }
+
+        auto get() const -> task_function<ReturnType> * { return func_; }
+        auto has_value() const -> bool { return func_ != nullptr; }
+    };
+
+    /**
+     * Singly linked list of task steps.  The head node lives in the task,
+     * further nodes are carved out of slabs through shared_object_pool.
+     */
+    template<class ReturnType>
+    class task_chain : public object_pool_allocated<task_chain<ReturnType>>
     {
     private:
         // TODO: sharing promise when moving task but keeping closures the same?
-        std::unique_ptr<task_function<ReturnType>> work_{nullptr};
+        task_function_storage<ReturnType> work_{};
         std::unique_ptr<task_chain> next_{nullptr};
     public:
         task_chain() = default;
 
+        task_chain(std::unique_ptr<task_function<ReturnType>> && work)
+            : work_(std::move(work))
+        {
+        }
+
         task_chain(task_chain && tc)
             : work_(std::move(tc.work_))
             , next_(std::move(tc.next_))
@@ -323,7 +639,7 @@ namespace txl
         {
             if constexpr (std::is_invocable_v<Func, task_context<ReturnType> &>)
             {
-                work_ = std::make_unique<task_lambda_function<ReturnType, decltype(f)>>(std::move(f));
+                work_.template emplace<task_lambda_function<ReturnType, std::decay_t<Func>>>(std::move(f));
             }
             else //if constexpr (std::is_invocable_v<Func>)
             {
@@ -332,14 +648,14 @@ namespace txl
                     auto wrapper = [func=std::move(f)](task_context<ReturnType> &) mutable {
                         func();
                     };
-                    work_ = std::make_unique<task_lambda_function<ReturnType, decltype(wrapper)>>(std::move(wrapper));
+                    work_.template emplace<task_lambda_function<ReturnType, decltype(wrapper)>>(std::move(wrapper));
                 }
                 else
                 {
                     auto wrapper = [func=std::move(f)](task_context<ReturnType> &) mutable {
                         return func();
                     };
-                    work_ = std::make_unique<task_lambda_function<ReturnType, decltype(wrapper)>>(std::move(wrapper));
+                    work_.template emplace<task_lambda_function<ReturnType, decltype(wrapper)>>(std::move(wrapper));
                 }
             }
         }
@@ -356,12 +672,12 @@ namespace txl
 
         auto execute_top(task_context<ReturnType> & ctx) -> void
         {
-            if (not work_)
+            if (not work_.has_value())
             {
                 return;
             }
 
-            work_->execute(ctx);
+            work_.get()->execute(ctx);
         }
 
         auto tail() -> task_chain *
@@ -383,7 +699,7 @@ namespace txl
 
         auto empty() const -> bool
         {
-            return not static_cast<bool>(work_);
+            return not work_.has_value();
         }
 
         auto next() -> task_chain *
@@ -392,8 +708,6 @@ namespace txl
         }
     };
 
-    class task_runner;
-
     template<class ReturnType>
     class task_core
     {
@@ -490,7 +804,9 @@ namespace txl
         
         auto then(task && t) -> task &&
         {
-            task_core<ReturnType>::then(std::move(t));
+            // Splice t's chain in; the templated overload would run t as a
+            // nested, blocking task
+            task_core<ReturnType>::then(static_cast<task_core<ReturnType> &&>(t));
             return std::move(*this);
         }
 
@@ -501,7 +817,12 @@ namespace txl
             return std::move(*this);
         }
 
-        auto run(task_runner & runner) -> future<ReturnType>;
+        /**
+         * Starts the task on runner.  Runners with priority lanes queue it,
+         * and anything it runs in turn, on the given lane, 0 being the most
+         * urgent.
+         */
+        auto run(task_runner & runner, size_t priority = 0) -> future<ReturnType>;
 
         auto operator()() -> ReturnType &&;
 
@@ -515,7 +836,9 @@ namespace txl
         
         auto then(task && t) -> task &&
         {
-            task_core<void>::then(std::move(t));
+            // Splice t's chain in; the templated overload would run t as a
+            // nested, blocking task
+            task_core<void>::then(static_cast<task_core<void> &&>(t));
             return std::move(*this);
         }
 
@@ -526,14 +849,19 @@ namespace txl
             return std::move(*this);
         }
 
-        auto run(task_runner & runner) -> future<void>;
+        auto run(task_runner & runner, size_t priority = 0) -> future<void>;
         
         auto operator()() -> void;
 
         auto operator()(task_runner & runner) -> void;
     };
 
-    struct closure : thread_pool_work
+    /**
+     * Unit of work handed to a task_runner.  Runners that queue closures
+     * move them to the heap; those allocations are recycled through
+     * block_cache.
+     */
+    struct closure : thread_pool_work, block_cache_allocated
     {
         virtual auto move() const -> std::unique_ptr<closure> = 0;
     };
@@ -544,11 +872,13 @@ namespace txl
     private:
         promise<ReturnType> * prom_;
         task_chain<ReturnType> * chain_;
+        task_runner * runner_;
         task_context<ReturnType> ctx_;
     public:
-        task_closure(promise<ReturnType> & prom, task_chain<ReturnType> & chain)
+        task_closure(promise<ReturnType> & prom, task_chain<ReturnType> & chain, task_runner * runner = nullptr)
             : prom_(&prom)
             , chain_(&chain)
+            , runner_(runner)
         {
         }
 
@@ -562,7 +892,12 @@ namespace txl
 
         auto execute() -> void override
         {
-            ctx_ = task_context<ReturnType>{*prom_};
+            if (not chain_)
+            {
+                // Resumed after a trailing delay, nothing left to run
+                return;
+            }
+            ctx_ = task_context<ReturnType>{*prom_, runner_, this->priority(), chain_->next()};
             try
             {
                 chain_->execute_top(ctx_);
@@ -575,12 +910,22 @@ namespace txl
 
         auto next() -> bool override
         {
+            if (ctx_.is_detached())
+            {
+                // The step owns the promise and the rest of the chain now,
+                // and may already have completed them, so the task may no
+                // longer exist
+                return false;
+            }
+
             if (chain_)
             {
                 // Move promise forward
                 chain_ = chain_->next();
                 
-                if (chain_)
+                // A pending delay must elapse before completing, even if no
+                // steps remain
+                if (chain_ or ctx_.has_delay())
                 {
                     return true;
                 }
@@ -589,11 +934,20 @@ namespace txl
             return false;
         }
 
+        auto take_delay() -> std::chrono::nanoseconds override
+        {
+            return ctx_.take_delay();
+        }
+
         auto complete() -> void override
         {
+            if (ctx_.is_detached())
+            {
+                return;
+            }
             if (not prom_->has_value() and not prom_->has_exception())
             {
-                prom_->set_exception(std::make_exception_ptr( std::runtime_error{"empty task did not return a result"} ));
+                prom_->set_exception(std::make_exception_ptr( std::runtime_error{"empty task did not return a result"} ), false);
             }
             prom_->notify_all();
         }
@@ -606,7 +960,13 @@ namespace txl
     public:
 	virtual ~task_runner() = default;
         virtual auto run(closure && c) -> void = 0;
-        virtual auto delay(uint64_t nanos) -> task<void> = 0;
+
+        virtual auto delay(uint64_t nanos) -> task<void>
+        {
+            return {[nanos](task_context<void> & ctx) {
+                ctx.suspend_for(std::chrono::nanoseconds{nanos});
+            }};
+        }
         
         static auto set_global(std::unique_ptr<task_runner> && runner) -> void
         {
@@ -623,23 +983,37 @@ namespace txl
     {
         auto run(closure && c) -> void override
         {
+            auto has_next = false;
             do
             {
                 c.execute();
+                has_next = c.next();
+                if (auto delay = c.take_delay(); delay.count() > 0)
+                {
+                    std::this_thread::sleep_for(delay);
+                }
             }
-            while (c.next());
+            while (has_next);
             c.complete();
         }
+    };
 
-        auto delay(uint64_t nanos) -> task<void> override
+    std::unique_ptr<task_runner> task_runner::global_(std::make_unique<inline_task_runner>());
+
+    template<class ReturnType>
+    auto task_resumer<ReturnType>::resume() -> void
+    {
+        if (not rest_)
         {
-            return {[nanos]() {
-                std::this_thread::sleep_for(std::chrono::nanoseconds(nanos));
-            }};
+            prom_->notify_all();
+            return;
         }
-    };
 
-    std::unique_ptr<task_runner> task_runner::global_(std::make_unique<inline_task_runner>());
+        auto runner = runner_ ? runner_ : &task_runner::global();
+        auto c = task_closure<ReturnType>{*prom_, *rest_, runner};
+        c.set_priority(priority_);
+        runner->run(std::move(c));
+    }
 
     struct thread_pool_task_runner : task_runner
     {
@@ -652,6 +1026,12 @@ namespace txl
             pool_.start_workers();
         }
 
+        thread_pool_task_runner(thread_pool_options const & options)
+            : pool_{options}
+        {
+            pool_.start_workers();
+        }
+
         ~thread_pool_task_runner()
         {
             pool_.stop_workers();
@@ -661,20 +1041,15 @@ namespace txl
         {
             pool_.post_work(c.move());
         }
-
-        auto delay(uint64_t timeout_nanos) -> task<void> override
-        {
-            return {[timeout_nanos]() {
-                std::this_thread::sleep_for(std::chrono::nanoseconds{timeout_nanos});
-            }};
-        }
     };
 
     template<class ReturnType>
-    auto task<ReturnType>::run(task_runner & runner) -> future<ReturnType>
+    auto task<ReturnType>::run(task_runner & runner, size_t priority) -> future<ReturnType>
     {
         this->prom_.reset();
-        runner.run(task_closure<ReturnType>{this->prom_, this->chain_});
+        auto c = task_closure<ReturnType>{this->prom_, this->chain_, &runner};
+        c.set_priority(priority);
+        runner.run(std::move(c));
         return this->prom_.get_future();
     }
     
@@ -684,10 +1059,12 @@ namespace txl
         return (*this)(task_runner::global());
     }
     
-    auto task<void>::run(task_runner & runner) -> future<void>
+    auto task<void>::run(task_runner & runner, size_t priority) -> future<void>
     {
         this->prom_.reset();
-        runner.run(task_closure<void>{this->prom_, this->chain_});
+        auto c = task_closure<void>{this->prom_, this->chain_, &runner};
+        c.set_priority(priority);
+        runner.run(std::move(c));
         return this->prom_.get_future();
     }
     
@@ -721,4 +1098,367 @@ namespace txl
     {
         return {std::move(f)};
     }
+
+    template<class ReturnType>
+    struct when_any_result
+    {
+        // Position of the first task to finish
+        size_t index;
+        ReturnType value;
+    };
+
+    template<>
+    struct when_any_result<void>
+    {
+        size_t index;
+    };
+
+    namespace detail
+    {
+        // Element type of a when_all result; void tasks contribute an empty value
+        template<class ReturnType>
+        using when_all_value_t = std::conditional_t<std::is_void_v<ReturnType>, std::monostate, ReturnType>;
+
+        template<class ReturnType>
+        using when_all_vector_t = std::conditional_t<std::is_void_v<ReturnType>, void, std::vector<ReturnType>>;
+
+        template<class ReturnType, class Func>
+        auto for_each_task(std::vector<task<ReturnType>> & tasks, Func && func) -> void
+        {
+            for (auto & t : tasks)
+            {
+                func(t);
+            }
+        }
+
+        template<class... ReturnTypes, class Func>
+        auto for_each_task(std::tuple<task<ReturnTypes>...> & tasks, Func && func) -> void
+        {
+            std::apply([&func](auto & ... t) {
+                (func(t), ...);
+            }, tasks);
+        }
+
+        template<class ReturnType>
+        auto num_tasks(std::vector<task<ReturnType>> const & tasks) -> size_t
+        {
+            return tasks.size();
+        }
+
+        template<class... ReturnTypes>
+        constexpr auto num_tasks(std::tuple<task<ReturnTypes>...> const &) -> size_t
+        {
+            return sizeof...(ReturnTypes);
+        }
+
+        template<class ReturnType>
+        auto take_result(task<ReturnType> & t) -> when_all_value_t<ReturnType>
+        {
+            if constexpr (std::is_void_v<ReturnType>)
+            {
+                return {};
+            }
+            else
+            {
+                return t.get_promise().release_value();
+            }
+        }
+
+        template<class ResultType, class ReturnType>
+        auto fulfil(promise<ResultType> & target, std::vector<task<ReturnType>> & tasks) -> void
+        {
+            if constexpr (std::is_void_v<ReturnType>)
+            {
+                target.set_value(false);
+            }
+            else
+            {
+                auto res = std::vector<ReturnType>{};
+                res.reserve(tasks.size());
+                for (auto & t : tasks)
+                {
+                    res.emplace_back(take_result(t));
+                }
+                target.set_value(std::move(res), false);
+            }
+        }
+
+        template<class ResultType, class... ReturnTypes>
+        auto fulfil(promise<ResultType> & target, std::tuple<task<ReturnTypes>...> & tasks) -> void
+        {
+            target.set_value(std::apply([](auto & ... t) {
+                return ResultType{take_result(t)...};
+            }, tasks), false);
+        }
+
+        /**
+         * Shared state of a when_all: the subtasks and a countdown of those
+         * still running.  The last subtask to finish fulfils the combined
+         * task, so no thread waits on the join.  While running the state
+         * keeps itself alive.
+         */
+        template<class ResultType, class Tasks>
+        class when_all_state final : public std::enable_shared_from_this<when_all_state<ResultType, Tasks>>
+        {
+        private:
+            Tasks tasks_;
+            std::atomic<size_t> remaining_{0};
+            std::atomic_bool running_{false};
+            task_resumer<ResultType> target_{};
+            std::shared_ptr<when_all_state> self_{};
+
+            static auto on_complete(void * arg) -> void
+            {
+                auto self = static_cast<when_all_state *>(arg);
+                if (self->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    self->finish();
+                }
+            }
+
+            auto finish() -> void
+            {
+                auto keep = std::move(self_);
+                auto target = std::exchange(target_, {});
+                auto & result = target.get_promise();
+                running_.store(false, std::memory_order_release);
+
+                auto error = std::exception_ptr{};
+                for_each_task(tasks_, [&error](auto & t) {
+                    if (not error and t.get_promise().has_exception())
+                    {
+                        error = t.get_promise().get_exception();
+                    }
+                });
+
+                if (error)
+                {
+                    result.set_exception(std::move(error), false);
+                }
+                else
+                {
+                    try
+                    {
+                        fulfil(result, tasks_);
+                    }
+                    catch (...)
+                    {
+                        result.set_exception(std::current_exception(), false);
+                    }
+                }
+                target.resume();
+            }
+        public:
+            when_all_state(Tasks && tasks)
+                : tasks_(std::move(tasks))
+            {
+            }
+
+            /**
+             * Runs every subtask; the last to finish fulfils target's promise
+             * and resumes it.
+             */
+            auto start(task_resumer<ResultType> target, task_runner & runner, size_t priority) -> void
+            {
+                if (running_.exchange(true, std::memory_order_acq_rel))
+                {
+                    throw std::logic_error{"when_all task is already running"};
+                }
+
+                auto n = num_tasks(tasks_);
+                if (n == 0)
+                {
+                    running_.store(false, std::memory_order_release);
+                    fulfil(target.get_promise(), tasks_);
+                    target.resume();
+                    return;
+                }
+
+                // The combined task may be destroyed as soon as the last
+                // subtask finishes, which can happen before this returns
+                auto keep = this->shared_from_this();
+                self_ = keep;
+                target_ = target;
+                remaining_.store(n, std::memory_order_release);
+                for_each_task(tasks_, [this, &runner, priority](auto & t) {
+                    t.get_promise().set_continuation({&on_complete, this});
+                    t.run(runner, priority);
+                });
+            }
+        };
+
+        /**
+         * Shared state of a when_any.  The first subtask to finish fulfils
+         * the combined task; the state lives on until the rest finish.
+         */
+        template<class ReturnType>
+        class when_any_state final : public std::enable_shared_from_this<when_any_state<ReturnType>>
+        {
+        private:
+            struct slot
+            {
+                when_any_state * state;
+                size_t index;
+            };
+
+            std::vector<task<ReturnType>> tasks_;
+            std::vector<slot> slots_{};
+            std::atomic<size_t> remaining_{0};
+            std::atomic_bool decided_{false};
+            std::atomic_bool running_{false};
+            task_resumer<when_any_result<ReturnType>> target_{};
+            std::shared_ptr<when_any_state> self_{};
+
+            static auto on_complete(void * arg) -> void
+            {
+                auto s = static_cast<slot *>(arg);
+                auto self = s->state;
+                if (not self->decided_.exchange(true, std::memory_order_acq_rel))
+                {
+                    self->decide(s->index);
+                }
+                if (self->remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    auto keep = std::move(self->self_);
+                    self->running_.store(false, std::memory_order_release);
+                }
+            }
+
+            auto decide(size_t index) -> void
+            {
+                auto target = std::exchange(target_, {});
+                auto & result = target.get_promise();
+                auto & prom = tasks_[index].get_promise();
+                if (prom.has_exception())
+                {
+                    result.set_exception(prom.get_exception(), false);
+                }
+                else if constexpr (std::is_void_v<ReturnType>)
+                {
+                    result.set_value(when_any_result<void>{index}, false);
+                }
+                else
+                {
+                    try
+                    {
+                        result.set_value(when_any_result<ReturnType>{index, prom.release_value()}, false);
+                    }
+                    catch (...)
+                    {
+                        result.set_exception(std::current_exception(), false);
+                    }
+                }
+                target.resume();
+            }
+        public:
+            when_any_state(std::vector<task<ReturnType>> && tasks)
+                : tasks_(std::move(tasks))
+            {
+                slots_.reserve(tasks_.size());
+                for (size_t i = 0; i < tasks_.size(); ++i)
+                {
+                    slots_.emplace_back(slot{this, i});
+                }
+            }
+
+            auto start(task_resumer<when_any_result<ReturnType>> target, task_runner & runner, size_t priority) -> void
+            {
+                if (tasks_.empty())
+                {
+                    throw std::invalid_argument{"when_any requires at least one task"};
+                }
+                if (running_.exchange(true, std::memory_order_acq_rel))
+                {
+                    throw std::logic_error{"when_any task is still running"};
+                }
+
+                auto keep = this->shared_from_this();
+                self_ = keep;
+                target_ = target;
+                decided_.store(false, std::memory_order_relaxed);
+                remaining_.store(tasks_.size(), std::memory_order_release);
+                for (size_t i = 0; i < tasks_.size(); ++i)
+                {
+                    tasks_[i].get_promise().set_continuation({&on_complete, &slots_[i]});
+                    tasks_[i].run(runner, priority);
+                }
+            }
+        };
+
+        /**
+         * First step of a combined task: starts the shared state and detaches
+         * so the runner does not wait for the subtasks.  The subtask that
+         * completes the combined task resumes its remaining steps.
+         */
+        template<class ResultType, class State>
+        class fan_out_function final : public task_function<ResultType>
+        {
+        private:
+            std::shared_ptr<State> state_;
+        public:
+            fan_out_function(std::shared_ptr<State> && state)
+                : state_(std::move(state))
+            {
+            }
+
+            auto execute(task_context<ResultType> & ctx) -> void override
+            {
+                auto runner = ctx.runner() ? ctx.runner() : &task_runner::global();
+                state_->start(ctx.resumer(), *runner, ctx.priority());
+                // Only reached if start() didn't throw; from here on the
+                // subtasks own the promise and the rest of the chain
+                ctx.detach();
+            }
+        };
+
+        template<class ResultType, class State>
+        auto make_fan_out_task(std::shared_ptr<State> && state) -> task<ResultType>
+        {
+            return {std::unique_ptr<task_function<ResultType>>{new fan_out_function<ResultType, State>{std::move(state)}}};
+        }
+    }
+
+    /**
+     * Combines tasks into one that runs them all on its runner and completes
+     * when the last of them does.  Results are gathered in order; if any
+     * task fails, the first failure in order is rethrown instead.
+     */
+    template<class ReturnType>
+    inline auto when_all(std::vector<task<ReturnType>> && tasks) -> task<detail::when_all_vector_t<ReturnType>>
+    {
+        using result_type = detail::when_all_vector_t<ReturnType>;
+        using state_type = detail::when_all_state<result_type, std::vector<task<ReturnType>>>;
+        return detail::make_fan_out_task<result_type>(std::make_shared<state_type>(std::move(tasks)));
+    }
+
+    template<class ReturnType, class... ReturnTypes>
+    inline auto when_all(task<ReturnType> && t, task<ReturnTypes> && ... tasks) -> task<std::tuple<detail::when_all_value_t<ReturnType>, detail::when_all_value_t<ReturnTypes>...>>
+    {
+        using result_type = std::tuple<detail::when_all_value_t<ReturnType>, detail::when_all_value_t<ReturnTypes>...>;
+        using state_type = detail::when_all_state<result_type, std::tuple<task<ReturnType>, task<ReturnTypes>...>>;
+        return detail::make_fan_out_task<result_type>(std::make_shared<state_type>(std::make_tuple(std::move(t), std::move(tasks)...)));
+    }
+
+    /**
+     * Combines tasks into one that runs them all on its runner and completes
+     * with the result of whichever finishes first.  The remaining tasks run
+     * to completion in the background.
+     */
+    template<class ReturnType>
+    inline auto when_any(std::vector<task<ReturnType>> && tasks) -> task<when_any_result<ReturnType>>
+    {
+        using result_type = when_any_result<ReturnType>;
+        return detail::make_fan_out_task<result_type>(std::make_shared<detail::when_any_state<ReturnType>>(std::move(tasks)));
+    }
+
+    template<class ReturnType, class... ReturnTypes>
+    inline auto when_any(task<ReturnType> && t, task<ReturnTypes> && ... tasks) -> task<when_any_result<ReturnType>>
+    {
+        static_assert((std::is_same_v<ReturnType, ReturnTypes> and ...), "when_any tasks must share a return type");
+        auto v = std::vector<task<ReturnType>>{};
+        v.reserve(1 + sizeof...(ReturnTypes));
+        v.emplace_back(std::move(t));
+        (v.emplace_back(std::move(tasks)), ...);
+        return when_any(std::move(v));
+    }
 }
@@ -0,0 +1,267 @@
+#pragma once
+
+// Low overhead counters and latency histograms.  Define TXL_TELEMETRY=0 to
+// compile recording out entirely; the types stay available but are empty
+// and every snapshot reads zero.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if not defined(TXL_TELEMETRY)
+#define TXL_TELEMETRY 1
+#endif
+
+namespace txl
+{
+    inline constexpr bool telemetry_enabled = TXL_TELEMETRY != 0;
+
+    /**
+     * Monotonic timestamps in nanoseconds, zero when telemetry is disabled.
+     */
+    inline auto telemetry_now() -> uint64_t
+    {
+        if constexpr (telemetry_enabled)
+        {
+            auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count());
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    /**
+     * Bucket layout of a log-linear histogram: values below 2^sub_bucket_bits
+     * get a bucket each, every power of two above that is split into
+     * 2^sub_bucket_bits equal buckets, bounding the relative error of a
+     * bucket to 1/2^sub_bucket_bits.
+     */
+    struct log_linear_buckets final
+    {
+        static constexpr unsigned sub_bucket_bits = 3;
+        static constexpr size_t num_sub_buckets = size_t{1} << sub_bucket_bits;
+        static constexpr size_t num_buckets = (64 - sub_bucket_bits + 1) * num_sub_buckets;
+
+        static constexpr auto index_of(uint64_t value) -> size_t
+        {
+            if (value < num_sub_buckets)
+            {
+                return static_cast<size_t>(value);
+            }
+            auto exponent = static_cast<unsigned>(63 - __builtin_clzll(value));
+            auto shift = exponent - sub_bucket_bits;
+            return (shift + 1) * num_sub_buckets + static_cast<size_t>((value >> shift) - num_sub_buckets);
+        }
+
+        /**
+         * Smallest value counted in a bucket.
+         */
+        static constexpr auto lower_bound(size_t index) -> uint64_t
+        {
+            if (index < num_sub_buckets)
+            {
+                return index;
+            }
+            auto shift = index / num_sub_buckets - 1;
+            return static_cast<uint64_t>(num_sub_buckets + index % num_sub_buckets) << shift;
+        }
+
+        /**
+         * Largest value counted in a bucket.
+         */
+        static constexpr auto upper_bound(size_t index) -> uint64_t
+        {
+            return index + 1 < num_buckets ? lower_bound(index + 1) - 1 : UINT64_MAX;
+        }
+    };
+
+    /**
+     * Point in time copy of a histogram that can be merged with others.
+     */
+    class histogram_snapshot final
+    {
+    private:
+        std::vector<uint64_t> counts_{};
+        uint64_t count_ = 0;
+        uint64_t sum_ = 0;
+        uint64_t max_ = 0;
+    public:
+        histogram_snapshot() = default;
+
+        histogram_snapshot(std::vector<uint64_t> && counts, uint64_t sum, uint64_t max)
+            : counts_(std::move(counts))
+            , sum_(sum)
+            , max_(max)
+        {
+            for (auto c : counts_)
+            {
+                count_ += c;
+            }
+        }
+
+        auto count() const -> uint64_t { return count_; }
+        auto sum() const -> uint64_t { return sum_; }
+        auto max() const -> uint64_t { return max_; }
+
+        auto mean() const -> double
+        {
+            return count_ ? static_cast<double>(sum_) / static_cast<double>(count_) : 0.0;
+        }
+
+        auto counts() const -> std::vector<uint64_t> const & { return counts_; }
+
+        /**
+         * Upper bound of the bucket holding the q-th quantile, q in [0, 1].
+         */
+        auto percentile(double q) const -> uint64_t
+        {
+            if (count_ == 0)
+            {
+                return 0;
+            }
+            auto rank = static_cast<uint64_t>(q * static_cast<double>(count_ - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                seen += counts_[i];
+                if (seen >= rank)
+                {
+                    return std::min(log_linear_buckets::upper_bound(i), max_);
+                }
+            }
+            return max_;
+        }
+
+        auto merge(histogram_snapshot const & other) -> histogram_snapshot &
+        {
+            if (counts_.size() < other.counts_.size())
+            {
+                counts_.resize(other.counts_.size(), 0);
+            }
+            for (size_t i = 0; i < other.counts_.size(); ++i)
+            {
+                counts_[i] += other.counts_[i];
+            }
+            count_ += other.count_;
+            sum_ += other.sum_;
+            max_ = std::max(max_, other.max_);
+            return *this;
+        }
+    };
+
+    template<bool Enabled = telemetry_enabled>
+    class basic_log_linear_histogram;
+
+    /**
+     * Histogram of uint64_t samples, typically nanoseconds.  Recording is a
+     * few relaxed atomic adds so it may be shared between threads, though
+     * it is cheapest kept per thread and merged through snapshots.
+     */
+    template<>
+    class basic_log_linear_histogram<true> final
+    {
+    private:
+        std::array<std::atomic<uint64_t>, log_linear_buckets::num_buckets> counts_{};
+        std::atomic<uint64_t> sum_{0};
+        std::atomic<uint64_t> max_{0};
+    public:
+        auto record(uint64_t value) -> void
+        {
+            counts_[log_linear_buckets::index_of(value)].fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            auto max = max_.load(std::memory_order_relaxed);
+            while (value > max and not max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        /**
+         * Copies the histogram without stopping writers; samples recorded
+         * meanwhile may or may not be included.
+         */
+        auto snapshot() const -> histogram_snapshot
+        {
+            auto counts = std::vector<uint64_t>(counts_.size());
+            for (size_t i = 0; i < counts_.size(); ++i)
+            {
+                counts[i] = counts_[i].load(std::memory_order_relaxed);
+            }
+            return {std::move(counts), sum_.load(std::memory_order_relaxed), max_.load(std::memory_order_relaxed)};
+        }
+    };
+
+    template<>
+    class basic_log_linear_histogram<false> final
+    {
+    public:
+        auto record(uint64_t) -> void {}
+        auto snapshot() const -> histogram_snapshot { return {}; }
+    };
+
+    using log_linear_histogram = basic_log_linear_histogram<>;
+
+    template<bool Enabled = telemetry_enabled>
+    class basic_telemetry_counter;
+
+    /**
+     * Monotonic event counter.
+     */
+    template<>
+    class basic_telemetry_counter<true> final
+    {
+    private:
+        std::atomic<uint64_t> value_{0};
+    public:
+        auto add(uint64_t n = 1) -> void
+        {
+            value_.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        auto load() const -> uint64_t
+        {
+            return value_.load(std::memory_order_relaxed);
+        }
+    };
+
+    template<>
+    class basic_telemetry_counter<false> final
+    {
+    public:
+        auto add(uint64_t = 1) -> void {}
+        auto load() const -> uint64_t { return 0; }
+    };
+
+    using telemetry_counter = basic_telemetry_counter<>;
+
+    template<bool Enabled = telemetry_enabled>
+    class basic_telemetry_timestamp;
+
+    /**
+     * Time an object was last stamped, for measuring how long it waited.
+     * Empty when telemetry is disabled, so it costs nothing as a base class.
+     */
+    template<>
+    class basic_telemetry_timestamp<true>
+    {
+    private:
+        uint64_t stamp_ = 0;
+    public:
+        auto stamp() -> void { stamp_ = telemetry_now(); }
+        auto elapsed_since_stamp(uint64_t now) const -> uint64_t { return now > stamp_ ? now - stamp_ : 0; }
+    };
+
+    template<>
+    class basic_telemetry_timestamp<false>
+    {
+    public:
+        auto stamp() -> void {}
+        auto elapsed_since_stamp(uint64_t) const -> uint64_t { return 0; }
+    };
+
+    using telemetry_timestamp = basic_telemetry_timestamp<>;
+}
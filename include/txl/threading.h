@@ -1,39 +1,58 @@
 #pragma once
 
 #include <txl/free_guard.h>
+#include <txl/futex.h>
 #include <txl/linked_list.h>
+#include <txl/mpsc_queue.h>
+#include <txl/numa.h>
+#include <txl/telemetry.h>
+#include <txl/timer_wheel.h>
+#include <txl/work_stealing_deque.h>
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <condition_variable>
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <atomic>
 #include <vector>
 #include <cstddef>
+#include <optional>
+#include <string>
 #include <thread>
 
 namespace txl
 {
+    /**
+     * Latching event that threads can wait on.  Waiters spin briefly, then
+     * yield, then park on a futex; set() only enters the kernel when a
+     * waiter is actually parked.
+     */
     class awaiter
     {
     private:
-        struct core final
-        {
-            std::mutex mut_;
-            std::condition_variable cond_;
-        };
-        std::unique_ptr<core> core_;
-        bool set_ = false;
-    public:
-        awaiter()
-            : core_{std::make_unique<core>()}
+        static constexpr uint32_t spin_limit = 128;
+        static constexpr uint32_t yield_limit = 4;
+
+        static constexpr uint32_t state_unset = 0;
+        static constexpr uint32_t state_set = 1;
+        // Unset with at least one waiter sleeping on the futex
+        static constexpr uint32_t state_parked = 2;
+
+        std::atomic<uint32_t> state_{state_unset};
+
+        auto is_set() const -> bool
         {
+            return state_.load(std::memory_order_acquire) == state_set;
         }
+    public:
+        awaiter() = default;
 
         awaiter(awaiter && a)
-            : core_{std::move(a.core_)}
-            , set_{a.set_}
+            : state_{a.state_.load(std::memory_order_relaxed)}
         {
         }
         
@@ -41,37 +60,61 @@ namespace txl
         {
             if (&a != this)
             {
-                core_ = std::move(a.core_);
-                set_ = a.set_;
+                state_.store(a.state_.load(std::memory_order_relaxed), std::memory_order_relaxed);
             }
             return *this;
         }
 
         auto reset() -> void
         {
-            auto lock = std::unique_lock<std::mutex>{core_->mut_};
-            set_ = false;
+            // Leave a parked state alone, those waiters are still waiting for set()
+            auto expected = state_set;
+            state_.compare_exchange_strong(expected, state_unset, std::memory_order_acq_rel, std::memory_order_relaxed);
         }
 
         auto set() -> void
         {
+            if (state_.exchange(state_set, std::memory_order_acq_rel) == state_parked)
             {
-                auto lock = std::unique_lock<std::mutex>{core_->mut_};
-                set_ = true;
+                futex_wake(state_);
             }
-            core_->cond_.notify_all();
         }
 
         auto wait() -> bool
         {
-            if (set_)
+            if (is_set())
             {
                 return false;
             }
-            auto lock = std::unique_lock<std::mutex>{core_->mut_};
-            core_->cond_.wait(lock, [this] {
-                return set_;
-            });
+
+            for (uint32_t i = 0; i < spin_limit; ++i)
+            {
+                cpu_relax();
+                if (is_set())
+                {
+                    return true;
+                }
+            }
+            
+            for (uint32_t i = 0; i < yield_limit; ++i)
+            {
+                std::this_thread::yield();
+                if (is_set())
+                {
+                    return true;
+                }
+            }
+
+            auto state = state_.load(std::memory_order_acquire);
+            while (state != state_set)
+            {
+                if (state == state_unset and not state_.compare_exchange_weak(state, state_parked, std::memory_order_acquire, std::memory_order_acquire))
+                {
+                    continue;
+                }
+                futex_wait(state_, state_parked);
+                state = state_.load(std::memory_order_acquire);
+            }
             return true;
         }
 
@@ -82,12 +125,35 @@ namespace txl
         }
     };
     
-    struct thread_pool_work
+    /**
+     * Unit of work run by a thread_pool.  The telemetry timestamp records
+     * when the work was queued.
+     */
+    struct thread_pool_work : telemetry_timestamp
     {
+    private:
+        size_t priority_ = 0;
+    public:
         virtual ~thread_pool_work() = default;
         virtual auto execute() -> void = 0;
         virtual auto next() -> bool = 0;
         virtual auto complete() -> void = 0;
+
+        /**
+         * Returns and clears the time the work asked to wait before running
+         * its next step.  Zero means continue immediately.
+         */
+        virtual auto take_delay() -> std::chrono::nanoseconds
+        {
+            return std::chrono::nanoseconds{0};
+        }
+
+        /**
+         * Priority lane the work is queued on, 0 being the most urgent.
+         * Delayed work returns to the same lane when resumed.
+         */
+        auto priority() const -> size_t { return priority_; }
+        auto set_priority(size_t priority) -> void { priority_ = priority; }
     };
     
     template<class Func>
@@ -124,197 +190,1535 @@ namespace txl
         return std::make_unique<thread_pool_lambda<Func>>(std::move(func));
     }
 
-    class thread_pool_worker final
+    enum class thread_pool_scheduling
+    {
+        // Work is handed to each worker in turn and only ever runs there
+        round_robin,
+        // Idle workers steal from busy workers before parking
+        work_stealing,
+    };
+
+    enum class thread_pool_ordering
+    {
+        // Oldest queued work runs first
+        fifo,
+        // Most recently queued work runs first
+        lifo,
+    };
+
+    enum class thread_pool_priority_policy
+    {
+        // Always run the most urgent queued work first
+        strict,
+        // Share dequeues between lanes in proportion to their weights,
+        // most urgent first within each round
+        weighted,
+    };
+
+    struct thread_pool_options final
+    {
+        size_t num_threads = 1;
+        thread_pool_scheduling scheduling = thread_pool_scheduling::round_robin;
+        thread_pool_ordering ordering = thread_pool_ordering::fifo;
+        // Maximum number of queued items a worker takes per dequeue, batches
+        // are not stealable so work-stealing pools always take one at a time
+        size_t batch_size = 1;
+        // Granularity of the timer that resumes delayed work
+        std::chrono::nanoseconds timer_resolution = std::chrono::milliseconds{1};
+        // CPUs to pin workers to, one per worker in turn; empty leaves
+        // placement to the OS.  Ignored when numa_aware is set
+        std::vector<size_t> cpus{};
+        // Split workers evenly into one sub-pool per NUMA node, pinned to
+        // that node's CPUs and with queues allocated on that node
+        bool numa_aware = false;
+        // Where to read the NUMA topology from
+        std::string numa_sysfs_root = "/sys/devices/system/node";
+        // Number of priority lanes per worker, lane 0 being the most urgent;
+        // work posted with a larger priority goes to the last lane
+        size_t num_priorities = 1;
+        thread_pool_priority_policy priority_policy = thread_pool_priority_policy::strict;
+        // Dequeues per round for each lane under the weighted policy, empty
+        // gives each lane twice the share of the next less urgent one
+        std::vector<size_t> priority_weights{};
+        // Times a lane holding work may be passed over before it is served
+        // regardless of policy, so low priority work can't starve; zero
+        // disables aging
+        size_t priority_aging = 64;
+        // Run between min_threads and num_threads workers depending on load
+        bool elastic = false;
+        size_t min_threads = 1;
+        // Start another worker once queued work has waited this long
+        std::chrono::nanoseconds grow_threshold = std::chrono::milliseconds{5};
+        // Retire the most recently started worker once it has been idle
+        // this long
+        std::chrono::nanoseconds idle_timeout = std::chrono::seconds{10};
+        // How often an elastic pool checks its load
+        std::chrono::nanoseconds elastic_interval = std::chrono::milliseconds{1};
+    };
+
+    /**
+     * Hint for where work should run, typically the NUMA node holding the
+     * data it touches (see numa_node_of()).
+     */
+    struct thread_pool_locality final
+    {
+        size_t numa_node = 0;
+    };
+
+    struct thread_pool_worker_placement final
+    {
+        // Index of the worker's sub-pool
+        size_t group = 0;
+        // Node to allocate the worker's queues on, if any
+        std::optional<size_t> numa_node{};
+        // CPUs the worker is pinned to, empty if not pinned
+        std::vector<size_t> cpus{};
+    };
+
+    /**
+     * Single thread driving a timer_wheel of suspended work.  Expired work is
+     * handed back to the pool rather than run on the timer thread.
+     */
+    class thread_pool_timer final
     {
+    public:
+        using resume_function = std::function<void(thread_pool_work *)>;
     private:
-        using thread_work_list = atomic_linked_list<thread_pool_work *>;
+        using clock = std::chrono::steady_clock;
 
-        awaiter work_awaiter_;
-        awaiter & idle_awaiter_;
-        std::atomic<size_t> & job_counter_;
-        std::thread thread_;
-        std::unique_ptr<thread_work_list> pending_;
-        std::atomic_bool stopped_;
+        resume_function on_resume_;
+        std::chrono::nanoseconds resolution_;
+        clock::time_point epoch_;
+        std::mutex mut_{};
+        std::condition_variable cond_{};
+        timer_wheel<thread_pool_work *> wheel_{};
+        // Tick the timer thread is sleeping until, zero when sleeping indefinitely
+        uint64_t wake_tick_ = 0;
+        bool stopped_ = false;
+        std::thread thread_{};
 
-        auto thread_body() -> void
+        auto now_tick() const -> uint64_t
         {
-            while (process_work())
-            {
-            }
+            return static_cast<uint64_t>((clock::now() - epoch_) / resolution_);
         }
-        
-        auto process_work() -> bool
+
+        auto thread_body() -> void
         {
-            while (not stopped_.load(std::memory_order_relaxed))
+            std::vector<thread_pool_work *> expired{};
+            auto lock = std::unique_lock<std::mutex>{mut_};
+            while (not stopped_)
             {
-                auto w = pending_->pop_and_release_front();
-                if (w)
+                wheel_.advance(now_tick(), [&expired](thread_pool_work * w) {
+                    expired.emplace_back(w);
+                });
+
+                if (not expired.empty())
                 {
-                    auto work = *w;
-                    free_guard f{work};
-                    do
+                    lock.unlock();
+                    for (auto w : expired)
                     {
-                        work->execute();
+                        on_resume_(w);
                     }
-                    while (not stopped_.load(std::memory_order_relaxed) and work->next());
-                    work->complete();
-                    job_counter_.fetch_sub(1, std::memory_order_acq_rel);
-                    return true;
+                    expired.clear();
+                    lock.lock();
+                    continue;
                 }
 
-                if (not stopped_.load(std::memory_order_relaxed))
+                auto ticks = wheel_.ticks_until_next();
+                if (ticks == 0)
                 {
-                    // Notify that we're in an idle state now
-                    idle_awaiter_.set();
-
-                    work_awaiter_.wait_and_reset();
+                    wake_tick_ = 0;
+                    cond_.wait(lock);
+                }
+                else
+                {
+                    wake_tick_ = wheel_.now() + ticks;
+                    cond_.wait_until(lock, epoch_ + resolution_ * wake_tick_);
                 }
             }
-            // Notify that we're in an idle state now
-            idle_awaiter_.set();
-
-            return false;
         }
     public:
-        thread_pool_worker(awaiter & idle_awaiter, std::atomic<size_t> & job_counter)
-            : idle_awaiter_(idle_awaiter)
-            , job_counter_(job_counter)
-            , pending_(std::make_unique<thread_work_list>())
+        thread_pool_timer(resume_function on_resume, std::chrono::nanoseconds resolution)
+            : on_resume_(std::move(on_resume))
+            , resolution_(resolution)
+            , epoch_(clock::now())
         {
-            stopped_.store(false, std::memory_order_release);
         }
 
-        thread_pool_worker(thread_pool_worker const &) = delete;
+        thread_pool_timer(thread_pool_timer const &) = delete;
+        thread_pool_timer(thread_pool_timer &&) = delete;
 
-        thread_pool_worker(thread_pool_worker && w)
-            : idle_awaiter_(w.idle_awaiter_)
-            , job_counter_(w.job_counter_)
-            , thread_(std::move(w.thread_))
-            , pending_(std::move(w.pending_))
-            , stopped_()
+        ~thread_pool_timer()
         {
-            auto old_value = stopped_.load();
-            stopped_.store(w.stopped_.load());
-            w.stopped_.store(old_value);
+            stop();
         }
 
-        auto operator=(thread_pool_worker const &) -> thread_pool_worker & = delete;
+        auto operator=(thread_pool_timer const &) -> thread_pool_timer & = delete;
+        auto operator=(thread_pool_timer &&) -> thread_pool_timer & = delete;
 
-        auto operator=(thread_pool_worker && w) -> thread_pool_worker &
+        /**
+         * Schedules work to be resumed after a delay.  Starts the timer
+         * thread on first use.
+         *
+         * \return false if the timer has been stopped
+         */
+        auto post_after(std::chrono::nanoseconds delay, thread_pool_work * w) -> bool
         {
-            if (this != &w)
             {
-                thread_ = std::move(w.thread_);
-                pending_ = std::move(w.pending_);
-                
-                auto old_value = stopped_.load();
-                stopped_.store(w.stopped_.load());
-                w.stopped_.store(old_value);
-            }
-            return *this;
-        }
+                auto lock = std::unique_lock<std::mutex>{mut_};
+                if (stopped_)
+                {
+                    return false;
+                }
+                if (not thread_.joinable())
+                {
+                    thread_ = std::thread([this]() {
+                        thread_body();
+                    });
+                }
 
-        auto wait_for_idle() -> void
-        {
-            idle_awaiter_.wait_and_reset();
+                // Round up so work never resumes early
+                auto deadline = static_cast<uint64_t>((clock::now() - epoch_ + delay + resolution_ - std::chrono::nanoseconds{1}) / resolution_);
+                if (not wheel_.schedule(deadline, w))
+                {
+                    lock.unlock();
+                    on_resume_(w);
+                    return true;
+                }
+                if (wake_tick_ != 0 and deadline >= wake_tick_)
+                {
+                    // Timer thread will wake in time on its own
+                    return true;
+                }
+            }
+            cond_.notify_one();
+            return true;
         }
 
-        auto post(std::unique_ptr<thread_pool_work> && c) -> bool
+        /**
+         * Stops the timer thread.  Work still waiting on the timer is
+         * returned through on_discard.
+         */
+        template<class OnDiscardFunc>
+        auto stop(OnDiscardFunc && on_discard) -> void
         {
-            if (stopped_.load(std::memory_order_relaxed))
             {
-                return false;
+                auto lock = std::unique_lock<std::mutex>{mut_};
+                stopped_ = true;
+            }
+            cond_.notify_one();
+            if (thread_.joinable())
+            {
+                thread_.join();
             }
+            wheel_.clear(on_discard);
+        }
 
-            pending_->emplace_front(c.release());
-            work_awaiter_.set();
-            return true;
+        auto stop() -> void
+        {
+            stop([](thread_pool_work * w) {
+                delete w;
+            });
         }
+    };
 
-        auto is_running() const -> bool
+    class thread_pool_queue final
+    {
+    private:
+        thread_pool_ordering ordering_;
+        // Stealing workers pop concurrently with the owner, pooled nodes keep
+        // a head popped by another worker readable
+        atomic_linked_list<thread_pool_work *, pooled_nodes, immediate_reclaimer> lifo_{};
+        mpsc_queue<thread_pool_work *> fifo_{};
+    public:
+        thread_pool_queue(thread_pool_ordering ordering)
+            : ordering_(ordering)
         {
-            return not stopped_.load(std::memory_order_relaxed);
         }
-        
-        auto start() -> void
+
+        auto empty() const -> bool
         {
-            stopped_.store(false, std::memory_order_release);
+            return ordering_ == thread_pool_ordering::fifo ? fifo_.empty() : lifo_.empty();
+        }
 
-            thread_ = std::thread([&]() {
-                thread_body();
-            });
+        auto push(thread_pool_work * w) -> void
+        {
+            if (ordering_ == thread_pool_ordering::fifo)
+            {
+                fifo_.emplace_back(w);
+            }
+            else
+            {
+                lifo_.emplace_front(w);
+            }
         }
 
-        auto stop() -> void
+        auto try_pop() -> thread_pool_work *
         {
-            stopped_.store(true, std::memory_order_release);
-            work_awaiter_.set();
+            auto w = ordering_ == thread_pool_ordering::fifo ? fifo_.try_pop_front() : lifo_.pop_and_release_front();
+            return w ? *w : nullptr;
         }
 
-        auto wait_for_shutdown() -> void
+        template<class OnWorkFunc>
+        auto pop_n(size_t max_items, OnWorkFunc && on_work) -> size_t
         {
-            if (thread_.joinable())
+            if (ordering_ == thread_pool_ordering::fifo)
             {
-                thread_.join();
+                return fifo_.pop_front_n(max_items, on_work);
+            }
+
+            size_t num_popped = 0;
+            while (num_popped < max_items)
+            {
+                auto w = lifo_.pop_and_release_front();
+                if (not w)
+                {
+                    break;
+                }
+                on_work(*w);
+                ++num_popped;
             }
+            return num_popped;
         }
     };
 
-    class thread_pool final
+    /**
+     * Telemetry kept by each worker, on its own cache lines.  Empty when
+     * telemetry is compiled out (see txl/telemetry.h).
+     */
+    struct alignas(telemetry_enabled ? 64 : 1) thread_pool_worker_telemetry final
+    {
+        // Work queued on the worker
+        telemetry_counter num_posted{};
+        // Work taken off the worker's queues, by the worker or a sibling
+        telemetry_counter num_dequeued{};
+        // Work the worker took off a sibling's queues
+        telemetry_counter num_stolen{};
+        telemetry_counter num_executed{};
+        // Nanoseconds from being queued to being dequeued
+        log_linear_histogram queue_wait{};
+        // Nanoseconds spent executing each time work was dispatched
+        log_linear_histogram run_time{};
+    };
+
+    /**
+     * Snapshot of one worker's telemetry, or the sum over all workers.
+     */
+    struct thread_pool_worker_stats final
+    {
+        uint64_t num_posted = 0;
+        uint64_t num_dequeued = 0;
+        uint64_t num_stolen = 0;
+        uint64_t num_executed = 0;
+        // Work queued but not yet dequeued when sampled
+        uint64_t queue_depth = 0;
+        histogram_snapshot queue_wait{};
+        histogram_snapshot run_time{};
+
+        auto merge(thread_pool_worker_stats const & other) -> thread_pool_worker_stats &
+        {
+            num_posted += other.num_posted;
+            num_dequeued += other.num_dequeued;
+            num_stolen += other.num_stolen;
+            num_executed += other.num_executed;
+            queue_depth += other.queue_depth;
+            queue_wait.merge(other.queue_wait);
+            run_time.merge(other.run_time);
+            return *this;
+        }
+    };
+
+    struct thread_pool_stats final
+    {
+        std::vector<thread_pool_worker_stats> workers{};
+        thread_pool_worker_stats total{};
+        // Work posted but not yet completed, including delayed work
+        size_t num_pending = 0;
+        size_t num_active_threads = 0;
+    };
+
+    /**
+     * One thread_pool_queue per priority lane.  Any thread may push or
+     * try_pop, the latter always taking the most urgent work; select() keeps
+     * the state for weighted dequeue and aging and must only be called by
+     * the owning worker.
+     */
+    class thread_pool_lanes final
     {
     private:
-        std::vector<thread_pool_worker> workers_{};
-        std::atomic<size_t> next_thread_index_ = 0;
-        std::atomic<size_t> pending_ = 0;
-        awaiter idle_awaiter_;
+        std::vector<std::unique_ptr<thread_pool_queue>> queues_{};
+        thread_pool_priority_policy policy_;
+        size_t aging_;
+        std::vector<size_t> weights_{};
+        std::vector<size_t> credits_{};
+        std::vector<size_t> skipped_{};
     public:
-        thread_pool(size_t num_threads)
+        thread_pool_lanes(thread_pool_options const & options)
+            : policy_(options.priority_policy)
+            , aging_(options.priority_aging)
         {
-            for (size_t i = 0; i < num_threads; ++i)
+            auto num_lanes = std::max<size_t>(1, options.num_priorities);
+            for (size_t i = 0; i < num_lanes; ++i)
             {
-                workers_.emplace_back(idle_awaiter_, pending_);
+                queues_.emplace_back(std::make_unique<thread_pool_queue>(options.ordering));
+                auto weight = i < options.priority_weights.size()
+                    ? options.priority_weights[i]
+                    : size_t{1} << std::min<size_t>(num_lanes - 1 - i, 16);
+                weights_.emplace_back(std::max<size_t>(1, weight));
             }
+            credits_ = weights_;
+            skipped_.resize(num_lanes, 0);
         }
 
-        ~thread_pool()
+        auto size() const -> size_t { return queues_.size(); }
+
+        auto lane(size_t priority) -> thread_pool_queue & { return *queues_[priority]; }
+
+        auto lane_of(thread_pool_work const * w) const -> size_t
         {
-            stop_workers();
+            return std::min(w->priority(), queues_.size() - 1);
         }
 
-        auto post_work(std::unique_ptr<thread_pool_work> && c) -> bool
+        auto empty() const -> bool
         {
-            auto index = next_thread_index_.fetch_add(1, std::memory_order_acq_rel);
-            if (index >= workers_.size())
-            {
-                next_thread_index_.store(0, std::memory_order_release);
-                index = 0;
-            }
-            if (not workers_[index].post(std::move(c)))
+            for (auto const & q : queues_)
             {
-                return false;
+                if (not q->empty())
+                {
+                    return false;
+                }
             }
-            pending_.fetch_add(1, std::memory_order_acq_rel);
             return true;
         }
 
-        auto wait_for_idle() -> void
+        auto push(thread_pool_work * w) -> void
         {
-            while (pending_.load(std::memory_order_relaxed) > 0)
+            queues_[lane_of(w)]->push(w);
+        }
+
+        auto try_pop() -> thread_pool_work *
+        {
+            for (auto & q : queues_)
             {
-                idle_awaiter_.wait_and_reset();
+                if (auto w = q->try_pop(); w)
+                {
+                    return w;
+                }
             }
+            return nullptr;
         }
 
-        auto start_workers() -> void
+        /**
+         * Picks the lane to dequeue from next among those has_work(lane)
+         * reports as non-empty.
+         */
+        template<class HasWorkFunc>
+        auto select(HasWorkFunc && has_work) -> std::optional<size_t>
         {
-            for (auto & w : workers_)
+            auto num_lanes = queues_.size();
+            if (num_lanes == 1)
+            {
+                return has_work(size_t{0}) ? std::optional<size_t>{0} : std::nullopt;
+            }
+
+            auto chosen = std::optional<size_t>{};
+            auto most_skipped = size_t{0};
+            auto first_with_credit = std::optional<size_t>{};
+            for (size_t i = 0; i < num_lanes; ++i)
+            {
+                if (not has_work(i))
+                {
+                    skipped_[i] = 0;
+                    continue;
+                }
+                if (not chosen)
+                {
+                    chosen = i;
+                }
+                if (not first_with_credit and credits_[i] > 0)
+                {
+                    first_with_credit = i;
+                }
+                if (aging_ > 0 and skipped_[i] >= aging_ and skipped_[i] > most_skipped)
+                {
+                    most_skipped = skipped_[i];
+                }
+            }
+            if (not chosen)
+            {
+                return {};
+            }
+
+            if (most_skipped > 0)
+            {
+                // Serve the longest starved lane
+                for (size_t i = 0; i < num_lanes; ++i)
+                {
+                    if (skipped_[i] == most_skipped)
+                    {
+                        chosen = i;
+                        break;
+                    }
+                }
+            }
+            else if (policy_ == thread_pool_priority_policy::weighted)
+            {
+                if (not first_with_credit)
+                {
+                    // Every waiting lane used up its share, start a new round
+                    credits_ = weights_;
+                    first_with_credit = chosen;
+                }
+                chosen = first_with_credit;
+                --credits_[*chosen];
+            }
+
+            for (size_t i = 0; i < num_lanes; ++i)
             {
-                w.start();
+                if (i == *chosen)
+                {
+                    skipped_[i] = 0;
+                }
+                else if (skipped_[i] > 0 or (i > *chosen and has_work(i)))
+                {
+                    ++skipped_[i];
+                }
             }
+            return chosen;
         }
+    };
 
-        auto stop_workers() -> void
+    class thread_pool_worker final
+    {
+    private:
+        using thread_work_deque = work_stealing_deque<thread_pool_work *>;
+
+        awaiter work_awaiter_;
+        awaiter & idle_awaiter_;
+        std::atomic<size_t> & job_counter_;
+        std::vector<thread_pool_worker> & siblings_;
+        thread_pool_timer & timer_;
+        thread_pool_options options_;
+        thread_pool_worker_placement placement_;
+        std::thread thread_;
+        // Work posted from outside of the pool, one queue per priority
+        std::unique_ptr<thread_pool_lanes> pending_;
+        // Work posted by this worker's own jobs (work-stealing only)
+        std::unique_ptr<thread_work_deque> local_;
+        std::unique_ptr<thread_pool_worker_telemetry> telemetry_;
+        // Work dequeued from pending_ in one go but not yet run
+        std::vector<thread_pool_work *> batch_{};
+        size_t batch_pos_ = 0;
+        std::atomic_bool stopped_;
+        std::atomic_bool parked_;
+        // Retired, or not yet started, by an elastic pool
+        std::atomic_bool dormant_;
+        // Posts under way that saw this worker active (elastic pools only)
+        std::atomic<size_t> in_flight_;
+        // When the worker last parked, zero while it is running
+        std::atomic<uint64_t> parked_since_;
+        // Since when the worker's queues have stayed non-empty, zero if empty
+        std::atomic<uint64_t> backlog_since_;
+        uint64_t steal_seed_;
+
+        static auto current() -> thread_pool_worker *&
+        {
+            static thread_local thread_pool_worker * worker = nullptr;
+            return worker;
+        }
+
+        auto is_stealing() const -> bool
+        {
+            return options_.scheduling == thread_pool_scheduling::work_stealing;
+        }
+
+        auto next_victim() -> size_t
         {
+            // xorshift64
+            steal_seed_ ^= steal_seed_ << 13;
+            steal_seed_ ^= steal_seed_ >> 7;
+            steal_seed_ ^= steal_seed_ << 17;
+            return static_cast<size_t>(steal_seed_ % siblings_.size());
+        }
+
+        /**
+         * Accounts for work taken off this worker's queues.
+         */
+        auto on_dequeued(thread_pool_work * w) -> thread_pool_work *
+        {
+            if constexpr (telemetry_enabled)
+            {
+                if (w)
+                {
+                    telemetry_->num_dequeued.add();
+                    telemetry_->queue_wait.record(w->elapsed_since_stamp(telemetry_now()));
+                }
+            }
+            return w;
+        }
+
+        auto has_work() const -> bool
+        {
+            return not pending_->empty() or not local_->empty();
+        }
+
+        auto steal_work() -> thread_pool_work *
+        {
+            auto num_workers = siblings_.size();
+            auto start = next_victim();
+            // Steal within our own sub-pool before crossing nodes
+            for (auto same_group : {true, false})
+            {
+                for (size_t i = 0; i < num_workers; ++i)
+                {
+                    auto & victim = siblings_[(start + i) % num_workers];
+                    if (&victim == this or (victim.placement_.group == placement_.group) != same_group)
+                    {
+                        continue;
+                    }
+                    auto w = victim.local_->steal();
+                    auto work = w ? *w : victim.pending_->try_pop();
+                    if (work)
+                    {
+                        telemetry_->num_stolen.add();
+                        return victim.on_dequeued(work);
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        auto next_pending(size_t priority) -> thread_pool_work *
+        {
+            auto & lane = pending_->lane(priority);
+            auto batch_size = is_stealing() ? 1 : options_.batch_size;
+            if (batch_size <= 1)
+            {
+                return on_dequeued(lane.try_pop());
+            }
+
+            batch_.clear();
+            batch_pos_ = 0;
+            lane.pop_n(batch_size, [this](auto w) {
+                batch_.emplace_back(on_dequeued(w));
+            });
+            return batch_.empty() ? nullptr : batch_[batch_pos_++];
+        }
+
+        auto next_work() -> thread_pool_work *
+        {
+            auto w = dequeue_work();
+            if (options_.elastic and w)
+            {
+                // Anything still queued has waited at least since the
+                // first dequeue that left work behind
+                if (not has_work())
+                {
+                    backlog_since_.store(0, std::memory_order_relaxed);
+                }
+                else if (backlog_since_.load(std::memory_order_relaxed) == 0)
+                {
+                    backlog_since_.store(now_ns(), std::memory_order_relaxed);
+                }
+            }
+            return w;
+        }
+
+        auto dequeue_work() -> thread_pool_work *
+        {
+            if (batch_pos_ < batch_.size())
+            {
+                return batch_[batch_pos_++];
+            }
+
+            // Work spawned by our own jobs belongs to the most urgent lane
+            auto priority = pending_->select([this](size_t p) {
+                return not pending_->lane(p).empty() or (p == 0 and not local_->empty());
+            });
+            if (priority)
+            {
+                if (*priority == 0)
+                {
+                    if (auto w = local_->pop(); w)
+                    {
+                        return on_dequeued(*w);
+                    }
+                }
+                if (auto w = next_pending(*priority); w)
+                {
+                    return w;
+                }
+            }
+
+            // The chosen lane was emptied by a helping thread in the meantime
+            if (auto w = local_->pop(); w)
+            {
+                return on_dequeued(*w);
+            }
+            if (auto w = pending_->try_pop(); w)
+            {
+                return on_dequeued(w);
+            }
+            if (is_stealing())
+            {
+                return steal_work();
+            }
+            return nullptr;
+        }
+
+        auto any_sibling_has_work() const -> bool
+        {
+            for (auto const & w : siblings_)
+            {
+                if (w.has_work())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        auto park() -> void
+        {
+            if (is_stealing())
+            {
+                // Announce that we're parking before the final check for work,
+                // pairs with the fence in notify_parked_sibling()
+                parked_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (any_sibling_has_work())
+                {
+                    parked_.store(false, std::memory_order_relaxed);
+                    return;
+                }
+            }
+
+            if (options_.elastic)
+            {
+                backlog_since_.store(0, std::memory_order_relaxed);
+                parked_since_.store(now_ns(), std::memory_order_relaxed);
+            }
+            work_awaiter_.wait_and_reset();
+            parked_since_.store(0, std::memory_order_relaxed);
+            parked_.store(false, std::memory_order_relaxed);
+        }
+
+        /**
+         * Queues work without checking whether the worker is running.
+         */
+        auto push(std::unique_ptr<thread_pool_work> && c) -> void
+        {
+            c->stamp();
+            telemetry_->num_posted.add();
+            pending_->push(c.release());
+            work_awaiter_.set();
+            if (is_stealing())
+            {
+                notify_parked_sibling();
+            }
+        }
+
+        /**
+         * Moves everything queued on a retiring worker to the first worker,
+         * which an elastic pool never retires.
+         */
+        auto hand_off() -> void
+        {
+            // Posts that saw us active finish pushing before we drain
+            while (in_flight_.load(std::memory_order_seq_cst) > 0)
+            {
+                cpu_relax();
+            }
+
+            auto & heir = siblings_[0];
+            while (batch_pos_ < batch_.size())
+            {
+                heir.push(std::unique_ptr<thread_pool_work>{batch_[batch_pos_++]});
+            }
+            while (auto w = local_->pop())
+            {
+                heir.push(std::unique_ptr<thread_pool_work>{on_dequeued(*w)});
+            }
+            while (auto w = pending_->try_pop())
+            {
+                heir.push(std::unique_ptr<thread_pool_work>{on_dequeued(w)});
+            }
+            backlog_since_.store(0, std::memory_order_relaxed);
+        }
+
+        auto thread_body() -> void
+        {
+            if (not placement_.cpus.empty())
+            {
+                // Best effort, an unpinned worker still works
+                set_current_thread_affinity(placement_.cpus);
+            }
+            current() = this;
+            while (process_work())
+            {
+            }
+            current() = nullptr;
+        }
+        
+        /**
+         * Runs work through to completion or until it is parked on the timer.
+         * May be called from any thread on behalf of this worker.
+         */
+        auto run_work(thread_pool_work * work) -> void
+        {
+            free_guard f{work};
+            auto has_next = false;
+            uint64_t run_time = 0;
+            do
+            {
+                auto start = telemetry_now();
+                work->execute();
+                run_time += telemetry_now() - start;
+                has_next = not stopped_.load(std::memory_order_relaxed) and work->next();
+                if (auto delay = work->take_delay(); has_next and delay.count() > 0)
+                {
+                    // Park the work on the timer instead of sleeping
+                    // this thread; it stays counted as pending
+                    if (timer_.post_after(delay, work))
+                    {
+                        f.owned_ = nullptr;
+                        telemetry_->run_time.record(run_time);
+                        return;
+                    }
+                    std::this_thread::sleep_for(delay);
+                }
+            }
+            while (has_next);
+            work->complete();
+            telemetry_->run_time.record(run_time);
+            telemetry_->num_executed.add();
+            if (job_counter_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                // The last job may have been run by a helping thread while
+                // every worker was parked
+                idle_awaiter_.set();
+            }
+        }
+
+        auto process_work() -> bool
+        {
+            while (not stopped_.load(std::memory_order_relaxed))
+            {
+                if (dormant_.load(std::memory_order_seq_cst))
+                {
+                    hand_off();
+                    return false;
+                }
+
+                auto work = next_work();
+                if (work)
+                {
+                    run_work(work);
+                    return true;
+                }
+
+                if (not stopped_.load(std::memory_order_relaxed))
+                {
+                    // Notify that we're in an idle state now
+                    idle_awaiter_.set();
+
+                    park();
+                }
+            }
+            // Notify that we're in an idle state now
+            idle_awaiter_.set();
+
+            return false;
+        }
+    public:
+        /**
+         * Clock used for elastic scaling decisions, in nanoseconds.
+         */
+        static auto now_ns() -> uint64_t
+        {
+            auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count());
+        }
+
+        thread_pool_worker(awaiter & idle_awaiter, std::atomic<size_t> & job_counter, std::vector<thread_pool_worker> & siblings, thread_pool_timer & timer, thread_pool_options const & options, thread_pool_worker_placement placement = {})
+            : idle_awaiter_(idle_awaiter)
+            , job_counter_(job_counter)
+            , siblings_(siblings)
+            , timer_(timer)
+            , options_(options)
+            , placement_(std::move(placement))
+            , steal_seed_(siblings.size() + 1)
+        {
+            {
+                auto node_local = std::optional<numa_preferred_scope>{};
+                if (placement_.numa_node)
+                {
+                    node_local.emplace(*placement_.numa_node);
+                }
+                pending_ = std::make_unique<thread_pool_lanes>(options);
+                telemetry_ = std::make_unique<thread_pool_worker_telemetry>();
+                local_ = std::make_unique<thread_work_deque>();
+                batch_.reserve(options.batch_size);
+            }
+            stopped_.store(false, std::memory_order_release);
+            parked_.store(false, std::memory_order_release);
+            dormant_.store(false, std::memory_order_release);
+            in_flight_.store(0, std::memory_order_release);
+            parked_since_.store(0, std::memory_order_release);
+            backlog_since_.store(0, std::memory_order_release);
+        }
+
+        thread_pool_worker(thread_pool_worker const &) = delete;
+
+        thread_pool_worker(thread_pool_worker && w)
+            : idle_awaiter_(w.idle_awaiter_)
+            , job_counter_(w.job_counter_)
+            , siblings_(w.siblings_)
+            , timer_(w.timer_)
+            , options_(w.options_)
+            , placement_(std::move(w.placement_))
+            , thread_(std::move(w.thread_))
+            , pending_(std::move(w.pending_))
+            , local_(std::move(w.local_))
+            , telemetry_(std::move(w.telemetry_))
+            , batch_(std::move(w.batch_))
+            , batch_pos_(w.batch_pos_)
+            , stopped_()
+            , parked_()
+            , dormant_(w.dormant_.load())
+            , in_flight_(0)
+            , parked_since_(0)
+            , backlog_since_(0)
+            , steal_seed_(w.steal_seed_)
+        {
+            auto old_value = stopped_.load();
+            stopped_.store(w.stopped_.load());
+            w.stopped_.store(old_value);
+            parked_.store(false);
+        }
+
+        auto operator=(thread_pool_worker const &) -> thread_pool_worker & = delete;
+
+        auto operator=(thread_pool_worker && w) -> thread_pool_worker &
+        {
+            if (this != &w)
+            {
+                thread_ = std::move(w.thread_);
+                pending_ = std::move(w.pending_);
+                local_ = std::move(w.local_);
+                telemetry_ = std::move(w.telemetry_);
+                batch_ = std::move(w.batch_);
+                batch_pos_ = w.batch_pos_;
+                options_ = w.options_;
+                placement_ = std::move(w.placement_);
+                steal_seed_ = w.steal_seed_;
+                dormant_.store(w.dormant_.load());
+                
+                auto old_value = stopped_.load();
+                stopped_.store(w.stopped_.load());
+                w.stopped_.store(old_value);
+            }
+            return *this;
+        }
+
+        /**
+         * Returns the worker running on the calling thread if it belongs to
+         * the given group of workers.
+         */
+        static auto current_in(std::vector<thread_pool_worker> const & workers) -> thread_pool_worker *
+        {
+            auto w = current();
+            if (w and &w->siblings_ == &workers)
+            {
+                return w;
+            }
+            return nullptr;
+        }
+
+        auto wait_for_idle() -> void
+        {
+            idle_awaiter_.wait_and_reset();
+        }
+
+        auto placement() const -> thread_pool_worker_placement const &
+        {
+            return placement_;
+        }
+
+        /**
+         * Reads this worker's telemetry while it keeps running.
+         */
+        auto stats() const -> thread_pool_worker_stats
+        {
+            auto res = thread_pool_worker_stats{};
+            // Dequeued first, so a concurrent post can't make depth negative
+            res.num_dequeued = telemetry_->num_dequeued.load();
+            res.num_posted = telemetry_->num_posted.load();
+            res.num_stolen = telemetry_->num_stolen.load();
+            res.num_executed = telemetry_->num_executed.load();
+            res.queue_depth = res.num_posted > res.num_dequeued ? res.num_posted - res.num_dequeued : 0;
+            res.queue_wait = telemetry_->queue_wait.snapshot();
+            res.run_time = telemetry_->run_time.snapshot();
+            return res;
+        }
+
+        /**
+         * Runs one piece of this worker's queued work on the calling thread,
+         * which must not be this worker's thread.
+         */
+        auto help() -> bool
+        {
+            thread_pool_work * work = nullptr;
+            if (auto w = local_->steal(); w)
+            {
+                work = *w;
+            }
+            else
+            {
+                work = pending_->try_pop();
+            }
+            on_dequeued(work);
+
+            if (not work)
+            {
+                return false;
+            }
+            run_work(work);
+            return true;
+        }
+
+        /**
+         * Runs one piece of work from this worker's own queues, or stolen
+         * from a sibling, while a job on this worker waits for other work.
+         * Must be called from this worker's thread.
+         */
+        auto help_self() -> bool
+        {
+            auto work = next_work();
+            if (not work)
+            {
+                work = steal_work();
+            }
+
+            if (not work)
+            {
+                return false;
+            }
+            run_work(work);
+            return true;
+        }
+
+        auto post(std::unique_ptr<thread_pool_work> && c) -> bool
+        {
+            if (stopped_.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            if (options_.elastic)
+            {
+                // Pairs with hand_off(), either the retiring worker waits for
+                // this push or we see it retiring
+                in_flight_.fetch_add(1, std::memory_order_seq_cst);
+                if (dormant_.load(std::memory_order_seq_cst))
+                {
+                    in_flight_.fetch_sub(1, std::memory_order_release);
+                    return this == &siblings_[0] ? false : siblings_[0].post(std::move(c));
+                }
+                push(std::move(c));
+                in_flight_.fetch_sub(1, std::memory_order_release);
+                return true;
+            }
+
+            push(std::move(c));
+            return true;
+        }
+
+        /**
+         * Pushes work onto this worker's own deque.  Must be called from this
+         * worker's thread; the work becomes available to idle siblings.
+         */
+        auto post_local(std::unique_ptr<thread_pool_work> && c) -> bool
+        {
+            if (pending_->lane_of(c.get()) != 0)
+            {
+                // The deque is not prioritised, less urgent work is queued
+                // in its lane where siblings can still steal it
+                return post(std::move(c));
+            }
+            if (stopped_.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            c->stamp();
+            telemetry_->num_posted.add();
+            local_->push(c.release());
+            notify_parked_sibling();
+            return true;
+        }
+
+        /**
+         * Wakes one parked sibling so it can steal newly posted work.
+         */
+        auto notify_parked_sibling() -> void
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (auto & w : siblings_)
+            {
+                if (&w != this and w.parked_.load(std::memory_order_relaxed))
+                {
+                    w.work_awaiter_.set();
+                    return;
+                }
+            }
+        }
+
+        auto is_running() const -> bool
+        {
+            return not stopped_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * How long the oldest work queued on this worker has waited, at
+         * least.
+         */
+        auto backlog_age(uint64_t now) const -> uint64_t
+        {
+            auto since = backlog_since_.load(std::memory_order_relaxed);
+            return since != 0 and now > since ? now - since : 0;
+        }
+
+        /**
+         * How long this worker has been parked, zero if running.
+         */
+        auto idle_time(uint64_t now) const -> uint64_t
+        {
+            auto since = parked_since_.load(std::memory_order_relaxed);
+            return since != 0 and now > since ? now - since : 0;
+        }
+
+        /**
+         * Marks a worker that has not been started as dormant; posts to it
+         * go to the first worker instead.
+         */
+        auto make_dormant() -> void
+        {
+            dormant_.store(true, std::memory_order_seq_cst);
+        }
+
+        /**
+         * Asks a running worker to hand its queued work to the first
+         * worker and exit its thread.
+         */
+        auto retire() -> void
+        {
+            dormant_.store(true, std::memory_order_seq_cst);
+            work_awaiter_.set();
+        }
+
+        /**
+         * Restarts a dormant worker, waiting for a previous retirement to
+         * finish first.
+         */
+        auto revive() -> void
+        {
+            wait_for_shutdown();
+            parked_since_.store(0, std::memory_order_relaxed);
+            dormant_.store(false, std::memory_order_seq_cst);
+            start();
+        }
+        
+        auto start() -> void
+        {
+            stopped_.store(false, std::memory_order_release);
+
+            thread_ = std::thread([&]() {
+                thread_body();
+            });
+        }
+
+        auto stop() -> void
+        {
+            stopped_.store(true, std::memory_order_release);
+            work_awaiter_.set();
+        }
+
+        auto wait_for_shutdown() -> void
+        {
+            if (thread_.joinable())
+            {
+                thread_.join();
+            }
+        }
+    };
+
+    class thread_pool final
+    {
+    private:
+        // Workers sharing a NUMA node, or all workers when not NUMA aware
+        struct worker_group final
+        {
+            std::optional<size_t> numa_node{};
+            std::vector<size_t> workers{};
+            std::atomic<size_t> next{0};
+        };
+
+        thread_pool_timer timer_;
+        std::vector<thread_pool_worker> workers_{};
+        std::deque<worker_group> groups_{};
+        std::atomic<size_t> next_thread_index_ = 0;
+        std::atomic<size_t> pending_ = 0;
+        awaiter idle_awaiter_;
+        thread_pool_options options_;
+        // Workers [0, num_active_) are running, only the monitor changes it
+        std::atomic<size_t> num_active_ = 0;
+        std::thread monitor_{};
+        std::mutex monitor_mut_{};
+        std::condition_variable monitor_cond_{};
+        bool monitor_stopped_ = false;
+
+        auto min_threads() const -> size_t
+        {
+            return std::clamp<size_t>(options_.min_threads, 1, workers_.size());
+        }
+
+        /**
+         * Starts a worker when queued work has waited too long, or retires
+         * the newest worker once it has idled long enough.
+         */
+        auto adjust_workers() -> void
+        {
+            auto num_active = num_active_.load(std::memory_order_relaxed);
+            auto now = thread_pool_worker::now_ns();
+            auto grow_threshold = static_cast<uint64_t>(options_.grow_threshold.count());
+            auto idle_timeout = static_cast<uint64_t>(options_.idle_timeout.count());
+
+            if (num_active < workers_.size())
+            {
+                for (size_t i = 0; i < num_active; ++i)
+                {
+                    if (workers_[i].backlog_age(now) > grow_threshold)
+                    {
+                        workers_[num_active].revive();
+                        num_active_.store(num_active + 1, std::memory_order_release);
+                        return;
+                    }
+                }
+            }
+
+            if (num_active > min_threads() and workers_[num_active - 1].idle_time(now) > idle_timeout)
+            {
+                // Stop handing it work before it drains its queues
+                num_active_.store(num_active - 1, std::memory_order_release);
+                workers_[num_active - 1].retire();
+            }
+        }
+
+        auto monitor_body() -> void
+        {
+            auto lock = std::unique_lock<std::mutex>{monitor_mut_};
+            while (not monitor_stopped_)
+            {
+                monitor_cond_.wait_for(lock, options_.elastic_interval);
+                if (not monitor_stopped_)
+                {
+                    adjust_workers();
+                }
+            }
+        }
+
+        static auto make_placements(thread_pool_options const & options) -> std::vector<thread_pool_worker_placement>
+        {
+            auto res = std::vector<thread_pool_worker_placement>(options.num_threads);
+            if (options.numa_aware)
+            {
+                auto nodes = read_numa_nodes(options.numa_sysfs_root);
+                size_t index = 0;
+                size_t group = 0;
+                for (size_t n = 0; n < nodes.size(); ++n)
+                {
+                    // Spread evenly, earlier nodes take the remainder
+                    auto count = options.num_threads / nodes.size() + (n < options.num_threads % nodes.size() ? 1 : 0);
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        res[index++] = {group, nodes[n].id, nodes[n].cpus};
+                    }
+                    if (count > 0)
+                    {
+                        ++group;
+                    }
+                }
+            }
+            else if (not options.cpus.empty())
+            {
+                for (size_t i = 0; i < res.size(); ++i)
+                {
+                    res[i].cpus = {options.cpus[i % options.cpus.size()]};
+                }
+            }
+            return res;
+        }
+
+        auto post_to(thread_pool_worker & w, std::unique_ptr<thread_pool_work> && c) -> bool
+        {
+            pending_.fetch_add(1, std::memory_order_acq_rel);
+            if (not w.post(std::move(c)))
+            {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                return false;
+            }
+            return true;
+        }
+
+        auto next_worker() -> thread_pool_worker &
+        {
+            auto index = next_thread_index_.fetch_add(1, std::memory_order_acq_rel);
+            if (index >= num_active_.load(std::memory_order_acquire))
+            {
+                next_thread_index_.store(0, std::memory_order_release);
+                index = 0;
+            }
+            return workers_[index];
+        }
+
+        auto resume_work(thread_pool_work * w) -> void
+        {
+            // Delayed work was already counted as pending when first posted
+            auto work = std::unique_ptr<thread_pool_work>{w};
+            if (not next_worker().post(std::move(work)))
+            {
+                // Stopping, cut the chain short so its waiters wake
+                work->complete();
+                work.reset();
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+    public:
+        thread_pool(thread_pool_options const & options)
+            : timer_([this](thread_pool_work * w) { resume_work(w); }, options.timer_resolution)
+            , options_(options)
+        {
+            workers_.reserve(options.num_threads);
+            for (auto & placement : make_placements(options_))
+            {
+                if (groups_.size() <= placement.group)
+                {
+                    groups_.emplace_back().numa_node = placement.numa_node;
+                }
+                groups_[placement.group].workers.emplace_back(workers_.size());
+                workers_.emplace_back(idle_awaiter_, pending_, workers_, timer_, options_, std::move(placement));
+            }
+
+            num_active_.store(options_.elastic ? min_threads() : workers_.size(), std::memory_order_release);
+            for (auto i = num_active_.load(std::memory_order_relaxed); i < workers_.size(); ++i)
+            {
+                workers_[i].make_dormant();
+            }
+        }
+
+        thread_pool(size_t num_threads, thread_pool_scheduling scheduling = thread_pool_scheduling::round_robin)
+            : thread_pool(thread_pool_options{num_threads, scheduling})
+        {
+        }
+
+        ~thread_pool()
+        {
+            stop_workers();
+        }
+
+        auto options() const -> thread_pool_options const &
+        {
+            return options_;
+        }
+
+        auto post_work(std::unique_ptr<thread_pool_work> && c) -> bool
+        {
+            pending_.fetch_add(1, std::memory_order_acq_rel);
+            if (options_.scheduling == thread_pool_scheduling::work_stealing)
+            {
+                // Work spawned from within the pool stays on the spawning
+                // worker's deque where idle siblings can steal it
+                if (auto w = thread_pool_worker::current_in(workers_); w)
+                {
+                    if (w->post_local(std::move(c)))
+                    {
+                        return true;
+                    }
+                    pending_.fetch_sub(1, std::memory_order_acq_rel);
+                    return false;
+                }
+            }
+
+            if (not next_worker().post(std::move(c)))
+            {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Posts work on the given priority lane, 0 being the most urgent.
+         */
+        auto post_work(std::unique_ptr<thread_pool_work> && c, size_t priority) -> bool
+        {
+            c->set_priority(priority);
+            return post_work(std::move(c));
+        }
+
+        /**
+         * Posts work to the sub-pool on the hinted NUMA node.  Behaves like
+         * post_work(c) if the pool is not NUMA aware or has no workers on
+         * that node.
+         */
+        auto post_work(std::unique_ptr<thread_pool_work> && c, thread_pool_locality locality) -> bool
+        {
+            for (auto & g : groups_)
+            {
+                if (not g.numa_node or *g.numa_node != locality.numa_node)
+                {
+                    continue;
+                }
+
+                auto current = thread_pool_worker::current_in(workers_);
+                if (current and &groups_[current->placement().group] == &g)
+                {
+                    // Already on the right node
+                    return post_work(std::move(c));
+                }
+                auto index = g.next.fetch_add(1, std::memory_order_relaxed) % g.workers.size();
+                return post_to(workers_[g.workers[index]], std::move(c));
+            }
+            return post_work(std::move(c));
+        }
+
+        auto wait_for_idle() -> void
+        {
+            while (pending_.load(std::memory_order_relaxed) > 0)
+            {
+                idle_awaiter_.wait_and_reset();
+            }
+        }
+
+        /**
+         * Maximum number of workers.
+         */
+        auto num_threads() const -> size_t
+        {
+            return workers_.size();
+        }
+
+        /**
+         * Workers currently running, below num_threads() while an elastic
+         * pool is lightly loaded.
+         */
+        auto num_active_threads() const -> size_t
+        {
+            return num_active_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * NUMA nodes the pool has workers on, empty if not NUMA aware.
+         */
+        auto numa_nodes() const -> std::vector<size_t>
+        {
+            auto res = std::vector<size_t>{};
+            for (auto const & g : groups_)
+            {
+                if (g.numa_node)
+                {
+                    res.emplace_back(*g.numa_node);
+                }
+            }
+            return res;
+        }
+
+        auto worker_placement(size_t index) const -> thread_pool_worker_placement const &
+        {
+            return workers_[index].placement();
+        }
+
+        /**
+         * Aggregates per-worker telemetry without stopping the workers.
+         * Counters are read one at a time, so totals may be slightly out of
+         * step with each other while work is running.
+         */
+        auto stats() const -> thread_pool_stats
+        {
+            auto res = thread_pool_stats{};
+            res.num_pending = pending_.load(std::memory_order_relaxed);
+            res.num_active_threads = num_active_threads();
+            for (auto const & w : workers_)
+            {
+                res.workers.emplace_back(w.stats());
+                res.total.merge(res.workers.back());
+            }
+            return res;
+        }
+
+        /**
+         * Runs one piece of queued work on the calling thread, if any is
+         * available.  A thread waiting on work it posted can call this in a
+         * loop to help the pool instead of blocking.
+         *
+         * \return true if work was run
+         */
+        auto try_run_one() -> bool
+        {
+            if (auto w = thread_pool_worker::current_in(workers_); w)
+            {
+                return w->help_self();
+            }
+
+            auto num_workers = workers_.size();
+            auto start = next_thread_index_.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < num_workers; ++i)
+            {
+                if (workers_[(start + i) % num_workers].help())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        auto start_workers() -> void
+        {
+            auto num_active = num_active_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < num_active; ++i)
+            {
+                workers_[i].start();
+            }
+            if (options_.elastic and workers_.size() > min_threads() and not monitor_.joinable())
+            {
+                auto lock = std::unique_lock<std::mutex>{monitor_mut_};
+                monitor_stopped_ = false;
+                monitor_ = std::thread([this]() {
+                    monitor_body();
+                });
+            }
+        }
+
+        auto stop_workers() -> void
+        {
+            {
+                auto lock = std::unique_lock<std::mutex>{monitor_mut_};
+                monitor_stopped_ = true;
+            }
+            monitor_cond_.notify_one();
+            if (monitor_.joinable())
+            {
+                monitor_.join();
+            }
+
+            // Work still waiting on a delay will never resume, complete it
+            // so its waiters wake
+            timer_.stop([this](thread_pool_work * w) {
+                w->complete();
+                delete w;
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            });
             for (auto & w : workers_)
             {
                 w.stop();
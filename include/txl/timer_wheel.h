@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace txl
+{
+    /**
+     * Hierarchical timing wheel keyed on absolute ticks.
+     *
+     * Each level has 64 slots and covers 64 times the span of the level
+     * below it.  Scheduling is O(1); entries in upper levels cascade down
+     * as the wheel's cursor reaches their slot.  The wheel has no notion of
+     * time itself, callers translate clocks into ticks.
+     *
+     * \tparam Value value type stored per timer
+     */
+    template<class Value>
+    class timer_wheel final
+    {
+    private:
+        static constexpr size_t slot_bits = 6;
+        static constexpr size_t num_slots = size_t{1} << slot_bits;
+        static constexpr uint64_t slot_mask = num_slots - 1;
+        static constexpr size_t num_levels = 8;
+        // Deadlines further out than this are clamped and re-cascaded
+        static constexpr uint64_t max_delta = (uint64_t{1} << (slot_bits * num_levels)) - 1;
+
+        struct entry final
+        {
+            uint64_t deadline;
+            Value val;
+        };
+
+        using slot = std::vector<entry>;
+
+        std::array<std::array<slot, num_slots>, num_levels> levels_{};
+        uint64_t current_ = 0;
+        size_t size_ = 0;
+
+        static auto level_of(uint64_t deadline, uint64_t current) -> size_t
+        {
+            // Highest 6-bit group in which deadline and cursor differ
+            auto diff = deadline ^ current;
+            size_t level = 0;
+            while (level + 1 < num_levels and (diff >> (slot_bits * (level + 1))) != 0)
+            {
+                ++level;
+            }
+            return level;
+        }
+
+        static auto slot_of(uint64_t deadline, size_t level) -> size_t
+        {
+            return static_cast<size_t>((deadline >> (slot_bits * level)) & slot_mask);
+        }
+
+        auto place(entry && e) -> void
+        {
+            auto target = e.deadline;
+            if (target - current_ > max_delta)
+            {
+                target = current_ + max_delta;
+            }
+            auto level = level_of(target, current_);
+            levels_[level][slot_of(target, level)].emplace_back(std::move(e));
+        }
+
+        auto cascade(size_t level) -> void
+        {
+            auto & s = levels_[level][slot_of(current_, level)];
+            if (s.empty())
+            {
+                return;
+            }
+            auto moved = slot{};
+            std::swap(moved, s);
+            for (auto & e : moved)
+            {
+                place(std::move(e));
+            }
+        }
+
+        template<class OnExpireFunc>
+        auto tick(OnExpireFunc & on_expire) -> void
+        {
+            ++current_;
+            // Cascade from the top down so entries can land in level 0 this tick
+            for (auto level = num_levels - 1; level > 0; --level)
+            {
+                if ((current_ & ((uint64_t{1} << (slot_bits * level)) - 1)) == 0)
+                {
+                    cascade(level);
+                }
+            }
+
+            auto & s = levels_[0][slot_of(current_, 0)];
+            if (s.empty())
+            {
+                return;
+            }
+            auto expired = slot{};
+            std::swap(expired, s);
+            for (auto & e : expired)
+            {
+                if (e.deadline > current_)
+                {
+                    // Clamped entry that still has time remaining
+                    place(std::move(e));
+                    continue;
+                }
+                --size_;
+                on_expire(std::move(e.val));
+            }
+        }
+    public:
+        /**
+         * Constructs an empty wheel.
+         *
+         * \param now starting tick
+         */
+        timer_wheel(uint64_t now = 0)
+            : current_{now}
+        {
+        }
+
+        auto size() const -> size_t { return size_; }
+        auto empty() const -> bool { return size_ == 0; }
+        auto now() const -> uint64_t { return current_; }
+
+        /**
+         * Schedules a value to expire at an absolute tick.
+         *
+         * \param deadline tick at which the value expires
+         * \param val value handed back on expiry
+         * \return false if the deadline has already passed, in which case the
+         *         value is not stored
+         */
+        auto schedule(uint64_t deadline, Value val) -> bool
+        {
+            if (deadline <= current_)
+            {
+                return false;
+            }
+            place(entry{deadline, std::move(val)});
+            ++size_;
+            return true;
+        }
+
+        /**
+         * Advances the wheel up to (and including) tick now.
+         *
+         * \param now tick to advance to
+         * \param on_expire function of type: (Value &&) -> void
+         */
+        template<class OnExpireFunc>
+        auto advance(uint64_t now, OnExpireFunc && on_expire) -> void
+        {
+            if (empty())
+            {
+                current_ = std::max(current_, now);
+                return;
+            }
+            while (current_ < now)
+            {
+                tick(on_expire);
+            }
+        }
+
+        /**
+         * Removes all scheduled values without expiring them.
+         *
+         * \param on_value function of type: (Value &&) -> void
+         */
+        template<class OnValueFunc>
+        auto clear(OnValueFunc && on_value) -> void
+        {
+            for (auto & level : levels_)
+            {
+                for (auto & s : level)
+                {
+                    for (auto & e : s)
+                    {
+                        on_value(std::move(e.val));
+                    }
+                    s.clear();
+                }
+            }
+            size_ = 0;
+        }
+
+        /**
+         * Number of ticks until the wheel next needs to advance, either to
+         * expire a level 0 entry or to cascade an upper level.  Returns 0 if
+         * the wheel is empty.
+         */
+        auto ticks_until_next() const -> uint64_t
+        {
+            if (empty())
+            {
+                return 0;
+            }
+            for (uint64_t i = 1; i <= num_slots; ++i)
+            {
+                auto t = current_ + i;
+                if (not levels_[0][slot_of(t, 0)].empty())
+                {
+                    return i;
+                }
+                if ((t & slot_mask) == 0)
+                {
+                    // Level 0 wraps here and upper levels may cascade
+                    return i;
+                }
+            }
+            return num_slots;
+        }
+    };
+}
@@ -1,18 +1,26 @@
 #pragma once
 
+#include <txl/object_pool.h>
+
+#include <iostream>
 #include <memory>
+#include <string>
 #include <utility>
 
 namespace txl
 {
-    template<class Key, class Value, template<class> class Less = std::less>
+    /**
+     * \tparam NodePolicy heap_nodes, or slab_nodes to keep nodes together in
+     *                    memory
+     */
+    template<class Key, class Value, template<class> class Less = std::less, class NodePolicy = heap_nodes>
     class binary_search_tree final
     {
     public:
         using kv_pair = std::pair<Key, Value>;
     private:
         struct node;
-        using node_ptr = std::unique_ptr<node>;
+        using node_ptr = node_unique_ptr<node, NodePolicy>;
 
         struct node_pair final
         {
@@ -233,7 +241,7 @@ namespace txl
             auto data = std::make_pair(std::move(key), std::move(value));
             if (root_ == nullptr)
             {
-                root_ = std::make_unique<node>(std::move(data));
+                root_ = make_node<node, NodePolicy>(std::move(data));
                 return;
             }
 
@@ -262,11 +270,11 @@ namespace txl
             }
             if (cmp(data.first, n->data_.first))
             {
-                n->children_.left_ = std::make_unique<node>(std::move(data));
+                n->children_.left_ = make_node<node, NodePolicy>(std::move(data));
             }
             else
             {
-                n->children_.right_ = std::make_unique<node>(std::move(data));
+                n->children_.right_ = make_node<node, NodePolicy>(std::move(data));
             }
         }
     };
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <functional>
+#include <memory_resource>
 #include <vector>
 #include <optional>
 
@@ -84,4 +85,14 @@ namespace txl
             return {};
         }
     };
+
+    namespace pmr
+    {
+        /**
+         * txl::vector allocating from a std::pmr::memory_resource, such as an
+         * arena_resource.
+         */
+        template<class Value>
+        using vector = txl::vector<Value, std::pmr::polymorphic_allocator<Value>>;
+    }
 }
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace txl
+{
+    /**
+     * Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+     * Work-Stealing for Weak Memory Models").
+     *
+     * A single owner thread pushes and pops at the bottom (LIFO) while any
+     * number of thief threads steal from the top (FIFO).  The backing ring
+     * grows on demand; retired rings are kept alive until destruction since
+     * a thief may still be reading from them.
+     *
+     * \tparam Value trivially copyable element type (typically a pointer)
+     */
+    template<class Value>
+    class work_stealing_deque final
+    {
+        static_assert(std::is_trivially_copyable_v<Value>, "work_stealing_deque values must be trivially copyable");
+    private:
+        class ring final
+        {
+        private:
+            size_t mask_;
+            std::unique_ptr<std::atomic<Value>[]> items_;
+        public:
+            ring(size_t capacity)
+                : mask_{capacity - 1}
+                , items_{std::make_unique<std::atomic<Value>[]>(capacity)}
+            {
+            }
+
+            auto capacity() const -> size_t { return mask_ + 1; }
+
+            auto get(int64_t index) const -> Value
+            {
+                return items_[static_cast<size_t>(index) & mask_].load(std::memory_order_relaxed);
+            }
+
+            auto put(int64_t index, Value v) -> void
+            {
+                items_[static_cast<size_t>(index) & mask_].store(v, std::memory_order_relaxed);
+            }
+
+            auto grow(int64_t top, int64_t bottom) const -> std::unique_ptr<ring>
+            {
+                auto r = std::make_unique<ring>(capacity() << 1);
+                for (auto i = top; i < bottom; ++i)
+                {
+                    r->put(i, get(i));
+                }
+                return r;
+            }
+        };
+
+        alignas(64) std::atomic<int64_t> top_{0};
+        alignas(64) std::atomic<int64_t> bottom_{0};
+        std::atomic<ring *> ring_{nullptr};
+        // Owned by the pushing thread; holds the active ring and all retired rings
+        std::vector<std::unique_ptr<ring>> rings_{};
+
+        static auto round_capacity(size_t capacity) -> size_t
+        {
+            size_t res = 2;
+            while (res < capacity)
+            {
+                res <<= 1;
+            }
+            return res;
+        }
+    public:
+        /**
+         * Constructs an empty deque.
+         *
+         * \param capacity initial capacity, rounded up to a power of 2
+         */
+        work_stealing_deque(size_t capacity = 64)
+        {
+            rings_.emplace_back(std::make_unique<ring>(round_capacity(capacity)));
+            ring_.store(rings_.back().get(), std::memory_order_release);
+        }
+
+        work_stealing_deque(work_stealing_deque const &) = delete;
+        work_stealing_deque(work_stealing_deque &&) = delete;
+
+        auto operator=(work_stealing_deque const &) -> work_stealing_deque & = delete;
+        auto operator=(work_stealing_deque &&) -> work_stealing_deque & = delete;
+
+        /**
+         * Approximate number of items, exact only when called by the owner
+         * with no concurrent thieves.
+         */
+        auto size() const -> size_t
+        {
+            auto b = bottom_.load(std::memory_order_relaxed);
+            auto t = top_.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        auto empty() const -> bool
+        {
+            return size() == 0;
+        }
+
+        auto capacity() const -> size_t
+        {
+            return ring_.load(std::memory_order_relaxed)->capacity();
+        }
+
+        /**
+         * Pushes a value onto the bottom of the deque.  Owner thread only.
+         */
+        auto push(Value v) -> void
+        {
+            auto b = bottom_.load(std::memory_order_relaxed);
+            auto t = top_.load(std::memory_order_acquire);
+            auto r = ring_.load(std::memory_order_relaxed);
+            if (b - t > static_cast<int64_t>(r->capacity()) - 1)
+            {
+                rings_.emplace_back(r->grow(t, b));
+                r = rings_.back().get();
+                ring_.store(r, std::memory_order_release);
+            }
+            r->put(b, v);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * Pops the most recently pushed value.  Owner thread only.
+         */
+        auto pop() -> std::optional<Value>
+        {
+            auto b = bottom_.load(std::memory_order_relaxed) - 1;
+            auto r = ring_.load(std::memory_order_relaxed);
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto t = top_.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // Empty
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                return {};
+            }
+
+            auto v = r->get(b);
+            if (t == b)
+            {
+                // Last item, race against thieves for it
+                auto won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                bottom_.store(b + 1, std::memory_order_relaxed);
+                if (not won)
+                {
+                    return {};
+                }
+            }
+            return v;
+        }
+
+        /**
+         * Steals the least recently pushed value.  Safe from any thread; may
+         * spuriously fail when racing with another thief or the owner.
+         */
+        auto steal() -> std::optional<Value>
+        {
+            auto t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto b = bottom_.load(std::memory_order_acquire);
+
+            if (t >= b)
+            {
+                return {};
+            }
+
+            auto r = ring_.load(std::memory_order_acquire);
+            auto v = r->get(t);
+            if (not top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return {};
+            }
+            return v;
+        }
+    };
+}
@@ -0,0 +1,60 @@
+#include <txl/arena.h>
+#include <txl/vector.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+// Time to build and tear down a request worth of header strings, from the
+// heap against from an arena reset after every request.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t num_requests = 200000;
+static constexpr size_t num_headers = 24;
+static constexpr std::string_view header = "X-Forwarded-For: 203.0.113.195, 70.41.3.18, 150.172.238.178";
+
+template<class BuildRequest>
+auto run_bench(std::string_view name, BuildRequest && build_request) -> void
+{
+    size_t total = 0;
+    auto start = bench_clock::now();
+    for (size_t i = 0; i < num_requests; ++i)
+    {
+        total += build_request();
+    }
+    auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+    std::cout << name << ": " << static_cast<uint64_t>(num_requests / elapsed / 1000.0) << " krequests/s"
+              << " (" << total << " bytes)" << std::endl;
+}
+
+int main()
+{
+    run_bench("std::allocator", []() {
+        auto headers = txl::vector<std::string>{};
+        for (size_t h = 0; h < num_headers; ++h)
+        {
+            headers.emplace_back(header);
+        }
+        return headers.size() * headers.back().size();
+    });
+
+    auto a = txl::arena{};
+    auto res = txl::arena_resource{a};
+    run_bench("arena", [&]() {
+        size_t n = 0;
+        {
+            auto headers = txl::pmr::vector<std::pmr::string>{&res};
+            for (size_t h = 0; h < num_headers; ++h)
+            {
+                headers.emplace_back(header);
+            }
+            n = headers.size() * headers.back().size();
+        }
+        a.reset();
+        return n;
+    });
+    return 0;
+}
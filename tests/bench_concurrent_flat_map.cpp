@@ -0,0 +1,107 @@
+#include <txl/concurrent_flat_map.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Lookup throughput of concurrent_flat_map against a mutex-protected
+// std::unordered_map, with every thread looking up keys from a connection
+// table while one writer keeps replacing entries.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr int num_keys = 100000;
+static constexpr size_t num_lookups_per_thread = 2000000;
+
+struct concurrent_adapter
+{
+    txl::concurrent_flat_map<int, uint64_t> m{num_keys * 2};
+
+    auto find(int key) -> std::optional<uint64_t> { return m.find(key); }
+    auto assign(int key, uint64_t value) -> void { m.insert_or_assign(key, value); }
+};
+
+struct locked_map_adapter
+{
+    std::mutex mut{};
+    std::unordered_map<int, uint64_t> m{};
+
+    auto find(int key) -> std::optional<uint64_t>
+    {
+        auto lock = std::unique_lock<std::mutex>{mut};
+        if (auto it = m.find(key); it != m.end())
+        {
+            return it->second;
+        }
+        return {};
+    }
+
+    auto assign(int key, uint64_t value) -> void
+    {
+        auto lock = std::unique_lock<std::mutex>{mut};
+        m[key] = value;
+    }
+};
+
+template<class Adapter>
+auto run_bench(std::string_view name, size_t num_threads) -> void
+{
+    auto a = Adapter{};
+    for (auto i = 0; i < num_keys; ++i)
+    {
+        a.assign(i, i);
+    }
+
+    auto done = std::atomic<bool>{false};
+    auto writer = std::thread{[&]() {
+        for (uint64_t i = 0; not done.load(std::memory_order_relaxed); ++i)
+        {
+            a.assign(static_cast<int>(i % num_keys), i);
+        }
+    }};
+
+    auto found = std::atomic<size_t>{0};
+    auto start = bench_clock::now();
+    auto threads = std::vector<std::thread>{};
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&a, &found, t]() {
+            size_t n = 0;
+            auto key = static_cast<int>(t * 7919);
+            for (size_t i = 0; i < num_lookups_per_thread; ++i)
+            {
+                key = (key + 7919) % num_keys;
+                n += a.find(key).has_value();
+            }
+            found.fetch_add(n);
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+    done.store(true);
+    writer.join();
+
+    auto num_lookups = static_cast<double>(num_threads * num_lookups_per_thread);
+    std::cout << name << " x" << num_threads
+              << ": " << static_cast<uint64_t>(num_lookups / elapsed / 1000.0) << " klookups/s"
+              << " (" << found.load() << " found)" << std::endl;
+}
+
+int main()
+{
+    for (size_t num_threads : {1, 2, 4, 8, 16})
+    {
+        run_bench<concurrent_adapter>("concurrent_flat_map", num_threads);
+        run_bench<locked_map_adapter>("mutex std::unordered_map", num_threads);
+    }
+    return 0;
+}
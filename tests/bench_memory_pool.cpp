@@ -0,0 +1,82 @@
+#include <txl/memory_pool.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Allocation throughput of memory_pool chunks against reference counted
+// heap buffers, with every thread renting a 4096 byte buffer, sharing a
+// copy of it and dropping both, the way the io_reactor uses its pool.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t buffer_size = 4096;
+static constexpr size_t num_allocs_per_thread = 500000;
+
+struct pool_adapter
+{
+    txl::memory_pool mp{1024, 4096};
+
+    auto run_once() -> bool
+    {
+        auto c = mp.allocate(buffer_size);
+        if (c.empty())
+        {
+            return false;
+        }
+        std::memset(c.data(), 0, 64);
+        auto copy = c;
+        return copy.data() != nullptr;
+    }
+};
+
+struct heap_adapter
+{
+    auto run_once() -> bool
+    {
+        auto c = std::shared_ptr<uint8_t[]>{new uint8_t[buffer_size]};
+        std::memset(c.get(), 0, 64);
+        auto copy = c;
+        return copy.get() != nullptr;
+    }
+};
+
+template<class Adapter>
+auto run_bench(std::string_view name, size_t num_threads) -> void
+{
+    auto a = Adapter{};
+    auto start = bench_clock::now();
+    auto threads = std::vector<std::thread>{};
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&a]() {
+            for (size_t i = 0; i < num_allocs_per_thread; ++i)
+            {
+                a.run_once();
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    auto num_allocs = static_cast<double>(num_threads * num_allocs_per_thread);
+    std::cout << name << " x" << num_threads
+              << ": " << static_cast<uint64_t>(num_allocs / elapsed / 1000.0) << " kallocs/s" << std::endl;
+}
+
+int main()
+{
+    for (size_t num_threads : {1, 2, 4, 8, 16})
+    {
+        run_bench<pool_adapter>("memory_pool", num_threads);
+        run_bench<heap_adapter>("shared_ptr heap buffer", num_threads);
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <txl/linked_list.h>
+#include <txl/mpmc_queue.h>
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Throughput of mpmc_queue against atomic_linked_list, with heap nodes under
+// each reclaimer and with pooled nodes, and a mutex-protected std::queue.
+// Every thread alternates a push with a pop, so each structure stays small
+// and the numbers reflect contention on its ends.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t num_ops_per_thread = 200000;
+
+struct mpmc_adapter
+{
+    txl::mpmc_queue<size_t> q{1024};
+
+    auto push(size_t v) -> void { q.push(v); }
+    auto pop() -> std::optional<size_t> { return q.try_pop(); }
+};
+
+template<class NodePolicy, class Reclaimer>
+struct linked_list_adapter
+{
+    txl::atomic_linked_list<size_t, NodePolicy, Reclaimer> l{};
+
+    auto push(size_t v) -> void { l.push_front(v); }
+    auto pop() -> std::optional<size_t> { return l.pop_and_release_front(); }
+};
+
+struct locked_queue_adapter
+{
+    std::mutex mut{};
+    std::queue<size_t> q{};
+
+    auto push(size_t v) -> void
+    {
+        auto lock = std::unique_lock<std::mutex>{mut};
+        q.push(v);
+    }
+
+    auto pop() -> std::optional<size_t>
+    {
+        auto lock = std::unique_lock<std::mutex>{mut};
+        if (q.empty())
+        {
+            return {};
+        }
+        auto v = q.front();
+        q.pop();
+        return v;
+    }
+};
+
+template<class Adapter>
+static auto run_bench(std::string_view name, size_t num_threads) -> void
+{
+    auto a = Adapter{};
+    auto threads = std::vector<std::thread>{};
+    auto start = bench_clock::now();
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&a]() {
+            for (size_t i = 0; i < num_ops_per_thread; ++i)
+            {
+                a.push(i);
+                while (not a.pop())
+                {
+                }
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+    auto num_ops = 2.0 * static_cast<double>(num_ops_per_thread * num_threads);
+    std::cout << name << " x" << num_threads
+              << ": " << static_cast<uint64_t>(num_ops / elapsed / 1000.0) << " kops/s" << std::endl;
+}
+
+int main()
+{
+    for (size_t num_threads : {1, 2, 4, 8, 16, 32})
+    {
+        run_bench<mpmc_adapter>("mpmc_queue", num_threads);
+        run_bench<linked_list_adapter<txl::heap_nodes, txl::epoch_reclaimer>>("atomic_linked_list epoch", num_threads);
+        run_bench<linked_list_adapter<txl::heap_nodes, txl::hazard_reclaimer>>("atomic_linked_list hazard", num_threads);
+        run_bench<linked_list_adapter<txl::pooled_nodes, txl::immediate_reclaimer>>("atomic_linked_list pooled", num_threads);
+        run_bench<locked_queue_adapter>("mutex std::queue", num_threads);
+    }
+    return 0;
+}
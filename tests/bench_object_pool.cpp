@@ -0,0 +1,79 @@
+#include <txl/btree.h>
+#include <txl/tree.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+// Time to build a tree of random keys and look every key up again, with
+// nodes from the heap against nodes carved out of slabs.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr int num_keys = 200000;
+static constexpr int num_rounds = 5;
+
+template<class BuildAndFind>
+auto run_bench(std::string_view name, std::vector<int> const & keys, BuildAndFind && build_and_find) -> void
+{
+    size_t found = 0;
+    auto start = bench_clock::now();
+    for (auto i = 0; i < num_rounds; ++i)
+    {
+        found += build_and_find(keys);
+    }
+    auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+    std::cout << name << ": " << static_cast<uint64_t>(num_rounds * num_keys / elapsed / 1000.0) << " kkeys/s"
+              << " (" << found << " found)" << std::endl;
+}
+
+template<class Tree>
+auto build_and_find_bst(std::vector<int> const & keys) -> size_t
+{
+    auto t = Tree{};
+    for (auto k : keys)
+    {
+        t.emplace(int{k}, int{k});
+    }
+    size_t found = 0;
+    for (auto k : keys)
+    {
+        found += t.find(k) != nullptr;
+    }
+    return found;
+}
+
+template<class Tree>
+auto build_and_find_btree(std::vector<int> const & keys) -> size_t
+{
+    auto t = Tree{8};
+    for (auto k : keys)
+    {
+        t.insert(int{k}, int{k});
+    }
+    size_t found = 0;
+    for (auto k : keys)
+    {
+        found += t.find(k) != nullptr;
+    }
+    return found;
+}
+
+int main()
+{
+    auto keys = std::vector<int>(num_keys);
+    for (auto i = 0; i < num_keys; ++i)
+    {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{42});
+
+    run_bench("binary_search_tree heap_nodes", keys, build_and_find_bst<txl::binary_search_tree<int, int, std::less, txl::heap_nodes>>);
+    run_bench("binary_search_tree slab_nodes", keys, build_and_find_bst<txl::binary_search_tree<int, int, std::less, txl::slab_nodes>>);
+    run_bench("btree heap_nodes", keys, build_and_find_btree<txl::btree<int, int, txl::heap_nodes>>);
+    run_bench("btree slab_nodes", keys, build_and_find_btree<txl::btree<int, int, txl::slab_nodes>>);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <txl/parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Scaling of parallel_sort with the number of workers against std::sort.
+// The merge rounds are split across the pool as well, so the speedup should
+// keep growing with the worker count rather than flatten at the final merge.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t num_items = 1 << 24;
+static constexpr size_t num_reps = 3;
+
+static auto make_values() -> std::vector<uint64_t>
+{
+    auto rng = std::mt19937_64{42};
+    auto values = std::vector<uint64_t>(num_items);
+    for (auto & v : values)
+    {
+        v = rng();
+    }
+    return values;
+}
+
+template<class Sort>
+static auto time_sort(std::vector<uint64_t> const & input, Sort && sort) -> double
+{
+    auto best = 0.0;
+    for (size_t rep = 0; rep < num_reps; ++rep)
+    {
+        auto values = input;
+        auto start = bench_clock::now();
+        sort(values);
+        auto elapsed = std::chrono::duration<double>(bench_clock::now() - start).count();
+        if (not std::is_sorted(values.begin(), values.end()))
+        {
+            std::cerr << "not sorted" << std::endl;
+            std::exit(1);
+        }
+        best = rep == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+static auto report(std::string_view name, double elapsed, double baseline) -> void
+{
+    std::cout << name << ": " << static_cast<uint64_t>(elapsed * 1000.0) << " ms"
+              << ", " << baseline / elapsed << "x std::sort" << std::endl;
+}
+
+int main()
+{
+    auto input = make_values();
+    auto baseline = time_sort(input, [](auto & values) {
+        std::sort(values.begin(), values.end());
+    });
+    report("std::sort", baseline, baseline);
+
+    auto max_threads = static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        auto pool = txl::thread_pool{num_threads};
+        pool.start_workers();
+        auto elapsed = time_sort(input, [&pool](auto & values) {
+            txl::parallel_sort(pool, values.begin(), values.end());
+        });
+        pool.stop_workers();
+        report("parallel_sort x" + std::to_string(num_threads), elapsed, baseline);
+    }
+    return 0;
+}
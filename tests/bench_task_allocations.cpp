@@ -0,0 +1,81 @@
+#include <txl/tasks.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string_view>
+
+// Counts calls to the global allocator while repeatedly running pre-built
+// tasks, after a warm-up that fills the block caches.  Steady state should
+// report zero allocations per run.
+
+static std::atomic<size_t> num_allocations{0};
+
+auto operator new(size_t num_bytes) -> void *
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto p = std::malloc(num_bytes == 0 ? 1 : num_bytes); p)
+    {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+auto operator delete(void * p) noexcept -> void
+{
+    std::free(p);
+}
+
+auto operator delete(void * p, size_t) noexcept -> void
+{
+    std::free(p);
+}
+
+static constexpr size_t num_warmup = 10000;
+static constexpr size_t num_runs = 100000;
+
+static auto run_bench(std::string_view name, txl::task_runner & runner) -> void
+{
+    auto counter = 0;
+    auto t = txl::make_task<int>([&counter]() {
+        return ++counter;
+    }).then([](auto & ctx) {
+        return ctx.result() * 2;
+    }).then([](auto & ctx) {
+        return ctx.result() + 1;
+    });
+
+    for (size_t i = 0; i < num_warmup; ++i)
+    {
+        t(runner);
+    }
+
+    auto before = num_allocations.load();
+    for (size_t i = 0; i < num_runs; ++i)
+    {
+        t(runner);
+    }
+    auto after = num_allocations.load();
+
+    std::cout << name
+              << ": " << (after - before) << " allocations in " << num_runs << " runs"
+              << " (" << static_cast<double>(after - before) / num_runs << " per run)" << std::endl;
+}
+
+int main()
+{
+    {
+        auto runner = txl::inline_task_runner{};
+        run_bench("inline", runner);
+    }
+    {
+        auto runner = txl::thread_pool_task_runner{1};
+        run_bench("thread_pool x1", runner);
+    }
+    {
+        auto runner = txl::thread_pool_task_runner{4};
+        run_bench("thread_pool x4", runner);
+    }
+    return 0;
+}
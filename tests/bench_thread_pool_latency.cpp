@@ -0,0 +1,69 @@
+#include <txl/threading.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+// Measures time-in-queue (post to start of execution) for a thread_pool under
+// sustained load and prints the latency distribution for each ordering policy.
+
+using bench_clock = std::chrono::steady_clock;
+
+static constexpr size_t num_threads = 4;
+static constexpr size_t num_jobs = 200000;
+
+static auto spin_for(std::chrono::nanoseconds d) -> void
+{
+    auto until = bench_clock::now() + d;
+    while (bench_clock::now() < until)
+    {
+    }
+}
+
+static auto run_bench(std::string_view name, txl::thread_pool_options const & options) -> void
+{
+    std::vector<int64_t> latencies(num_jobs);
+    auto tp = txl::thread_pool{options};
+    tp.start_workers();
+
+    for (size_t i = 0; i < num_jobs; ++i)
+    {
+        auto posted = bench_clock::now();
+        // Skewed mix: mostly short jobs with the occasional long one
+        auto cost = (i % 100 == 0) ? std::chrono::microseconds{200} : std::chrono::microseconds{2};
+        tp.post_work(txl::make_thread_pool_lambda([&latencies, i, posted, cost]() {
+            latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - posted).count();
+            spin_for(cost);
+        }));
+        // Offer load just under what the pool can drain
+        if (i % num_threads == 0)
+        {
+            spin_for(std::chrono::microseconds{1});
+        }
+    }
+    tp.wait_for_idle();
+    tp.stop_workers();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&latencies](double p) {
+        auto index = static_cast<size_t>(p * static_cast<double>(latencies.size() - 1));
+        return latencies[index] / 1000;
+    };
+    std::cout << name
+              << ": p50=" << pct(0.5) << "us"
+              << " p99=" << pct(0.99) << "us"
+              << " p99.9=" << pct(0.999) << "us"
+              << " max=" << latencies.back() / 1000 << "us" << std::endl;
+}
+
+int main()
+{
+    run_bench("lifo", {num_threads, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::lifo});
+    run_bench("fifo", {num_threads, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::fifo});
+    run_bench("fifo batch=16", {num_threads, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::fifo, 16});
+    run_bench("fifo work_stealing", {num_threads, txl::thread_pool_scheduling::work_stealing, txl::thread_pool_ordering::fifo});
+    return 0;
+}
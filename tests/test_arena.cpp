@@ -0,0 +1,109 @@
+#include <txl/arena.h>
+#include <txl/flat_map.h>
+#include <txl/unit_test.h>
+#include <txl/vector.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using namespace std::literals;
+
+TXL_UNIT_TEST(arena_bump)
+{
+    auto a = txl::arena{1024};
+    auto p1 = static_cast<std::byte *>(a.allocate(10, 1));
+    auto p2 = static_cast<std::byte *>(a.allocate(10, 1));
+    assert_true(p2 == p1 + 10);
+
+    auto p3 = a.allocate(8, 64);
+    assert_equal(reinterpret_cast<uintptr_t>(p3) % 64, uintptr_t{0});
+
+    auto v = a.make<uint64_t>(42u);
+    assert_equal(*v, uint64_t{42});
+    assert_equal(reinterpret_cast<uintptr_t>(v) % alignof(uint64_t), uintptr_t{0});
+}
+
+TXL_UNIT_TEST(arena_chained_blocks)
+{
+    auto a = txl::arena{256};
+    for (auto i = 0; i < 100; ++i)
+    {
+        a.allocate(40);
+    }
+    assert_greater_than_equal(a.num_bytes_reserved(), size_t{4000});
+
+    // Larger than a block gets a block of its own
+    auto big = static_cast<char *>(a.allocate(10000, 1));
+    big[9999] = 'x';
+    assert_greater_than_equal(a.num_bytes_reserved(), size_t{14000});
+}
+
+TXL_UNIT_TEST(arena_rollback)
+{
+    auto a = txl::arena{256};
+    a.allocate(16);
+    auto m = a.mark();
+    auto first = a.allocate(16);
+    for (auto i = 0; i < 50; ++i)
+    {
+        a.allocate(32);
+    }
+    auto reserved = a.num_bytes_reserved();
+
+    a.rollback(m);
+    assert_true(a.allocate(16) == first);
+
+    // Blocks freed by the rollback are reused rather than reallocated
+    for (auto i = 0; i < 50; ++i)
+    {
+        a.allocate(32);
+    }
+    assert_equal(a.num_bytes_reserved(), reserved);
+
+    {
+        auto scope = txl::arena_scope{a};
+        a.allocate(1000);
+    }
+    assert_true(a.num_bytes_used() < 50 * 32 + 500);
+
+    // Reset keeps the blocks
+    auto reserved_before_reset = a.num_bytes_reserved();
+    a.reset();
+    assert_equal(a.num_bytes_used(), size_t{0});
+    assert_equal(a.num_bytes_reserved(), reserved_before_reset);
+
+    a.release();
+    assert_equal(a.num_bytes_reserved(), size_t{0});
+    assert_false(a.allocate(16) == nullptr);
+}
+
+TXL_UNIT_TEST(arena_pmr_containers)
+{
+    auto a = txl::arena{};
+    auto res = txl::arena_resource{a};
+
+    {
+        auto headers = txl::pmr::vector<std::pmr::string>{&res};
+        headers.emplace_back("Content-Type: a fairly long header value to defeat SSO");
+        headers.emplace_back("Content-Length: 1234567890 and some more text to spill");
+        assert_equal(headers.size(), size_t{2});
+        assert_true(headers.contains(std::pmr::string{"Content-Length: 1234567890 and some more text to spill", &res}));
+        // The strings inherit the vector's resource
+        assert_true(headers[0].get_allocator().resource() == &res);
+
+        auto m = txl::pmr::flat_map<int, int>{17, 0.45, &res};
+        for (auto i = 0; i < 10; ++i)
+        {
+            m.emplace(int{i}, int{i * 2});
+        }
+        assert_true(m.find(5) != nullptr);
+        assert_equal(m.find(5)->value(), 10);
+    }
+    assert_greater_than(a.num_bytes_used(), size_t{0});
+
+    a.reset();
+    assert_equal(a.num_bytes_used(), size_t{0});
+}
+
+TXL_RUN_TESTS()
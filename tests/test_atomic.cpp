@@ -5,6 +5,12 @@
 #include <thread>
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <ctime>
+#include <initializer_list>
+#include <stdexcept>
+#include <memory>
+#include <vector>
 
 TXL_UNIT_TEST(atomic_swap_int)
 {
@@ -765,4 +771,262 @@ TXL_UNIT_TEST(lazy_atomic_assignment_from_temporary)
     assert_equal(*lazy_str.ptr(), "hello world");
 }
 
+struct route_config final
+{
+    uint64_t a = 0;
+    uint64_t b = 0;
+    uint64_t c = 0;
+    uint64_t d = 0;
+};
+
+TXL_UNIT_TEST(seqlock_load_store)
+{
+    auto l = txl::seqlock<route_config>{route_config{1, 2, 3, 4}};
+    assert_equal(l.load().c, 3);
+    assert_equal(l.version(), 0);
+
+    l.store(route_config{5, 6, 7, 8});
+    assert_equal(l.load().a, 5);
+    assert_equal(l.load().d, 8);
+    assert_equal(l.version(), 1);
+
+    l.update([](route_config & r) {
+        r.b = 60;
+    });
+    assert_equal(l.load().a, 5);
+    assert_equal(l.load().b, 60);
+    assert_equal(l.version(), 2);
+}
+
+TXL_UNIT_TEST_N(seqlock_no_torn_reads, 10)
+{
+    auto l = txl::seqlock<route_config>{};
+    auto done = std::atomic<bool>{false};
+    auto num_torn = std::atomic<int>{0};
+
+    auto readers = std::vector<std::thread>{};
+    for (auto r = 0; r < 3; ++r)
+    {
+        readers.emplace_back([&]() {
+            while (not done.load(std::memory_order_relaxed))
+            {
+                auto v = l.load();
+                if (v.a != v.b or v.b != v.c or v.c != v.d)
+                {
+                    num_torn.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // Two writers, every write leaves all fields equal
+    auto writers = std::vector<std::thread>{};
+    for (auto w = 0; w < 2; ++w)
+    {
+        writers.emplace_back([&, w]() {
+            for (uint64_t i = 0; i < 20000; ++i)
+            {
+                if (w == 0)
+                {
+                    l.store(route_config{i, i, i, i});
+                }
+                else
+                {
+                    l.update([](route_config & r) {
+                        ++r.a;
+                        ++r.b;
+                        ++r.c;
+                        ++r.d;
+                    });
+                }
+            }
+        });
+    }
+    for (auto & t : writers)
+    {
+        t.join();
+    }
+    done.store(true);
+    for (auto & t : readers)
+    {
+        t.join();
+    }
+    assert_equal(num_torn.load(), 0);
+    assert_equal(l.version(), 40000);
+}
+
+static std::atomic<int> num_tables_freed = 0;
+
+struct routing_table final
+{
+    std::vector<int> routes{};
+
+    routing_table() = default;
+
+    routing_table(routing_table const &) = default;
+
+    routing_table(std::initializer_list<int> r)
+        : routes(r)
+    {
+    }
+
+    ~routing_table()
+    {
+        num_tables_freed.fetch_add(1);
+    }
+};
+
+TXL_UNIT_TEST(rcu_ptr_read_store)
+{
+    auto p = txl::rcu_ptr<routing_table>{};
+    assert_false(static_cast<bool>(p.read()));
+
+    p.emplace(std::initializer_list<int>{1, 2, 3});
+    {
+        auto r = p.read();
+        assert_true(static_cast<bool>(r));
+        assert_equal(r->routes.size(), 3);
+    }
+    assert_equal(p.read([](routing_table const * t) { return t->routes[1]; }), 2);
+
+    p.update([](routing_table & t) {
+        t.routes.emplace_back(4);
+    });
+    assert_equal(p.read()->routes.size(), 4);
+    assert_equal(p.read()->routes[0], 1);
+}
+
+TXL_UNIT_TEST(rcu_ptr_deferred_free)
+{
+    // Flush tables retired by earlier tests
+    while (txl::epoch_reclaimer::num_retired() > 0)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+
+    auto p = txl::rcu_ptr<routing_table>{std::make_unique<routing_table>(std::initializer_list<int>{1})};
+    auto reading = txl::awaiter{};
+    auto leave = txl::awaiter{};
+    auto seen = std::atomic<int>{0};
+    auto reader = std::thread{[&]() {
+        auto r = p.read();
+        reading.set();
+        leave.wait();
+        // Replaced long ago, still readable
+        seen.store(r->routes[0]);
+    }};
+    reading.wait();
+
+    auto freed = num_tables_freed.load();
+    p.store(std::make_unique<routing_table>(std::initializer_list<int>{2}));
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    assert_equal(num_tables_freed.load(), freed);
+    assert_equal(p.read()->routes[0], 2);
+
+    leave.set();
+    reader.join();
+    assert_equal(seen.load(), 1);
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    assert_equal(num_tables_freed.load(), freed + 1);
+}
+
+TXL_UNIT_TEST(rcu_ptr_concurrent_readers)
+{
+    auto p = txl::rcu_ptr<routing_table, txl::hazard_reclaimer>{std::make_unique<routing_table>()};
+    auto done = std::atomic<bool>{false};
+    auto num_bad = std::atomic<int>{0};
+
+    auto readers = std::vector<std::thread>{};
+    for (auto r = 0; r < 3; ++r)
+    {
+        readers.emplace_back([&]() {
+            while (not done.load(std::memory_order_relaxed))
+            {
+                auto t = p.read();
+                // Every published table counts up from zero
+                for (size_t i = 0; i < t->routes.size(); ++i)
+                {
+                    if (t->routes[i] != static_cast<int>(i))
+                    {
+                        num_bad.fetch_add(1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto i = 0; i < 2000; ++i)
+    {
+        p.update([](routing_table & t) {
+            t.routes.emplace_back(static_cast<int>(t.routes.size()));
+        });
+    }
+    done.store(true);
+    for (auto & t : readers)
+    {
+        t.join();
+    }
+    assert_equal(num_bad.load(), 0);
+    assert_equal(p.read()->routes.size(), 2000);
+}
+
+TXL_UNIT_TEST(lazy_atomic_slow_factory_parks_waiters)
+{
+    // Threads waiting on a factory doing slow I/O sleep rather than spin
+    auto num_calls = std::atomic<int>{0};
+    auto lazy = txl::lazy_atomic<int>{[&]() {
+        num_calls.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds{200});
+        return new int{42};
+    }};
+
+    auto cpu_start = std::clock();
+    auto threads = std::vector<std::thread>{};
+    auto ptrs = std::vector<int *>(4, nullptr);
+    for (size_t t = 0; t < ptrs.size(); ++t)
+    {
+        threads.emplace_back([&, t]() {
+            ptrs[t] = lazy.ptr();
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    auto cpu_ms = (std::clock() - cpu_start) * 1000 / CLOCKS_PER_SEC;
+
+    assert_equal(num_calls.load(), 1);
+    for (auto p : ptrs)
+    {
+        assert_true(p == ptrs[0]);
+    }
+    assert_equal(*ptrs[0], 42);
+    // Three spinning waiters would burn about 600ms of CPU
+    assert_less_than(cpu_ms, 100);
+}
+
+TXL_UNIT_TEST(lazy_atomic_factory_throws)
+{
+    auto num_calls = 0;
+    auto lazy = txl::lazy_atomic<int>{[&]() -> int * {
+        if (num_calls++ == 0)
+        {
+            throw std::runtime_error{"table not ready"};
+        }
+        return new int{7};
+    }};
+    assert_throws<std::runtime_error>([&]() {
+        lazy.ptr();
+    });
+    // Not stuck pending, the next access runs the factory again
+    assert_equal(lazy.get(), 7);
+    assert_equal(num_calls, 2);
+}
+
 TXL_RUN_TESTS()
@@ -0,0 +1,86 @@
+#include <txl/unit_test.h>
+#include <txl/block_cache.h>
+
+#include <thread>
+#include <vector>
+
+struct cached_value : txl::block_cache_allocated
+{
+    char data[40];
+};
+
+TXL_UNIT_TEST(block_cache_reuse)
+{
+    auto p = txl::block_cache::allocate(40);
+    auto num_cached = txl::block_cache::num_cached();
+    txl::block_cache::deallocate(p, 40);
+    assert_equal(txl::block_cache::num_cached(), num_cached + 1);
+
+    // Same size class, same block
+    auto q = txl::block_cache::allocate(48);
+    assert_equal(q, p);
+    assert_equal(txl::block_cache::num_cached(), num_cached);
+    txl::block_cache::deallocate(q, 48);
+}
+
+TXL_UNIT_TEST(block_cache_oversize)
+{
+    auto num_cached = txl::block_cache::num_cached();
+    auto p = txl::block_cache::allocate(txl::block_cache::max_block_size + 1);
+    txl::block_cache::deallocate(p, txl::block_cache::max_block_size + 1);
+    assert_equal(txl::block_cache::num_cached(), num_cached);
+}
+
+TXL_UNIT_TEST(block_cache_allocated_type)
+{
+    auto v = new cached_value{};
+    auto p = static_cast<void *>(v);
+    delete v;
+    auto w = new cached_value{};
+    assert_equal(static_cast<void *>(w), p);
+    delete w;
+}
+
+TXL_UNIT_TEST(block_cache_cross_thread)
+{
+    // Blocks freed on a consumer thread make their way back to the producer
+    // through the depot
+    constexpr size_t num_blocks = 4 * txl::block_cache::batch_size;
+    constexpr size_t block_size = 200;
+
+    auto first = std::vector<void *>{};
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        first.emplace_back(txl::block_cache::allocate(block_size));
+    }
+    std::thread{[&first]() {
+        for (auto p : first)
+        {
+            txl::block_cache::deallocate(p, block_size);
+        }
+    }}.join();
+
+    auto num_reused = size_t{0};
+    auto second = std::vector<void *>{};
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        auto p = txl::block_cache::allocate(block_size);
+        for (auto f : first)
+        {
+            if (f == p)
+            {
+                ++num_reused;
+                break;
+            }
+        }
+        second.emplace_back(p);
+    }
+    assert_greater_than(num_reused, size_t{0});
+
+    for (auto p : second)
+    {
+        txl::block_cache::deallocate(p, block_size);
+    }
+}
+
+TXL_RUN_TESTS()
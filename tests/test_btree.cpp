@@ -105,5 +105,28 @@ TXL_UNIT_TEST(random_degree_5)
     }
 }
 
+TXL_UNIT_TEST(slab_nodes)
+{
+    txl::btree<int, int, txl::slab_nodes> bt{3};
+    for (auto i = 0; i < 2000; ++i)
+    {
+        bt.insert(i, i*10);
+    }
+    for (auto i = 0; i < 2000; i += 2)
+    {
+        bt.remove(i);
+    }
+    for (auto i = 0; i < 2000; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            assert_equal(bt.find(i), nullptr);
+        }
+        else
+        {
+            assert_equal(*bt.find(i), i*10);
+        }
+    }
+}
 
 TXL_RUN_TESTS()
@@ -0,0 +1,156 @@
+#include <txl/unit_test.h>
+#include <txl/concurrent_flat_map.h>
+#include <txl/threading.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TXL_UNIT_TEST(concurrent_flat_map_empty)
+{
+    auto m = txl::concurrent_flat_map<int, int>{};
+    assert_true(m.empty());
+    assert_false(m.contains(1));
+    assert_false(m.erase(1));
+}
+
+TXL_UNIT_TEST(concurrent_flat_map_insert_find_erase)
+{
+    auto m = txl::concurrent_flat_map<int, int>{};
+    assert_true(m.insert(1, 10));
+    assert_true(m.insert(2, 20));
+    // Present keys keep their value
+    assert_false(m.insert(1, 11));
+    assert_equal(*m.find(1), 10);
+    assert_equal(*m.find(2), 20);
+    assert_equal(m.size(), 2);
+
+    assert_false(m.insert_or_assign(1, 12));
+    assert_equal(*m.find(1), 12);
+
+    assert_true(m.erase(1));
+    assert_false(m.contains(1));
+    assert_false(m.erase(1));
+    assert_equal(*m.find(2), 20);
+    assert_equal(m.size(), 1);
+
+    // Erased keys can come back
+    assert_true(m.insert_or_assign(1, 13));
+    assert_equal(*m.find(1), 13);
+}
+
+TXL_UNIT_TEST(concurrent_flat_map_grows)
+{
+    auto m = txl::concurrent_flat_map<int, int>{8};
+    auto saw_resizing = false;
+    for (auto i = 0; i < 10000; ++i)
+    {
+        m.insert(i, i * 2);
+        saw_resizing = saw_resizing or m.is_resizing();
+    }
+    // Tables are migrated a few slots per write rather than all at once
+    assert_true(saw_resizing);
+    assert_equal(m.size(), 10000);
+    assert_greater_than_equal(m.capacity(), 20000);
+    for (auto i = 0; i < 10000; ++i)
+    {
+        assert_equal(*m.find(i), i * 2);
+    }
+}
+
+TXL_UNIT_TEST(concurrent_flat_map_tombstones)
+{
+    // Churning keys fills the table with tombstones, which resizes clear
+    // out without growing it
+    auto m = txl::concurrent_flat_map<int, int>{64};
+    for (auto i = 0; i < 100000; ++i)
+    {
+        m.insert(i, i);
+        if (i >= 8)
+        {
+            assert_true(m.erase(i - 8));
+        }
+    }
+    assert_equal(m.size(), 8);
+    assert_less_than(m.capacity(), 1024);
+    for (auto i = 100000 - 8; i < 100000; ++i)
+    {
+        assert_equal(*m.find(i), i);
+    }
+}
+
+struct connection final
+{
+    int fd;
+    uint64_t id;
+};
+
+TXL_UNIT_TEST(concurrent_flat_map_readers_and_writers)
+{
+    // Readers never see a torn entry or lose a key that is always present
+    auto m = txl::concurrent_flat_map<int, connection>{16};
+    constexpr int num_stable = 1000;
+    for (auto i = 0; i < num_stable; ++i)
+    {
+        m.insert(i, connection{i, uint64_t(i) * 3});
+    }
+
+    auto done = std::atomic<bool>{false};
+    auto num_bad = std::atomic<int>{0};
+    auto readers = std::vector<std::thread>{};
+    for (auto r = 0; r < 3; ++r)
+    {
+        readers.emplace_back([&, r]() {
+            auto i = r;
+            while (not done.load(std::memory_order_relaxed))
+            {
+                auto key = i++ % num_stable;
+                auto c = m.find(key);
+                if (not c or c->fd != key or (c->id != uint64_t(key) * 3 and c->id != uint64_t(key) * 5))
+                {
+                    num_bad.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    auto writers = std::vector<std::thread>{};
+    for (auto w = 0; w < 2; ++w)
+    {
+        writers.emplace_back([&, w]() {
+            // Grow the table with churning keys and rewrite the stable ones
+            for (auto i = 0; i < 20000; ++i)
+            {
+                auto key = num_stable + w * 20000 + i;
+                m.insert(key, connection{key, 0});
+                if (i % 2 == 0)
+                {
+                    m.erase(key);
+                }
+                auto stable = i % num_stable;
+                m.insert_or_assign(stable, connection{stable, uint64_t(stable) * (i % 3 == 0 ? 5 : 3)});
+            }
+        });
+    }
+    for (auto & t : writers)
+    {
+        t.join();
+    }
+    done.store(true);
+    for (auto & t : readers)
+    {
+        t.join();
+    }
+
+    assert_equal(num_bad.load(), 0);
+    assert_equal(m.size(), num_stable + 20000);
+    for (auto w = 0; w < 2; ++w)
+    {
+        for (auto i = 1; i < 20000; i += 2)
+        {
+            assert_true(m.contains(num_stable + w * 20000 + i));
+        }
+    }
+}
+
+TXL_RUN_TESTS()
@@ -1,29 +1,171 @@
-#include <iostream>
+#include <txl/unit_test.h>
+#include <txl/coroutine.h>
 
-#include <coroutine>
+#include <chrono>
+#include <stdexcept>
+#include <string>
 
-template<class T>
-class BasicCoroutine {
-public:
-    struct Promise {
-        BasicCoroutine get_return_object() { return BasicCoroutine {}; }
+static auto answer() -> txl::task<int>
+{
+    co_return 42;
+}
+
+static auto add(int a, int b) -> txl::task<int>
+{
+    co_return a + b;
+}
+
+static auto sum_of_answers() -> txl::task<int>
+{
+    auto x = co_await answer();
+    auto y = co_await add(x, 1);
+    co_return x + y;
+}
+
+static auto roll_call() -> txl::task<std::string>
+{
+    // Chained tasks are awaitable too
+    auto names = co_await txl::make_task<std::string>([]() {
+        return "Cambot";
+    }).then([](auto & ctx) {
+        return ctx.result() + ", Gypsy";
+    });
+    co_return names + ", Tom Servo";
+}
+
+static auto fail() -> txl::task<int>
+{
+    throw std::runtime_error{"failed"};
+    co_return 0;
+}
 
-        void unhandled_exception() noexcept { }
+static auto catch_failure() -> txl::task<std::string>
+{
+    try
+    {
+        co_await fail();
+    }
+    catch (std::runtime_error const & e)
+    {
+        co_return e.what();
+    }
+    co_return "";
+}
 
-        std::suspend_never initial_suspend() noexcept { return {}; }
-        std::suspend_never final_suspend() noexcept { return {}; }
-        T return_value(T && value) { return 4; }
-    };
-    using promise_type = Promise;
-    T value_ = 0;
-};
+static auto count_up(int & counter, int n) -> txl::task<void>
+{
+    for (auto i = 0; i < n; ++i)
+    {
+        co_await add(i, 1);
+        ++counter;
+    }
+}
 
-BasicCoroutine<int> coro()
+static auto sleepy_answer() -> txl::task<int>
 {
+    co_await txl::delay(std::chrono::milliseconds{20});
     co_return 42;
 }
 
-int main()
+TXL_UNIT_TEST_VARIATION(inline_runner, []() {
+    txl::task_runner::set_global(std::make_unique<txl::inline_task_runner>());
+});
+
+TXL_UNIT_TEST_VARIATION(thread_pool_runner, []() {
+    txl::task_runner::set_global(std::make_unique<txl::thread_pool_task_runner>(4));
+});
+
+TXL_UNIT_TEST(co_return_value)
+{
+    auto t = answer();
+    assert_equal(t(), 42);
+}
+
+TXL_UNIT_TEST(co_await_tasks)
 {
-    std::cout << coro().value_ << std::endl;
+    auto t = sum_of_answers();
+    assert_equal(t(), 85);
 }
+
+TXL_UNIT_TEST(co_await_chain)
+{
+    auto t = roll_call();
+    assert_equal(t(), "Cambot, Gypsy, Tom Servo");
+}
+
+TXL_UNIT_TEST(coroutine_then)
+{
+    auto t = sum_of_answers().then([](auto & ctx) {
+        return ctx.result() * 2;
+    }).then([](auto & ctx) {
+        return ctx.result() + 1;
+    });
+    assert_equal(t(), 171);
+
+    auto counter = 0;
+    auto v = count_up(counter, 10).then([&counter]() {
+        counter *= 2;
+    });
+    v();
+    assert_equal(counter, 20);
+}
+
+TXL_UNIT_TEST(exception_propagates)
+{
+    auto t = catch_failure();
+    assert_equal(t(), "failed");
+
+    auto f = fail();
+    assert_throws<std::runtime_error>([&]() { f(); });
+}
+
+TXL_UNIT_TEST(void_task)
+{
+    auto counter = 0;
+    auto t = count_up(counter, 10);
+    t();
+    assert_equal(counter, 10);
+}
+
+TXL_UNIT_TEST(co_await_delay)
+{
+    auto t = sleepy_answer();
+    assert_equal(t(), 42);
+}
+
+TXL_UNIT_TEST(runs_once)
+{
+    auto t = answer();
+    assert_equal(t(), 42);
+    assert_throws<std::logic_error>([&]() { t(); });
+}
+
+TXL_UNIT_TEST(nested_awaits_do_not_block_workers)
+{
+    // Every await would deadlock a single worker if it blocked on the future
+    auto runner = txl::thread_pool_task_runner{1};
+    auto counter = 0;
+    auto t = count_up(counter, 100);
+    t(runner);
+    assert_equal(counter, 100);
+}
+
+TXL_UNIT_TEST(frames_are_recycled)
+{
+    auto runner = txl::inline_task_runner{};
+    {
+        auto t = answer();
+        t(runner);
+    }
+    auto num_cached = txl::block_cache::num_cached();
+    assert_greater_than(num_cached, size_t{0});
+    {
+        // Creating the task on this thread reuses the cached frame
+        auto t = answer();
+        assert_less_than(txl::block_cache::num_cached(), num_cached);
+        t(runner);
+    }
+    assert_equal(txl::block_cache::num_cached(), num_cached);
+}
+
+TXL_RUN_TESTS()
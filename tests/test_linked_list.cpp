@@ -4,6 +4,9 @@
 #include <txl/fixed_string.h>
 
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 TXL_UNIT_TEST(atomic_linked_list_simple)
 {
@@ -206,4 +209,154 @@ TXL_UNIT_TEST_N(atomic_linked_list_thread_safety, 100)
     assert_true(l.empty());
 }
 
+TXL_UNIT_TEST(atomic_node_pool_reuse)
+{
+    using pool = txl::atomic_node_pool<std::string>;
+    auto a = pool::allocate();
+    pool::deallocate(a);
+    assert_greater_than_equal(pool::num_cached(), 1);
+    // Most recently freed block comes back first
+    assert_true(pool::allocate() == a);
+    pool::deallocate(a);
+
+    // Overflowing the thread cache hands a batch to the shared freelist
+    auto blocks = std::vector<void *>{};
+    for (size_t i = 0; i < 4 * pool::batch_size; ++i)
+    {
+        blocks.emplace_back(pool::allocate());
+    }
+    for (auto p : blocks)
+    {
+        pool::deallocate(p);
+    }
+    assert_less_than(pool::num_cached(), 2 * pool::batch_size);
+}
+
+TXL_UNIT_TEST(atomic_linked_list_pooled)
+{
+    auto l = txl::atomic_linked_list<delete_me, txl::pooled_nodes>{};
+    auto deletes = num_deletes;
+    for (auto round = 0; round < 3; ++round)
+    {
+        for (auto i = 0; i < 100; ++i)
+        {
+            l.emplace_front();
+        }
+        for (auto i = 0; i < 50; ++i)
+        {
+            l.pop_and_release_front();
+        }
+    }
+    assert_equal(num_deletes, deletes + 150);
+    assert_equal(l.clear(), 150);
+    assert_equal(num_deletes, deletes + 300);
+    assert_true(l.empty());
+}
+
+TXL_UNIT_TEST(atomic_linked_list_pooled_cross_thread)
+{
+    // Nodes allocated by one thread and freed by another travel back
+    // through the shared freelist
+    auto l = txl::atomic_linked_list<std::string, txl::pooled_nodes>{};
+    constexpr int num_items = 10000;
+    auto producer = std::thread{[&]() {
+        for (auto i = 0; i < num_items; ++i)
+        {
+            l.emplace_front("Hello World No Small String Optimization Here");
+        }
+    }};
+    auto num_popped = 0;
+    while (num_popped < num_items)
+    {
+        if (auto v = l.pop_and_release_front(); v)
+        {
+            assert_equal(*v, "Hello World No Small String Optimization Here");
+            ++num_popped;
+        }
+    }
+    producer.join();
+    assert_true(l.empty());
+}
+
+TXL_UNIT_TEST_N(atomic_linked_list_pooled_thread_safety, 100)
+{
+    auto l = txl::atomic_linked_list<int, txl::pooled_nodes>{};
+    std::atomic<int> total_popped = 0;
+    std::atomic<int64_t> sum_popped = 0;
+
+    constexpr int num_threads = 4;
+    constexpr int items_per_thread = 1000;
+
+    // Every thread pushes and pops so nodes are recycled while others
+    // still read the head
+    auto worker = [&](int id) {
+        return [&, id]() {
+            for (auto i = 0; i < items_per_thread; ++i)
+            {
+                l.emplace_front(id * items_per_thread + i);
+                if (auto v = l.pop_and_release_front(); v)
+                {
+                    total_popped.fetch_add(1, std::memory_order_relaxed);
+                    sum_popped.fetch_add(*v, std::memory_order_relaxed);
+                }
+            }
+        };
+    };
+
+    std::thread threads[num_threads];
+    for (auto i = 0; i < num_threads; ++i)
+    {
+        threads[i] = std::thread(worker(i));
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    constexpr int total_items = num_threads * items_per_thread;
+    assert_equal(total_popped.load(), total_items);
+    assert_equal(sum_popped.load(), int64_t{total_items} * (total_items - 1) / 2);
+    assert_true(l.empty());
+}
+
+TXL_UNIT_TEST_N(atomic_linked_list_slab_immediate_thread_safety, 20)
+{
+    // Slab nodes are never unmapped, so they may be freed on pop
+    auto l = txl::atomic_linked_list<int, txl::slab_nodes, txl::immediate_reclaimer>{};
+    std::atomic<int> total_popped = 0;
+    std::atomic<int64_t> sum_popped = 0;
+
+    constexpr int num_threads = 4;
+    constexpr int items_per_thread = 1000;
+
+    auto worker = [&](int id) {
+        return [&, id]() {
+            for (auto i = 0; i < items_per_thread; ++i)
+            {
+                l.emplace_front(id * items_per_thread + i);
+                if (auto v = l.pop_and_release_front(); v)
+                {
+                    total_popped.fetch_add(1, std::memory_order_relaxed);
+                    sum_popped.fetch_add(*v, std::memory_order_relaxed);
+                }
+            }
+        };
+    };
+
+    std::thread threads[num_threads];
+    for (auto i = 0; i < num_threads; ++i)
+    {
+        threads[i] = std::thread(worker(i));
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    constexpr int total_items = num_threads * items_per_thread;
+    assert_equal(total_popped.load(), total_items);
+    assert_equal(sum_popped.load(), int64_t{total_items} * (total_items - 1) / 2);
+    assert_true(l.empty());
+}
+
 TXL_RUN_TESTS()
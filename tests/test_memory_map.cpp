@@ -39,4 +39,20 @@ TXL_UNIT_TEST(mmap_anonymous)
     }
 }
 
+TXL_UNIT_TEST(mmap_advise)
+{
+    auto map = txl::memory_map{};
+    map.open(4096 * 4, txl::memory_map::read | txl::memory_map::write).or_throw();
+    auto m = map.memory();
+    m = "Hello World"sv;
+    assert_false(map.advise(m, txl::memory_map::will_need).is_error());
+
+    // Private anonymous pages read back as zero once dropped
+    assert_false(map.advise(m, txl::memory_map::dont_need).is_error());
+    assert_equal(std::byte{0}, m[0]);
+
+    // Unaligned ranges are rejected
+    assert_true(map.advise(m.slice(1, 4096), txl::memory_map::normal).is_error());
+}
+
 TXL_RUN_TESTS()
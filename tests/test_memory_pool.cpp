@@ -1,6 +1,17 @@
 #include <txl/memory_pool.h>
+#include <txl/numa.h>
 #include <txl/unit_test.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
 TXL_UNIT_TEST(mempool)
 {
     txl::memory_pool mp(4, 256);
@@ -19,4 +30,306 @@ TXL_UNIT_TEST(mempool)
     assert(!h5.empty());
 }
 
+TXL_UNIT_TEST(mempool_chunk_references)
+{
+    auto mp = txl::memory_pool{2, 256};
+    auto c1 = mp.allocate(32);
+    auto c2 = mp.allocate(32);
+    assert_false(c1.empty());
+    assert_false(c2.empty());
+
+    {
+        auto copy = c1;
+        c1.close();
+        // The copy keeps the chunk rented
+        assert_true(mp.allocate(32).empty());
+    }
+    auto c3 = mp.allocate(32);
+    assert_false(c3.empty());
+}
+
+TXL_UNIT_TEST(mempool_size_classes)
+{
+    auto mp = txl::memory_pool{8, 256, 1};
+    // 600 bytes plus the header take 3 pages, rounded up to 4
+    auto big = mp.rent(600);
+    assert_false(big.empty());
+    auto small = std::vector<txl::memory_pool_handle>{};
+    for (auto i = 0; i < 4; ++i)
+    {
+        small.emplace_back(mp.rent(32));
+        assert_false(small.back().empty());
+    }
+    assert_true(mp.rent(32).empty());
+
+    // The freed 4 page chunk splits into a 2 page chunk and two 1 page ones
+    mp.release(big);
+    auto h = mp.rent(300);
+    assert_false(h.empty());
+    auto s1 = mp.rent(32);
+    auto s2 = mp.rent(32);
+    assert_false(s1.empty());
+    assert_false(s2.empty());
+    assert_true(mp.rent(32).empty());
+}
+
+TXL_UNIT_TEST(mempool_concurrent_alloc_free)
+{
+    constexpr size_t num_threads = 4;
+    constexpr size_t num_iterations = 20000;
+    constexpr size_t num_pages = 64;
+    auto mp = txl::memory_pool{num_pages, 128, 2};
+
+    auto num_corrupt = std::atomic<size_t>{0};
+    auto threads = std::vector<std::thread>{};
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            auto held = std::deque<txl::memory_pool_chunk>{};
+            for (size_t i = 0; i < num_iterations; ++i)
+            {
+                auto c = mp.allocate(64);
+                if (c.empty())
+                {
+                    // Chunks in flight between caches are briefly invisible
+                    held.clear();
+                    continue;
+                }
+                auto tag = static_cast<unsigned char>(t + 1);
+                std::memset(c.data(), tag, c.size());
+                // Hand a copy around so the last reference may be dropped
+                // by either copy
+                auto copy = c;
+                if (i % 3 == 0)
+                {
+                    held.emplace_back(std::move(copy));
+                }
+                auto p = static_cast<unsigned char const *>(c.data());
+                for (size_t b = 0; b < c.size(); ++b)
+                {
+                    if (p[b] != tag)
+                    {
+                        ++num_corrupt;
+                        break;
+                    }
+                }
+                if (held.size() > 8)
+                {
+                    held.pop_front();
+                }
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    assert_equal(num_corrupt.load(), size_t{0});
+
+    // Every chunk went back to some cache and can be rented again
+    auto all = std::vector<txl::memory_pool_handle>{};
+    for (size_t i = 0; i < num_pages; ++i)
+    {
+        all.emplace_back(mp.rent(64));
+        assert_false(all.back().empty());
+    }
+    assert_true(mp.rent(64).empty());
+}
+
+TXL_UNIT_TEST(mempool_fragmentation_stress)
+{
+    constexpr size_t num_pages = 256;
+    constexpr size_t page_size = 64;
+    auto mp = txl::memory_pool{num_pages, page_size, 1};
+    auto rng = std::mt19937{1234};
+
+    struct live_chunk
+    {
+        txl::memory_pool_handle h;
+        unsigned char tag;
+    };
+    auto live = std::vector<live_chunk>{};
+    size_t live_pages = 0;
+    size_t max_live_pages = 0;
+    size_t num_failed = 0;
+    size_t num_corrupt = 0;
+
+    auto pages_of = [&](size_t num_bytes) {
+        auto n = (num_bytes + sizeof(txl::detail::mempool_chunk_header) + page_size - 1) / page_size;
+        size_t res = 1;
+        while (res < n)
+        {
+            res <<= 1;
+        }
+        return res;
+    };
+
+    auto free_one = [&](size_t i) {
+        auto & c = live[i];
+        auto p = static_cast<unsigned char const *>(c.h.data());
+        for (size_t b = 0; b < c.h.size(); ++b)
+        {
+            if (p[b] != c.tag)
+            {
+                ++num_corrupt;
+                break;
+            }
+        }
+        live_pages -= pages_of(c.h.size());
+        mp.release(c.h);
+        live[i] = std::move(live.back());
+        live.pop_back();
+    };
+
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        if (live.empty() or rng() % 2 == 0)
+        {
+            // Mostly small chunks with the odd large one
+            auto num_bytes = rng() % 8 == 0 ? page_size * (1 + rng() % 15) : 1 + rng() % (page_size * 2);
+            auto h = mp.rent(num_bytes);
+            if (h.empty())
+            {
+                ++num_failed;
+                free_one(rng() % live.size());
+                continue;
+            }
+            auto tag = static_cast<unsigned char>(i);
+            std::memset(h.data(), tag, h.size());
+            live_pages += pages_of(num_bytes);
+            max_live_pages = std::max(max_live_pages, live_pages);
+            live.push_back({std::move(h), tag});
+        }
+        else
+        {
+            free_one(rng() % live.size());
+        }
+    }
+    while (not live.empty())
+    {
+        free_one(live.size() - 1);
+    }
+    assert_equal(num_corrupt, size_t{0});
+
+    // Everything coalesces back into a single chunk
+    mp.trim();
+    auto stats = mp.stats();
+    assert_equal(stats.num_free_pages, num_pages);
+    assert_equal(stats.num_cached_pages, size_t{0});
+    assert_equal(stats.largest_free_chunk_pages, num_pages);
+    assert_greater_than_equal(stats.high_water_pages, max_live_pages);
+    assert_less_than_equal(stats.high_water_pages, num_pages);
+    std::cout << "high water: " << stats.high_water_pages << "/" << num_pages << " pages"
+              << ", peak live: " << max_live_pages << " pages"
+              << ", failed rents: " << num_failed << std::endl;
+}
+
+TXL_UNIT_TEST(mempool_mapped_numa_local)
+{
+    auto options = txl::memory_pool_options{};
+    options.num_shards = 1;
+    options.transparent_huge_pages = true;
+    options.prefault = true;
+    options.numa_node = 0;
+    auto mp = txl::memory_pool{64, 4096, options};
+    assert_true(mp.is_mapped());
+    assert_false(mp.huge_tlb());
+
+    auto c = mp.allocate(4000);
+    assert_false(c.empty());
+    std::memset(c.data(), 0xab, c.size());
+    // Binding is best effort, containers may not allow it
+    if (auto node = txl::numa_node_of(c.data()); mp.numa_bound() and node)
+    {
+        assert_equal(*node, size_t{0});
+    }
+}
+
+TXL_UNIT_TEST(mempool_huge_pages_fallback)
+{
+    // Works whether or not the system has huge pages reserved
+    auto options = txl::memory_pool_options{};
+    options.num_shards = 1;
+    options.huge_pages = true;
+    options.prefault = true;
+    auto mp = txl::memory_pool{16, 4096, options};
+    assert_true(mp.is_mapped());
+
+    auto all = std::vector<txl::memory_pool_handle>{};
+    for (auto i = 0; i < 16; ++i)
+    {
+        all.emplace_back(mp.rent(1024));
+        assert_false(all.back().empty());
+        std::memset(all.back().data(), i, all.back().size());
+    }
+    assert_true(mp.rent(1024).empty());
+}
+
+TXL_UNIT_TEST(mempool_grows_arenas)
+{
+    auto options = txl::memory_pool_options{};
+    options.num_shards = 1;
+    options.max_arenas = 3;
+    options.arena_cool_down = std::chrono::milliseconds{0};
+    auto mp = txl::memory_pool{4, 4096, options};
+    assert_equal(mp.stats().num_arenas, size_t{1});
+
+    auto all = std::vector<txl::memory_pool_handle>{};
+    for (auto i = 0; i < 12; ++i)
+    {
+        all.emplace_back(mp.rent(1024));
+        assert_false(all.back().empty());
+        std::memset(all.back().data(), i, all.back().size());
+    }
+    assert_true(mp.rent(1024).empty());
+    assert_equal(mp.stats().num_arenas, size_t{3});
+    assert_equal(mp.stats().high_water_pages, size_t{12});
+    for (size_t i = 0; i < all.size(); ++i)
+    {
+        assert_equal(static_cast<unsigned char const *>(all[i].data())[1023], static_cast<unsigned char>(i));
+    }
+
+    // Chunks never span arenas
+    assert_true(mp.rent(4 * 4096).empty());
+
+    for (auto & h : all)
+    {
+        mp.release(h);
+    }
+    mp.trim();
+    auto stats = mp.stats();
+    assert_equal(stats.num_arenas, size_t{1});
+    assert_equal(stats.num_pages, size_t{4});
+    assert_equal(stats.num_free_pages, size_t{4});
+
+    // Released arenas come back when needed
+    for (auto i = 0; i < 12; ++i)
+    {
+        all[i] = mp.rent(1024);
+        assert_false(all[i].empty());
+    }
+    assert_equal(mp.stats().num_arenas, size_t{3});
+}
+
+TXL_UNIT_TEST(mempool_arena_cool_down)
+{
+    auto options = txl::memory_pool_options{};
+    options.num_shards = 1;
+    options.max_arenas = 2;
+    options.arena_cool_down = std::chrono::hours{1};
+    auto mp = txl::memory_pool{4, 4096, options};
+
+    {
+        auto c = mp.allocate(4 * 4096 - 64);
+        auto d = mp.allocate(32);
+        assert_false(c.empty());
+        assert_false(d.empty());
+        assert_equal(mp.stats().num_arenas, size_t{2});
+    }
+    // Still cooling down, the arena stays for the next burst
+    mp.trim();
+    assert_equal(mp.stats().num_arenas, size_t{2});
+    assert_equal(mp.stats().num_free_pages, size_t{8});
+}
+
 TXL_RUN_TESTS()
@@ -0,0 +1,147 @@
+#include <txl/unit_test.h>
+#include <txl/mpmc_queue.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TXL_UNIT_TEST(mpmc_queue_empty)
+{
+    auto q = txl::mpmc_queue<int>{4};
+    assert_true(q.empty());
+    assert_equal(q.capacity(), size_t{4});
+    assert_false(q.try_pop().has_value());
+
+    // Capacity rounds up to a power of two
+    assert_equal(txl::mpmc_queue<int>{5}.capacity(), size_t{8});
+    assert_equal(txl::mpmc_queue<int>{0}.capacity(), size_t{2});
+}
+
+TXL_UNIT_TEST(mpmc_queue_push_pop)
+{
+    auto q = txl::mpmc_queue<int>{4};
+    for (auto lap = 0; lap < 3; ++lap)
+    {
+        for (auto i = 0; i < 4; ++i)
+        {
+            assert_true(q.try_push(i));
+        }
+        assert_false(q.try_push(4));
+        assert_equal(q.size(), size_t{4});
+        for (auto i = 0; i < 4; ++i)
+        {
+            assert_equal(*q.try_pop(), i);
+        }
+        assert_true(q.empty());
+    }
+}
+
+TXL_UNIT_TEST(mpmc_queue_move_only)
+{
+    auto q = txl::mpmc_queue<std::unique_ptr<std::string>>{2};
+    assert_true(q.try_emplace(std::make_unique<std::string>("Hello World No Small String Optimization Here")));
+    auto s = std::make_unique<std::string>("second");
+    assert_true(q.try_push(std::move(s)));
+    assert_equal(**q.try_pop(), "Hello World No Small String Optimization Here");
+    assert_equal(**q.try_pop(), "second");
+}
+
+TXL_UNIT_TEST(mpmc_queue_batch)
+{
+    auto q = txl::mpmc_queue<int>{8};
+    auto values = std::vector<int>{0, 1, 2, 3, 4, 5};
+    assert_equal(q.try_push_n(values.begin(), values.end()), size_t{6});
+    // Only two slots left
+    assert_equal(q.try_push_n(values.begin(), values.end()), size_t{2});
+
+    auto popped = std::vector<int>{};
+    assert_equal(q.try_pop_n(5, [&popped](int v) { popped.emplace_back(v); }), size_t{5});
+    assert_equal(popped, (std::vector<int>{0, 1, 2, 3, 4}));
+    assert_equal(q.try_pop_n(10, [&popped](int v) { popped.emplace_back(v); }), size_t{3});
+    assert_equal(popped, (std::vector<int>{0, 1, 2, 3, 4, 5, 0, 1}));
+    assert_equal(q.try_pop_n(10, [](int) {}), size_t{0});
+}
+
+TXL_UNIT_TEST(mpmc_queue_destroys_remaining)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        auto q = txl::mpmc_queue<std::shared_ptr<int>>{4};
+        q.try_push(counter);
+        q.try_push(counter);
+        assert_equal(counter.use_count(), 3);
+    }
+    assert_equal(counter.use_count(), 1);
+}
+
+TXL_UNIT_TEST(mpmc_queue_concurrent)
+{
+    constexpr auto num_threads = 4;
+    constexpr auto num_values = 20000;
+    auto q = txl::mpmc_queue<int>{64};
+    auto sum = std::atomic<int64_t>{0};
+    auto count = std::atomic<int>{0};
+
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&q, t]() {
+            for (auto i = 0; i < num_values; ++i)
+            {
+                // Mix of single and batched pushes
+                if (i % 3 == 0)
+                {
+                    q.push(t * num_values + i);
+                }
+                else
+                {
+                    auto v = t * num_values + i;
+                    while (q.try_push_n(&v, &v + 1) == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+        threads.emplace_back([&q, &sum, &count]() {
+            for (auto i = 0; i < num_values; ++i)
+            {
+                sum.fetch_add(q.pop());
+                count.fetch_add(1);
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+
+    int64_t total = num_threads * num_values;
+    assert_equal(count.load(), num_threads * num_values);
+    assert_equal(sum.load(), total * (total - 1) / 2);
+    assert_true(q.empty());
+}
+
+TXL_UNIT_TEST(mpmc_queue_blocking_full)
+{
+    auto q = txl::mpmc_queue<int>{2};
+    q.push(1);
+    q.push(2);
+    auto pushed = std::atomic<bool>{false};
+    auto producer = std::thread{[&]() {
+        // Waits for room
+        q.push(3);
+        pushed.store(true);
+    }};
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    assert_false(pushed.load());
+    assert_equal(q.pop(), 1);
+    producer.join();
+    assert_true(pushed.load());
+    assert_equal(q.pop(), 2);
+    assert_equal(q.pop(), 3);
+}
+
+TXL_RUN_TESTS()
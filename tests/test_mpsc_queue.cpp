@@ -0,0 +1,127 @@
+#include <txl/unit_test.h>
+#include <txl/mpsc_queue.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TXL_UNIT_TEST(mpsc_queue_empty)
+{
+    auto q = txl::mpsc_queue<int>{};
+    assert_true(q.empty());
+    assert_false(q.try_pop_front().has_value());
+}
+
+TXL_UNIT_TEST(mpsc_queue_push_pop)
+{
+    auto q = txl::mpsc_queue<int>{};
+    q.push_back(1);
+    q.push_back(2);
+    q.push_back(3);
+    assert_equal(q.size(), 3);
+    assert_equal(*q.try_pop_front(), 1);
+    assert_equal(*q.try_pop_front(), 2);
+    assert_equal(*q.try_pop_front(), 3);
+    assert_true(q.empty());
+}
+
+TXL_UNIT_TEST(mpsc_queue_move)
+{
+    auto q = txl::mpsc_queue<std::string>{};
+    q.emplace_back("Hello World No Small String Optimization Here");
+    auto s = std::move(*q.try_pop_front());
+    assert_true(q.empty());
+    assert_equal(s, "Hello World No Small String Optimization Here");
+}
+
+TXL_UNIT_TEST(mpsc_queue_pop_n)
+{
+    auto q = txl::mpsc_queue<int>{};
+    for (auto i = 0; i < 10; ++i)
+    {
+        q.push_back(i);
+    }
+    std::vector<int> popped{};
+    auto n = q.pop_front_n(4, [&popped](int v) {
+        popped.emplace_back(v);
+    });
+    assert_equal(n, 4);
+    assert_equal(popped, std::vector<int>{0, 1, 2, 3});
+    assert_equal(q.size(), 6);
+    assert_equal(q.clear(), 6);
+    assert_true(q.empty());
+}
+
+TXL_UNIT_TEST(mpsc_queue_producers)
+{
+    static constexpr int num_producers = 4;
+    static constexpr int num_items = 10000;
+
+    auto q = txl::mpsc_queue<std::pair<int, int>>{};
+    std::vector<std::thread> producers{};
+    for (auto p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back([&q, p]() {
+            for (auto i = 0; i < num_items; ++i)
+            {
+                q.emplace_back(p, i);
+            }
+        });
+    }
+
+    // Values from each producer must come out in the order they went in
+    std::vector<int> next(num_producers, 0);
+    auto num_popped = 0;
+    while (num_popped < num_producers * num_items)
+    {
+        if (auto v = q.try_pop_front(); v)
+        {
+            assert_equal(v->second, next[v->first]);
+            ++next[v->first];
+            ++num_popped;
+        }
+    }
+    for (auto & t : producers)
+    {
+        t.join();
+    }
+    assert_true(q.empty());
+}
+
+TXL_UNIT_TEST(mpsc_queue_size_never_wraps)
+{
+    static constexpr int num_producers = 4;
+    static constexpr int num_items = 10000;
+
+    auto q = txl::mpsc_queue<int>{};
+    std::vector<std::thread> producers{};
+    for (auto p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back([&q]() {
+            for (auto i = 0; i < num_items; ++i)
+            {
+                q.emplace_back(i);
+            }
+        });
+    }
+
+    // The consumer races the producers' counting; the size must stay
+    // within what was pushed
+    auto num_popped = 0;
+    while (num_popped < num_producers * num_items)
+    {
+        if (q.try_pop_front())
+        {
+            ++num_popped;
+        }
+        assert_less_than_equal(q.size(), size_t{num_producers * num_items});
+    }
+    for (auto & t : producers)
+    {
+        t.join();
+    }
+    assert_equal(q.size(), size_t{0});
+}
+
+TXL_RUN_TESTS()
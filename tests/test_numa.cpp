@@ -0,0 +1,100 @@
+#include <txl/unit_test.h>
+#include <txl/numa.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static auto make_fake_sysfs(std::string const & online, std::vector<std::string> const & cpulists) -> fs::path
+{
+    auto tmpl = (fs::temp_directory_path() / "txl_numa_XXXXXX").string();
+    auto root = fs::path{::mkdtemp(tmpl.data())};
+    std::ofstream{root / "online"} << online << '\n';
+    for (size_t i = 0; i < cpulists.size(); ++i)
+    {
+        auto dir = root / ("node" + std::to_string(i));
+        fs::create_directory(dir);
+        std::ofstream{dir / "cpulist"} << cpulists[i] << '\n';
+    }
+    return root;
+}
+
+TXL_UNIT_TEST(parse_cpu_list)
+{
+    assert_true(txl::parse_cpu_list("0-3,8,10-11\n") == std::vector<size_t>{0, 1, 2, 3, 8, 10, 11});
+    assert_true(txl::parse_cpu_list("5") == std::vector<size_t>{5});
+    assert_true(txl::parse_cpu_list("").empty());
+    // Malformed entries are skipped
+    assert_true(txl::parse_cpu_list("x,2,4-3,6-") == std::vector<size_t>{2});
+}
+
+TXL_UNIT_TEST(read_numa_nodes)
+{
+    auto root = make_fake_sysfs("0-2", {"0-1", "", "2-3"});
+    auto nodes = txl::read_numa_nodes(root.string());
+    fs::remove_all(root);
+
+    // Node 1 has no CPUs
+    assert_equal(nodes.size(), size_t{2});
+    assert_equal(nodes[0].id, size_t{0});
+    assert_true(nodes[0].cpus == std::vector<size_t>{0, 1});
+    assert_equal(nodes[1].id, size_t{2});
+    assert_true(nodes[1].cpus == std::vector<size_t>{2, 3});
+}
+
+TXL_UNIT_TEST(read_numa_nodes_fallback)
+{
+    auto nodes = txl::read_numa_nodes("/nonexistent/txl/node");
+    assert_equal(nodes.size(), size_t{1});
+    assert_equal(nodes[0].id, size_t{0});
+    assert_false(nodes[0].cpus.empty());
+}
+
+TXL_UNIT_TEST(thread_affinity)
+{
+    auto original = txl::get_current_thread_affinity();
+    assert_false(original.is_error());
+    assert_false(original->empty());
+
+    auto cpu = original->front();
+    assert_false(txl::set_current_thread_affinity({cpu}).is_error());
+    assert_true(*txl::get_current_thread_affinity() == std::vector<size_t>{cpu});
+    assert_false(txl::set_current_thread_affinity(*original).is_error());
+}
+
+TXL_UNIT_TEST(numa_preferred_scope)
+{
+    // Best effort, must be harmless whether or not the kernel supports it
+    auto scope = txl::numa_preferred_scope{0};
+    auto values = std::vector<int>(1024, 1);
+    auto node = txl::numa_node_of(values.data());
+    if (scope.is_active() and node)
+    {
+        assert_equal(*node, size_t{0});
+    }
+}
+
+TXL_UNIT_TEST(numa_preferred_scope_restores_policy)
+{
+    // Stand in for a policy set before the scope, e.g. by numactl
+    unsigned long mask = 1;
+    if (::syscall(SYS_set_mempolicy, MPOL_BIND, &mask, sizeof(mask) * 8) != 0)
+    {
+        return;
+    }
+    {
+        auto scope = txl::numa_preferred_scope{0};
+    }
+    int mode = -1;
+    unsigned long nodes[16] = {};
+    assert_equal(::syscall(SYS_get_mempolicy, &mode, nodes, sizeof(nodes) * 8, nullptr, 0), 0L);
+    assert_equal(mode, MPOL_BIND);
+    assert_equal(nodes[0], 1ul);
+    ::syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+}
+
+TXL_RUN_TESTS()
@@ -0,0 +1,131 @@
+#include <txl/unit_test.h>
+#include <txl/object_pool.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct pooled_value : txl::object_pool_allocated<pooled_value>
+{
+    char data[40];
+};
+
+TXL_UNIT_TEST(object_pool_reuse)
+{
+    auto pool = txl::object_pool<std::string>{};
+    auto s = pool.make("hello");
+    assert_equal(*s, "hello");
+    assert_equal(pool.num_allocated(), 1);
+    assert_equal(pool.num_slabs(), 1);
+
+    auto p = static_cast<void *>(s);
+    pool.destroy(s);
+    assert_equal(pool.num_allocated(), 0);
+
+    // Most recently freed first
+    auto t = pool.make("world");
+    assert_equal(static_cast<void *>(t), p);
+    pool.destroy(t);
+}
+
+TXL_UNIT_TEST(object_pool_contiguous)
+{
+    auto pool = txl::object_pool<uint64_t>{};
+    auto first = pool.make(0);
+    auto prev = first;
+    for (uint64_t i = 1; i < 100; ++i)
+    {
+        auto p = pool.make(i);
+        assert_equal(p, prev + 1);
+        prev = p;
+    }
+    assert_equal(pool.num_slabs(), 1);
+    assert_equal(reinterpret_cast<uintptr_t>(first) / txl::object_pool<uint64_t>::page_size,
+                 reinterpret_cast<uintptr_t>(prev) / txl::object_pool<uint64_t>::page_size);
+}
+
+TXL_UNIT_TEST(object_pool_slabs)
+{
+    auto pool = txl::object_pool<uint64_t>{};
+    auto values = std::vector<uint64_t *>{};
+    for (uint64_t i = 0; i < 2000; ++i)
+    {
+        values.emplace_back(pool.make(i));
+    }
+    assert_greater_than(pool.num_slabs(), 1);
+    assert_greater_than_equal(pool.capacity(), 2000);
+    for (uint64_t i = 0; i < 2000; ++i)
+    {
+        assert_equal(*values[i], i);
+        pool.destroy(values[i]);
+    }
+    assert_equal(pool.num_allocated(), 0);
+}
+
+TXL_UNIT_TEST(object_pool_large_objects)
+{
+    struct big
+    {
+        char data[10000];
+    };
+    auto pool = txl::object_pool<big>{};
+    assert_equal(pool.slab_size(), 12288);
+    auto a = pool.make();
+    auto b = pool.make();
+    assert_equal(pool.num_slabs(), 2);
+    pool.destroy(a);
+    pool.destroy(b);
+}
+
+TXL_UNIT_TEST(shared_object_pool_reuse)
+{
+    auto v = new pooled_value{};
+    auto p = static_cast<void *>(v);
+    auto num_cached = txl::shared_object_pool<pooled_value>::num_cached();
+    delete v;
+    assert_equal(txl::shared_object_pool<pooled_value>::num_cached(), num_cached + 1);
+    auto w = new pooled_value{};
+    assert_equal(static_cast<void *>(w), p);
+    delete w;
+}
+
+TXL_UNIT_TEST(shared_object_pool_cross_thread)
+{
+    // Objects freed on another thread come back through the shared pool
+    using pool = txl::shared_object_pool<pooled_value>;
+    constexpr size_t num_values = 4 * pool::batch_size;
+
+    auto values = std::vector<pooled_value *>{};
+    for (size_t i = 0; i < num_values; ++i)
+    {
+        values.emplace_back(new pooled_value{});
+    }
+    std::thread{[&values]() {
+        for (auto v : values)
+        {
+            delete v;
+        }
+    }}.join();
+
+    for (size_t i = 0; i < num_values; ++i)
+    {
+        values[i] = new pooled_value{};
+    }
+    assert_less_than_equal(pool::num_cached(), 2 * pool::batch_size);
+    for (auto v : values)
+    {
+        delete v;
+    }
+}
+
+TXL_UNIT_TEST(slab_nodes_unique_ptr)
+{
+    auto n = txl::make_node<std::string, txl::slab_nodes>("node");
+    assert_equal(*n, "node");
+    n.reset();
+    auto m = txl::make_node<std::string, txl::heap_nodes>("node");
+    assert_equal(*m, "node");
+}
+
+TXL_RUN_TESTS()
@@ -0,0 +1,262 @@
+#include <txl/unit_test.h>
+#include <txl/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TXL_UNIT_TEST(parallel_for_elements)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto values = std::vector<int>(10000, 1);
+    txl::parallel_for(pool, values.begin(), values.end(), [](int & v) {
+        v *= 2;
+    });
+    assert_equal(std::accumulate(values.begin(), values.end(), 0), 20000);
+
+    // Explicit grain, including one larger than the range
+    txl::parallel_for(pool, values.begin(), values.end(), [](int & v) {
+        v += 1;
+    }, 7);
+    txl::parallel_for(pool, values.begin(), values.end(), [](int & v) {
+        v += 1;
+    }, 100000);
+    assert_equal(std::accumulate(values.begin(), values.end(), 0), 40000);
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_for_indices)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto hits = std::vector<std::atomic<int>>(1000);
+    txl::parallel_for(pool, 10, 1000, [&hits](int i) {
+        hits[i].fetch_add(1);
+    });
+    for (size_t i = 0; i < hits.size(); ++i)
+    {
+        assert_equal(hits[i].load(), i < 10 ? 0 : 1);
+    }
+
+    // Empty range
+    txl::parallel_for(pool, 5, 5, [&hits](int i) {
+        hits[i].fetch_add(1);
+    });
+    assert_equal(hits[5].load(), 0);
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_for_array_view)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    int values[100] = {};
+    txl::parallel_for(pool, txl::array_view<int>{values}, [](int & v) {
+        v = 3;
+    }, 10);
+    assert_equal(std::accumulate(std::begin(values), std::end(values), 0), 300);
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_reduce)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto values = std::vector<int64_t>(100000);
+    std::iota(values.begin(), values.end(), 1);
+    auto sum = txl::parallel_reduce(pool, values.begin(), values.end(), int64_t{0});
+    assert_equal(sum, int64_t{100000} * 100001 / 2);
+
+    // Non-commutative operations keep their order
+    auto words = std::vector<std::string>{"a", "b", "c", "d", "e", "f", "g", "h", "i", "j"};
+    auto joined = txl::parallel_reduce(pool, words.begin(), words.end(), std::string{}, [](std::string a, std::string const & b) {
+        return a + b;
+    }, 3);
+    assert_equal(joined, "abcdefghij");
+
+    auto empty = std::vector<int>{};
+    assert_equal(txl::parallel_reduce(pool, empty.begin(), empty.end(), 5), 5);
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_transform)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto in = std::vector<int>(5000);
+    std::iota(in.begin(), in.end(), 0);
+    auto out = std::vector<int>(in.size());
+    auto end = txl::parallel_transform(pool, in.begin(), in.end(), out.begin(), [](int v) {
+        return v * v;
+    });
+    assert_true(end == out.end());
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        assert_equal(out[i], in[i] * in[i]);
+    }
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_sort)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto rng = std::mt19937{1234};
+    for (auto size : {0, 1, 2, 17, 1000, 100003})
+    {
+        auto values = std::vector<int>(size);
+        for (auto & v : values)
+        {
+            v = static_cast<int>(rng() % 1000);
+        }
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        txl::parallel_sort(pool, values.begin(), values.end());
+        assert_true(values == expected);
+    }
+
+    auto values = std::vector<int>{5, 3, 9, 1, 7, 2, 8};
+    txl::parallel_sort(pool, txl::array_view<int>{values.data(), values.data() + values.size()}, std::greater<>{}, 2);
+    assert_true(values == std::vector<int>{9, 8, 7, 5, 3, 2, 1});
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_sort_merge_rounds)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    // Small grains force many rounds and deep splits of each merge, with an
+    // odd number of runs left over in some rounds
+    auto rng = std::mt19937{4321};
+    for (size_t grain : {1, 3, 64})
+    {
+        auto values = std::vector<std::string>(10007);
+        for (auto & v : values)
+        {
+            v = std::to_string(rng() % 5000);
+        }
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        txl::parallel_sort(pool, values.begin(), values.end(), std::less<>{}, grain);
+        assert_true(values == expected);
+    }
+
+    pool.stop_workers();
+}
+
+struct no_default_value
+{
+    int v;
+
+    explicit no_default_value(int v)
+        : v(v)
+    {
+    }
+};
+
+TXL_UNIT_TEST(parallel_sort_in_place)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto values = std::vector<no_default_value>{};
+    for (int i = 0; i < 1000; ++i)
+    {
+        values.emplace_back((i * 7919) % 1000);
+    }
+    txl::parallel_sort(pool, values.begin(), values.end(), [](auto const & a, auto const & b) {
+        return a.v < b.v;
+    }, 16);
+    for (int i = 0; i < 1000; ++i)
+    {
+        assert_equal(values[i].v, i);
+    }
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_exception)
+{
+    auto pool = txl::thread_pool{4};
+    pool.start_workers();
+
+    auto values = std::vector<int>(1000);
+    std::iota(values.begin(), values.end(), 0);
+    assert_throws<std::runtime_error>([&]() {
+        txl::parallel_for(pool, values.begin(), values.end(), [](int v) {
+            if (v == 500)
+            {
+                throw std::runtime_error{"bad value"};
+            }
+        }, 10);
+    });
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_nested_single_worker)
+{
+    // The waiting job helps run its children, so nesting can't deadlock a
+    // pool with one worker
+    auto pool = txl::thread_pool{1};
+    pool.start_workers();
+
+    auto total = std::atomic<int>{0};
+    auto g = txl::parallel_group{pool};
+    g.spawn([&]() {
+        txl::parallel_for(pool, 0, 100, [&](int) {
+            txl::parallel_for(pool, 0, 10, [&](int) {
+                total.fetch_add(1);
+            }, 1);
+        }, 1);
+    });
+    g.wait();
+    assert_equal(total.load(), 1000);
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_work_stealing)
+{
+    auto pool = txl::thread_pool{4, txl::thread_pool_scheduling::work_stealing};
+    pool.start_workers();
+
+    auto values = std::vector<int64_t>(100000, 1);
+    txl::parallel_for(pool, values.begin(), values.end(), [](int64_t & v) {
+        v = 2;
+    });
+    assert_equal(txl::parallel_reduce(pool, values.begin(), values.end(), int64_t{0}), int64_t{200000});
+
+    pool.stop_workers();
+}
+
+TXL_UNIT_TEST(parallel_pool_not_started)
+{
+    // The caller helps run everything itself
+    auto pool = txl::thread_pool{2};
+    auto values = std::vector<int>(100, 1);
+    txl::parallel_for(pool, values.begin(), values.end(), [](int & v) {
+        v = 0;
+    }, 10);
+    assert_equal(std::accumulate(values.begin(), values.end(), 0), 0);
+}
+
+TXL_RUN_TESTS()
@@ -0,0 +1,299 @@
+#include <txl/unit_test.h>
+#include <txl/reclaim.h>
+#include <txl/linked_list.h>
+#include <txl/threading.h>
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static std::atomic<int> num_freed = 0;
+
+struct tracked final
+{
+    int value = 0;
+
+    ~tracked()
+    {
+        num_freed.fetch_add(1);
+    }
+};
+
+/**
+ * Treiber stack on a plain atomic pointer, the shape of structure the
+ * reclaimers are meant for.
+ */
+template<class Reclaimer>
+class test_stack final
+{
+private:
+    struct node final
+    {
+        int value;
+        node * next;
+    };
+
+    std::atomic<node *> head_{nullptr};
+public:
+    ~test_stack()
+    {
+        auto n = head_.load();
+        while (n)
+        {
+            delete std::exchange(n, n->next);
+        }
+    }
+
+    auto push(int value) -> void
+    {
+        auto n = new node{value, head_.load(std::memory_order_relaxed)};
+        while (not head_.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    auto pop() -> std::optional<int>
+    {
+        auto g = typename Reclaimer::guard{};
+        while (true)
+        {
+            auto n = g.protect(head_);
+            if (not n)
+            {
+                return {};
+            }
+            if (head_.compare_exchange_weak(n, n->next, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                auto res = n->value;
+                Reclaimer::retire(n);
+                return res;
+            }
+        }
+    }
+};
+
+TXL_UNIT_TEST(epoch_retire_deferred_while_guarded)
+{
+    auto entered = txl::awaiter{};
+    auto leave = txl::awaiter{};
+    auto reader = std::thread{[&]() {
+        auto g = txl::epoch_reclaimer::guard{};
+        entered.set();
+        leave.wait();
+    }};
+    entered.wait();
+
+    auto freed = num_freed.load();
+    txl::epoch_reclaimer::retire(new tracked{});
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    // The reader may hold a pointer loaded before the retire
+    assert_equal(num_freed.load(), freed);
+    assert_equal(txl::epoch_reclaimer::num_retired(), 1);
+
+    leave.set();
+    reader.join();
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    assert_equal(num_freed.load(), freed + 1);
+    assert_equal(txl::epoch_reclaimer::num_retired(), 0);
+}
+
+TXL_UNIT_TEST(epoch_nested_guards)
+{
+    auto freed = num_freed.load();
+    {
+        auto outer = txl::epoch_reclaimer::guard{};
+        {
+            auto inner = txl::epoch_reclaimer::guard{};
+        }
+        txl::epoch_reclaimer::retire(new tracked{});
+        for (auto i = 0; i < 4; ++i)
+        {
+            txl::epoch_reclaimer::collect();
+        }
+        // Leaving the inner guard left the outer one active
+        assert_equal(num_freed.load(), freed);
+    }
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    assert_equal(num_freed.load(), freed + 1);
+}
+
+TXL_UNIT_TEST(epoch_orphans_adopted)
+{
+    // Whatever an exiting thread can't free is freed by the next collector
+    auto freed = num_freed.load();
+    auto entered = txl::awaiter{};
+    auto leave = txl::awaiter{};
+    auto reader = std::thread{[&]() {
+        auto g = txl::epoch_reclaimer::guard{};
+        entered.set();
+        leave.wait();
+    }};
+    entered.wait();
+    std::thread{[]() {
+        txl::epoch_reclaimer::retire(new tracked{});
+    }}.join();
+    assert_equal(num_freed.load(), freed);
+
+    leave.set();
+    reader.join();
+    for (auto i = 0; i < 4; ++i)
+    {
+        txl::epoch_reclaimer::collect();
+    }
+    assert_equal(num_freed.load(), freed + 1);
+}
+
+TXL_UNIT_TEST(hazard_protected_not_freed)
+{
+    auto freed = num_freed.load();
+    auto p = new tracked{};
+    auto src = std::atomic<tracked *>{p};
+
+    auto protecting = txl::awaiter{};
+    auto leave = txl::awaiter{};
+    auto reader = std::thread{[&]() {
+        auto g = txl::hazard_reclaimer::guard{};
+        auto q = g.protect(src);
+        protecting.set();
+        leave.wait();
+        // Still ours to read
+        assert_equal(q->value, 0);
+    }};
+    protecting.wait();
+
+    src.store(nullptr);
+    txl::hazard_reclaimer::retire(p);
+    txl::hazard_reclaimer::collect();
+    assert_equal(num_freed.load(), freed);
+
+    leave.set();
+    reader.join();
+    assert_equal(txl::hazard_reclaimer::collect(), 1);
+    assert_equal(num_freed.load(), freed + 1);
+}
+
+TXL_UNIT_TEST(hazard_unprotected_freed)
+{
+    auto freed = num_freed.load();
+    auto a = new tracked{};
+    auto b = new tracked{};
+    auto src = std::atomic<tracked *>{a};
+    {
+        auto g = txl::hazard_reclaimer::guard{};
+        assert_true(g.protect(src) == a);
+        txl::hazard_reclaimer::retire(a);
+        txl::hazard_reclaimer::retire(b);
+        // Only the protected pointer is held back
+        assert_equal(txl::hazard_reclaimer::collect(), 1);
+        assert_equal(num_freed.load(), freed + 1);
+        g.reset();
+        assert_equal(txl::hazard_reclaimer::collect(), 1);
+    }
+    assert_equal(num_freed.load(), freed + 2);
+}
+
+TXL_UNIT_TEST(immediate_frees_on_retire)
+{
+    auto freed = num_freed.load();
+    txl::immediate_reclaimer::retire(new tracked{});
+    assert_equal(num_freed.load(), freed + 1);
+}
+
+/**
+ * \return number and sum of the values popped
+ */
+template<class Reclaimer>
+auto stress_stack() -> std::pair<int, int64_t>
+{
+    auto s = test_stack<Reclaimer>{};
+    constexpr auto num_threads = 4;
+    constexpr auto num_values = 5000;
+    auto sum = std::atomic<int64_t>{0};
+    auto count = std::atomic<int>{0};
+    auto start = txl::awaiter{};
+
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            start.wait();
+            for (auto i = 0; i < num_values; ++i)
+            {
+                s.push(t * num_values + i);
+                if (auto v = s.pop(); v)
+                {
+                    sum.fetch_add(*v);
+                    count.fetch_add(1);
+                }
+            }
+            Reclaimer::collect();
+        });
+    }
+    start.set();
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    while (auto v = s.pop())
+    {
+        sum.fetch_add(*v);
+        count.fetch_add(1);
+    }
+    return {count.load(), sum.load()};
+}
+
+constexpr int64_t stress_total = 4 * 5000;
+
+TXL_UNIT_TEST(epoch_stack_stress)
+{
+    auto [count, sum] = stress_stack<txl::epoch_reclaimer>();
+    assert_equal(count, stress_total);
+    assert_equal(sum, stress_total * (stress_total - 1) / 2);
+}
+
+TXL_UNIT_TEST(hazard_stack_stress)
+{
+    auto [count, sum] = stress_stack<txl::hazard_reclaimer>();
+    assert_equal(count, stress_total);
+    assert_equal(sum, stress_total * (stress_total - 1) / 2);
+}
+
+TXL_UNIT_TEST(atomic_linked_list_hazard)
+{
+    auto l = txl::atomic_linked_list<std::string, txl::heap_nodes, txl::hazard_reclaimer>{};
+    auto threads = std::vector<std::thread>{};
+    auto count = std::atomic<int>{0};
+    for (auto t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < 2000; ++i)
+            {
+                l.emplace_front("Hello World No Small String Optimization Here");
+                if (auto v = l.pop_and_release_front(); v)
+                {
+                    assert_equal(*v, "Hello World No Small String Optimization Here");
+                    count.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    assert_equal(count.load() + static_cast<int>(l.clear()), 8000);
+}
+
+TXL_RUN_TESTS()
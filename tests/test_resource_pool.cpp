@@ -2,7 +2,10 @@
 #include <txl/types.h>
 #include <txl/resource_pool.h>
 
+#include <atomic>
 #include <cstring>
+#include <thread>
+#include <vector>
 
 static int deleted = 0;
 
@@ -108,4 +111,213 @@ TXL_UNIT_TEST(resource_pool_limited)
     assert(thing_factory::created == 2);
 }
 
+TXL_UNIT_TEST(resource_pool_stats)
+{
+    auto options = txl::resource_pool_options{};
+    options.init_size = 2;
+    options.num_shards = 1;
+    auto rp = txl::resource_pool<thing>{txl::resource_factory<thing>{}, options};
+
+    auto a = rp.get();
+    auto b = rp.get();
+    auto c = rp.get();
+    rp.put(std::move(a));
+    rp.put(std::move(b));
+    rp.put(std::move(c));
+
+    auto stats = rp.stats();
+    assert_equal(stats.hits, uint64_t{2});
+    assert_equal(stats.misses, uint64_t{1});
+    assert_equal(stats.creations, uint64_t{3});
+    assert_equal(stats.discards, uint64_t{0});
+    assert_equal(stats.num_retained, size_t{3});
+}
+
+TXL_UNIT_TEST(resource_pool_max_retained)
+{
+    // The bound is pool wide, a single thread may fill it however many
+    // shards there are
+    auto options = txl::resource_pool_options{};
+    options.max_retained = 3;
+    options.num_shards = 8;
+    auto rp = txl::resource_pool<thing>{txl::resource_factory<thing>{}, options};
+
+    auto held = std::vector<txl::resource<thing>>{};
+    for (auto i = 0; i < 5; ++i)
+    {
+        held.emplace_back(rp.get());
+    }
+    for (auto & r : held)
+    {
+        rp.put(std::move(r));
+    }
+    assert_equal(rp.stats().num_retained, size_t{3});
+    assert_equal(rp.stats().discards, uint64_t{2});
+
+    held.clear();
+    for (auto i = 0; i < 3; ++i)
+    {
+        held.emplace_back(rp.get());
+    }
+    assert_equal(rp.stats().hits, uint64_t{3});
+    assert_equal(rp.stats().num_retained, size_t{0});
+}
+
+TXL_UNIT_TEST(resource_pool_unbounded_by_default)
+{
+    txl::resource_pool<thing> rp{};
+    auto held = std::vector<txl::resource<thing>>{};
+    for (auto i = 0; i < 2000; ++i)
+    {
+        held.emplace_back(rp.get());
+    }
+    for (auto & r : held)
+    {
+        rp.put(std::move(r));
+    }
+    assert_equal(rp.stats().num_retained, size_t{2000});
+    assert_equal(rp.stats().discards, uint64_t{0});
+}
+
+struct reset_thing
+{
+    bool operator()(thing & t) const
+    {
+        // Broken things are dropped, the rest come back zeroed
+        if (t.number < 0)
+        {
+            return false;
+        }
+        t.number = 0;
+        return true;
+    }
+};
+
+TXL_UNIT_TEST(resource_pool_recycler)
+{
+    auto options = txl::resource_pool_options{};
+    options.num_shards = 1;
+    auto rp = txl::resource_pool<thing, txl::resource_factory<thing>, reset_thing>{txl::resource_factory<thing>{}, options};
+
+    auto r = rp.get();
+    r->number = 42;
+    rp.put(std::move(r));
+    r = rp.get();
+    assert_equal(r->number, 0);
+    assert_equal(rp.stats().hits, uint64_t{1});
+
+    r->number = -1;
+    rp.put(std::move(r));
+    assert_equal(rp.stats().num_retained, size_t{0});
+    assert_equal(rp.stats().discards, uint64_t{1});
+}
+
+TXL_UNIT_TEST(resource_pool_prewarm_threads)
+{
+    auto options = txl::resource_pool_options{};
+    options.init_size = 8;
+    options.num_init_threads = 4;
+    options.concurrent_factory = true;
+    options.num_shards = 4;
+    auto rp = txl::resource_pool<thing>{txl::resource_factory<thing>{}, options};
+    assert_equal(rp.stats().creations, uint64_t{8});
+    assert_equal(rp.stats().num_retained, size_t{8});
+}
+
+struct exclusive_thing
+{
+    std::atomic<bool> in_use{false};
+};
+
+struct serial_factory
+{
+    static std::atomic<int> num_inside;
+    static std::atomic<int> num_overlaps;
+
+    // Const but not thread safe, calls must still be serialized
+    std::unique_ptr<thing> operator()() const
+    {
+        if (num_inside.fetch_add(1) != 0)
+        {
+            ++num_overlaps;
+        }
+        std::this_thread::yield();
+        num_inside.fetch_sub(1);
+        return std::make_unique<thing>();
+    }
+};
+
+std::atomic<int> serial_factory::num_inside{0};
+std::atomic<int> serial_factory::num_overlaps{0};
+
+struct reject_thing
+{
+    bool operator()(thing &) const
+    {
+        return false;
+    }
+};
+
+TXL_UNIT_TEST(resource_pool_serial_factory)
+{
+    // Nothing is kept, so every get() calls the factory
+    auto rp = txl::resource_pool<thing, serial_factory, reject_thing>{serial_factory{}, txl::resource_pool_options{}};
+    auto threads = std::vector<std::thread>{};
+    for (auto t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&rp]() {
+            for (auto i = 0; i < 2000; ++i)
+            {
+                rp.put(rp.get());
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    assert_equal(serial_factory::num_overlaps.load(), 0);
+    assert_equal(rp.stats().creations, uint64_t{8000});
+}
+
+TXL_UNIT_TEST(resource_pool_concurrent)
+{
+    constexpr size_t num_threads = 4;
+    auto options = txl::resource_pool_options{};
+    options.num_shards = 2;
+    options.concurrent_factory = true;
+    auto rp = txl::resource_pool<exclusive_thing>{txl::resource_factory<exclusive_thing>{}, options};
+
+    auto num_shared = std::atomic<size_t>{0};
+    auto threads = std::vector<std::thread>{};
+    for (size_t t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (auto i = 0; i < 20000; ++i)
+            {
+                auto r = rp.get();
+                if (r->in_use.exchange(true))
+                {
+                    ++num_shared;
+                }
+                r->in_use.store(false);
+                rp.put(std::move(r));
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    assert_equal(num_shared.load(), size_t{0});
+
+    // Each thread holds at most one at a time, a get() only misses when
+    // another thread moves the idle resources behind its scan of the shards
+    auto stats = rp.stats();
+    assert_less_than(stats.creations, uint64_t{num_threads * 20000 / 100});
+    assert_equal(stats.hits + stats.misses, uint64_t{num_threads * 20000});
+    assert_equal(stats.discards, uint64_t{0});
+    assert_equal(stats.num_retained, stats.creations);
+}
+
 TXL_RUN_TESTS()
@@ -1,7 +1,14 @@
 #include <txl/unit_test.h>
 #include <txl/tasks.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 TXL_UNIT_TEST_VARIATION(inline_runner, []() {
     txl::task_runner::set_global(std::make_unique<txl::inline_task_runner>());
@@ -330,4 +337,308 @@ TXL_UNIT_TEST(two_awaiters)
     assert_equal(num_waited.load(std::memory_order_relaxed), 2);
 }
 
+TXL_UNIT_TEST(delay_does_not_block_pool)
+{
+    // A single worker: the delayed chain must not hold it while waiting
+    auto runner = txl::thread_pool_task_runner{1};
+
+    auto delayed_done = std::chrono::steady_clock::time_point{};
+    auto delayed = txl::task<void>([]() {
+    })
+    .then(runner.delay(std::chrono::nanoseconds{std::chrono::milliseconds{200}}.count()))
+    .then([&delayed_done]() {
+        delayed_done = std::chrono::steady_clock::now();
+    });
+    
+    auto quick_done = std::chrono::steady_clock::time_point{};
+    auto quick = txl::task<void>([&quick_done]() {
+        quick_done = std::chrono::steady_clock::now();
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    delayed.run(runner);
+    quick(runner);
+    delayed.wait();
+
+    assert_less_than(std::chrono::duration_cast<std::chrono::milliseconds>(quick_done - start).count(), 150);
+    assert_greater_than_equal(std::chrono::duration_cast<std::chrono::milliseconds>(delayed_done - start).count(), 200);
+}
+
+TXL_UNIT_TEST(stop_with_delay_pending)
+{
+    // Stopping the runner cuts a delayed chain short instead of leaving
+    // its waiters blocked
+    auto started = std::atomic<bool>{false};
+    auto resumed = std::atomic<bool>{false};
+    auto delayed = txl::task<void>([&started]() {
+        started = true;
+    });
+    {
+        auto runner = txl::thread_pool_task_runner{1};
+        delayed.then(runner.delay(std::chrono::nanoseconds{std::chrono::milliseconds{300}}.count()))
+            .then([&resumed]() {
+                resumed = true;
+            });
+        delayed.run(runner);
+        while (not started)
+        {
+            std::this_thread::yield();
+        }
+    }
+    delayed.wait();
+    assert_false(resumed.load());
+}
+
+TXL_UNIT_TEST(trailing_delay)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto t = txl::task<void>([]() {
+    })
+    .then(txl::delay(std::chrono::milliseconds(5)));
+    t();
+    assert_greater_than_equal(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(), 5);
+}
+
+TXL_UNIT_TEST(large_captures)
+{
+    // Too big for the inline buffer, stored on the heap instead
+    auto big = std::array<int, 32>{};
+    big.fill(1);
+    auto small = 1;
+    auto sum = txl::make_task<int>([big]() {
+        auto res = 0;
+        for (auto v : big)
+        {
+            res += v;
+        }
+        return res;
+    }).then([small](auto & ctx) {
+        return ctx.result() + small;
+    });
+
+    // Moving the task relocates inline functions and steals heap ones
+    auto moved = std::move(sum);
+    assert_equal(moved(), 33);
+}
+
+TXL_UNIT_TEST(when_all_vector)
+{
+    auto tasks = std::vector<txl::task<int>>{};
+    for (auto i = 0; i < 20; ++i)
+    {
+        tasks.emplace_back(txl::make_task<int>([i]() {
+            return i * i;
+        }));
+    }
+    auto all = txl::when_all(std::move(tasks));
+
+    auto squares = all();
+    assert_equal(squares.size(), size_t{20});
+    for (auto i = 0; i < 20; ++i)
+    {
+        assert_equal(squares[i], i * i);
+    }
+
+    // Reusable like any other task
+    assert_equal(all().size(), size_t{20});
+}
+
+TXL_UNIT_TEST(when_all_void)
+{
+    auto num_calls = std::atomic<int>{0};
+    auto tasks = std::vector<txl::task<void>>{};
+    for (auto i = 0; i < 10; ++i)
+    {
+        tasks.emplace_back(txl::make_task<void>([&num_calls]() {
+            ++num_calls;
+        }));
+    }
+    auto all = txl::when_all(std::move(tasks));
+    all();
+    assert_equal(num_calls.load(), 10);
+
+    auto none = txl::when_all(std::vector<txl::task<void>>{});
+    none();
+}
+
+TXL_UNIT_TEST(when_all_tuple)
+{
+    auto ran = std::atomic<bool>{false};
+    auto all = txl::when_all(
+        txl::make_task<int>([]() { return 42; }),
+        txl::make_task<std::string>([]() { return std::string{"Crow"}; }),
+        txl::make_task<void>([&ran]() { ran = true; })
+    );
+    auto [number, name, nothing] = all();
+    assert_equal(number, 42);
+    assert_equal(name, "Crow");
+    assert_true(ran.load());
+    (void)nothing;
+}
+
+TXL_UNIT_TEST(when_all_exception)
+{
+    auto num_calls = std::atomic<int>{0};
+    auto tasks = std::vector<txl::task<int>>{};
+    for (auto i = 0; i < 5; ++i)
+    {
+        tasks.emplace_back(txl::make_task<int>([i, &num_calls]() {
+            ++num_calls;
+            if (i == 2)
+            {
+                throw std::runtime_error{"failed"};
+            }
+            return i;
+        }));
+    }
+    auto all = txl::when_all(std::move(tasks));
+    assert_throws<std::runtime_error>([&]() { all(); });
+    // Every subtask still ran
+    assert_equal(num_calls.load(), 5);
+}
+
+TXL_UNIT_TEST(when_any_first)
+{
+    auto fast = txl::make_task<int>([]() {
+        return 1;
+    });
+    auto any = txl::when_any(std::move(fast), txl::make_task<int>([]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        return 2;
+    }));
+    auto res = any();
+    // The inline runner runs in order so the first task always wins there
+    assert_true(res.index == 0 or res.index == 1);
+    assert_equal(res.value, static_cast<int>(res.index) + 1);
+}
+
+TXL_UNIT_TEST(when_any_void)
+{
+    auto tasks = std::vector<txl::task<void>>{};
+    tasks.emplace_back(txl::make_task<void>([]() {}));
+    auto any = txl::when_any(std::move(tasks));
+    assert_equal(any().index, size_t{0});
+
+    auto none = txl::when_any(std::vector<txl::task<void>>{});
+    assert_throws<std::invalid_argument>([&]() { none(); });
+}
+
+TXL_UNIT_TEST(when_all_then)
+{
+    auto make_all = []() {
+        return txl::when_all(
+            txl::make_task<int>([]() { return 1; }),
+            txl::make_task<int>([]() { return 2; })
+        ).then([](auto & ctx) {
+            auto [a, b] = ctx.result();
+            return std::make_tuple(a + b, a * b);
+        }).then([](auto & ctx) {
+            auto [sum, product] = ctx.result();
+            return std::make_tuple(sum * 10, product * 10);
+        });
+    };
+
+    auto all = make_all();
+    auto [sum, product] = all();
+    assert_equal(sum, 30);
+    assert_equal(product, 20);
+
+    auto runner = txl::thread_pool_task_runner{2};
+    auto pooled = make_all();
+    auto [pooled_sum, pooled_product] = pooled(runner);
+    assert_equal(pooled_sum, 30);
+    assert_equal(pooled_product, 20);
+}
+
+TXL_UNIT_TEST(when_any_then)
+{
+    auto ran = std::atomic<bool>{false};
+    auto make_any = [&ran]() {
+        auto tasks = std::vector<txl::task<int>>{};
+        tasks.emplace_back(txl::make_task<int>([]() { return 4; }));
+        return txl::when_any(std::move(tasks)).then([&ran](auto & ctx) {
+            ran = true;
+            auto res = ctx.result();
+            res.value *= 10;
+            return res;
+        });
+    };
+
+    auto any = make_any();
+    assert_equal(any().value, 40);
+    assert_true(ran.load());
+
+    ran = false;
+    auto runner = txl::thread_pool_task_runner{2};
+    auto pooled = make_any();
+    assert_equal(pooled(runner).value, 40);
+    assert_true(ran.load());
+}
+
+TXL_UNIT_TEST(when_all_no_blocked_worker)
+{
+    // The join runs on the only worker; a blocking join would deadlock
+    auto runner = txl::thread_pool_task_runner{1};
+    auto outer = std::vector<txl::task<std::vector<int>>>{};
+    for (auto i = 0; i < 5; ++i)
+    {
+        auto inner = std::vector<txl::task<int>>{};
+        for (auto j = 0; j < 10; ++j)
+        {
+            inner.emplace_back(txl::make_task<int>([i, j]() {
+                return i * 10 + j;
+            }));
+        }
+        outer.emplace_back(txl::when_all(std::move(inner)));
+    }
+    auto all = txl::when_all(std::move(outer));
+    auto res = all(runner);
+    assert_equal(res.size(), size_t{5});
+    assert_equal(res[4][9], 49);
+}
+
+TXL_UNIT_TEST(priority_bounded_latency)
+{
+    auto options = txl::thread_pool_options{};
+    options.num_threads = 2;
+    options.num_priorities = 2;
+    auto runner = txl::thread_pool_task_runner{options};
+
+    // Saturate the pool with roughly a second of bulk work
+    constexpr auto num_bulk = 500;
+    auto num_bulk_done = std::atomic<int>{0};
+    auto bulk = std::vector<txl::task<void>>{};
+    for (auto i = 0; i < num_bulk; ++i)
+    {
+        bulk.emplace_back(txl::make_task<void>([&num_bulk_done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{4});
+            num_bulk_done.fetch_add(1);
+        }));
+    }
+    auto bulk_futures = std::vector<txl::future<void>>{};
+    for (auto & t : bulk)
+    {
+        bulk_futures.emplace_back(t.run(runner, 1));
+    }
+
+    // Urgent work only waits for the bulk jobs already running
+    auto urgent = txl::make_task<int>([]() {
+        return 42;
+    }).then([](auto & ctx) {
+        return ctx.result() + 1;
+    });
+    auto start = std::chrono::steady_clock::now();
+    urgent.run(runner, 0).wait();
+    auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    assert_equal(urgent.get_promise().get_value(), 43);
+    assert_less_than(latency.count(), 250);
+    assert_less_than(num_bulk_done.load(), num_bulk / 2);
+
+    for (auto & f : bulk_futures)
+    {
+        f.wait();
+    }
+    assert_equal(num_bulk_done.load(), num_bulk);
+}
+
 TXL_RUN_TESTS()
@@ -0,0 +1,121 @@
+#include <txl/unit_test.h>
+#include <txl/telemetry.h>
+
+#include <initializer_list>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Also built with TXL_TELEMETRY=0, where everything must read zero
+
+static_assert(txl::telemetry_enabled or std::is_empty_v<txl::telemetry_timestamp>, "disabled timestamp must be empty");
+
+TXL_UNIT_TEST(log_linear_buckets)
+{
+    using buckets = txl::log_linear_buckets;
+    for (uint64_t v = 0; v < buckets::num_sub_buckets; ++v)
+    {
+        assert_equal(buckets::index_of(v), static_cast<size_t>(v));
+    }
+    for (uint64_t v : std::initializer_list<uint64_t>{8, 9, 15, 16, 17, 1000, 123456789, UINT64_MAX})
+    {
+        auto index = buckets::index_of(v);
+        assert_less_than(index, buckets::num_buckets);
+        assert_less_than_equal(buckets::lower_bound(index), v);
+        assert_greater_than_equal(buckets::upper_bound(index), v);
+    }
+    // Buckets tile the value range
+    for (size_t i = 1; i < buckets::num_buckets; ++i)
+    {
+        assert_equal(buckets::lower_bound(i), buckets::upper_bound(i - 1) + 1);
+    }
+    // Relative error is bounded by the sub-bucket count
+    auto index = buckets::index_of(1000000);
+    assert_less_than_equal((buckets::upper_bound(index) - buckets::lower_bound(index)) * buckets::num_sub_buckets, uint64_t{1000000});
+}
+
+TXL_UNIT_TEST(histogram_percentiles)
+{
+    auto h = txl::log_linear_histogram{};
+    for (uint64_t v = 1; v <= 1000; ++v)
+    {
+        h.record(v);
+    }
+    auto s = h.snapshot();
+    if constexpr (not txl::telemetry_enabled)
+    {
+        assert_equal(s.count(), uint64_t{0});
+        assert_equal(s.percentile(0.5), uint64_t{0});
+        return;
+    }
+
+    assert_equal(s.count(), uint64_t{1000});
+    assert_equal(s.sum(), uint64_t{500500});
+    assert_equal(s.max(), uint64_t{1000});
+    assert_equal(s.mean(), 500.5);
+    // Within a bucket's width of the exact answer
+    assert_greater_than_equal(s.percentile(0.5), uint64_t{500});
+    assert_less_than_equal(s.percentile(0.5), uint64_t{500 + 500 / 8});
+    assert_greater_than_equal(s.percentile(0.99), uint64_t{990});
+    assert_equal(s.percentile(1.0), uint64_t{1000});
+    assert_less_than_equal(s.percentile(0.0), uint64_t{1});
+}
+
+TXL_UNIT_TEST(histogram_merge)
+{
+    auto a = txl::log_linear_histogram{};
+    auto b = txl::log_linear_histogram{};
+    a.record(10);
+    b.record(20);
+    b.record(3000);
+    auto s = a.snapshot();
+    s.merge(b.snapshot());
+    assert_equal(s.count(), txl::telemetry_enabled ? uint64_t{3} : uint64_t{0});
+    assert_equal(s.max(), txl::telemetry_enabled ? uint64_t{3000} : uint64_t{0});
+
+    // Merging into an empty snapshot
+    auto total = txl::histogram_snapshot{};
+    total.merge(s);
+    assert_equal(total.count(), s.count());
+}
+
+TXL_UNIT_TEST(counter_concurrent)
+{
+    auto c = txl::telemetry_counter{};
+    auto h = txl::log_linear_histogram{};
+    auto threads = std::vector<std::thread>{};
+    for (auto i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&]() {
+            for (auto j = 0; j < 10000; ++j)
+            {
+                c.add();
+                h.record(static_cast<uint64_t>(j));
+            }
+        });
+    }
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+    assert_equal(c.load(), txl::telemetry_enabled ? uint64_t{40000} : uint64_t{0});
+    assert_equal(h.snapshot().count(), c.load());
+}
+
+TXL_UNIT_TEST(timestamp)
+{
+    auto t = txl::telemetry_timestamp{};
+    t.stamp();
+    std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    auto elapsed = t.elapsed_since_stamp(txl::telemetry_now());
+    if constexpr (txl::telemetry_enabled)
+    {
+        assert_greater_than_equal(elapsed, uint64_t{2000000});
+    }
+    else
+    {
+        assert_equal(elapsed, uint64_t{0});
+    }
+}
+
+TXL_RUN_TESTS()
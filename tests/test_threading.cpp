@@ -1,6 +1,13 @@
 #include <txl/unit_test.h>
 #include <txl/threading.h>
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
 TXL_UNIT_TEST(baseline)
 {
     std::atomic<int> x = 0;
@@ -64,6 +71,35 @@ TXL_UNIT_TEST(awaiter)
     }
 }
 
+TXL_UNIT_TEST(awaiter_already_set)
+{
+    auto a = txl::awaiter{};
+    a.set();
+    // Already set, so no waiting took place
+    assert_false(a.wait());
+    assert_false(a.wait());
+    a.reset();
+    a.set();
+    assert_false(a.wait());
+}
+
+TXL_UNIT_TEST(awaiter_parked)
+{
+    auto a = txl::awaiter{};
+    auto woken = std::atomic_bool{false};
+    auto t = std::thread{[&]() {
+        assert_true(a.wait());
+        woken.store(true, std::memory_order_release);
+    }};
+
+    // Give the waiter time to exhaust spinning and park on the futex
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    assert_false(woken.load(std::memory_order_acquire));
+    a.set();
+    t.join();
+    assert_true(woken.load(std::memory_order_acquire));
+}
+
 TXL_UNIT_TEST(thread_pool_simple)
 {
     auto c = std::atomic_int{0};
@@ -120,4 +156,419 @@ TXL_UNIT_TEST(thread_pool_complete_work)
     assert_equal(c.load(), 10000);
 }
 
+TXL_UNIT_TEST(thread_pool_work_stealing_complete_work)
+{
+    auto c = std::atomic_int{0};
+    
+    auto tp = txl::thread_pool{4, txl::thread_pool_scheduling::work_stealing};
+    tp.start_workers();
+
+    for (auto i = 0; i < 10000; ++i)
+    {
+        auto added = tp.post_work(txl::make_thread_pool_lambda([&c]() {
+            c.fetch_add(1);
+        }));
+        assert_true(added);
+    }
+    
+    tp.wait_for_idle();
+    tp.stop_workers();
+    
+    assert_equal(c.load(), 10000);
+}
+
+TXL_UNIT_TEST(thread_pool_work_stealing_slow_job)
+{
+    auto c = std::atomic_int{0};
+    auto release = std::atomic_bool{false};
+    
+    auto tp = txl::thread_pool{4, txl::thread_pool_scheduling::work_stealing};
+
+    // Queue a slow job followed by quick jobs; every fourth quick job lands
+    // behind the slow job and can only finish if it gets stolen
+    tp.post_work(txl::make_thread_pool_lambda([&release]() {
+        while (not release.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }));
+    for (auto i = 0; i < 1000; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&c]() {
+            c.fetch_add(1);
+        }));
+    }
+    tp.start_workers();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (c.load() < 1000 and std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+    auto num_done = c.load();
+    release.store(true, std::memory_order_release);
+    tp.wait_for_idle();
+    tp.stop_workers();
+
+    assert_equal(num_done, 1000);
+}
+
+TXL_UNIT_TEST(thread_pool_work_stealing_nested)
+{
+    auto c = std::atomic_int{0};
+    
+    auto tp = txl::thread_pool{4, txl::thread_pool_scheduling::work_stealing};
+    tp.start_workers();
+
+    // Work spawned from a worker goes to its own deque and gets stolen
+    for (auto i = 0; i < 10; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&tp, &c]() {
+            for (auto j = 0; j < 100; ++j)
+            {
+                tp.post_work(txl::make_thread_pool_lambda([&c]() {
+                    c.fetch_add(1);
+                }));
+            }
+        }));
+    }
+    
+    tp.wait_for_idle();
+    tp.stop_workers();
+    
+    assert_equal(c.load(), 1000);
+}
+
+static auto run_in_order(txl::thread_pool_options const & options) -> std::vector<int>
+{
+    std::vector<int> order{};
+    auto tp = txl::thread_pool{options};
+    for (auto i = 0; i < 5; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&order, i]() {
+            order.emplace_back(i);
+        }));
+    }
+    tp.start_workers();
+    tp.wait_for_idle();
+    tp.stop_workers();
+    return order;
+}
+
+TXL_UNIT_TEST(thread_pool_fifo)
+{
+    auto order = run_in_order({1, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::fifo});
+    assert_equal(order, std::vector<int>{0, 1, 2, 3, 4});
+}
+
+TXL_UNIT_TEST(thread_pool_lifo)
+{
+    auto order = run_in_order({1, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::lifo});
+    assert_equal(order, std::vector<int>{4, 3, 2, 1, 0});
+}
+
+TXL_UNIT_TEST(thread_pool_fifo_batch)
+{
+    auto order = run_in_order({1, txl::thread_pool_scheduling::round_robin, txl::thread_pool_ordering::fifo, 3});
+    assert_equal(order, std::vector<int>{0, 1, 2, 3, 4});
+}
+
+// Posts work with the given priorities to a single worker before starting
+// it, returns the priorities in the order they ran
+static auto run_priorities(txl::thread_pool_options options, std::vector<size_t> const & priorities) -> std::vector<size_t>
+{
+    options.num_threads = 1;
+    std::vector<size_t> order{};
+    auto tp = txl::thread_pool{options};
+    for (auto p : priorities)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&order, p]() {
+            order.emplace_back(p);
+        }), p);
+    }
+    tp.start_workers();
+    tp.wait_for_idle();
+    tp.stop_workers();
+    return order;
+}
+
+TXL_UNIT_TEST(thread_pool_priority_strict)
+{
+    auto options = txl::thread_pool_options{};
+    options.num_priorities = 3;
+    options.priority_aging = 0;
+    auto order = run_priorities(options, {2, 1, 2, 0, 1, 0});
+    assert_equal(order, std::vector<size_t>{0, 0, 1, 1, 2, 2});
+
+    // Priorities past the last lane share it
+    order = run_priorities(options, {7, 0, 2});
+    assert_equal(order, std::vector<size_t>{0, 7, 2});
+
+    // A single lane ignores priorities
+    options.num_priorities = 1;
+    order = run_priorities(options, {1, 0});
+    assert_equal(order, std::vector<size_t>{1, 0});
+}
+
+TXL_UNIT_TEST(thread_pool_priority_weighted)
+{
+    auto options = txl::thread_pool_options{};
+    options.num_priorities = 2;
+    options.priority_policy = txl::thread_pool_priority_policy::weighted;
+    options.priority_aging = 0;
+    auto order = run_priorities(options, {1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0});
+    assert_equal(order, std::vector<size_t>{0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1});
+
+    options.priority_weights = {1, 3};
+    order = run_priorities(options, {1, 1, 1, 1, 0, 0, 0});
+    assert_equal(order, std::vector<size_t>{0, 1, 1, 1, 0, 1, 0});
+}
+
+TXL_UNIT_TEST(thread_pool_priority_aging)
+{
+    // Strict, but the low lane is served after being passed over twice
+    auto options = txl::thread_pool_options{};
+    options.num_priorities = 2;
+    options.priority_aging = 2;
+    auto order = run_priorities(options, {1, 1, 0, 0, 0, 0, 0});
+    assert_equal(order, std::vector<size_t>{0, 0, 1, 0, 0, 1, 0});
+}
+
+TXL_UNIT_TEST(thread_pool_priority_work_stealing)
+{
+    auto options = txl::thread_pool_options{};
+    options.num_threads = 2;
+    options.scheduling = txl::thread_pool_scheduling::work_stealing;
+    options.num_priorities = 2;
+    auto tp = txl::thread_pool{options};
+    tp.start_workers();
+
+    auto c = std::atomic_int{0};
+    for (auto i = 0; i < 10; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&]() {
+            // Nested work on both lanes, the less urgent bypasses the deque
+            for (size_t p = 0; p < 2; ++p)
+            {
+                tp.post_work(txl::make_thread_pool_lambda([&c]() {
+                    c.fetch_add(1);
+                }), p);
+            }
+        }), static_cast<size_t>(i % 2));
+    }
+    tp.wait_for_idle();
+    tp.stop_workers();
+    assert_equal(c.load(), 20);
+}
+
+TXL_UNIT_TEST(thread_pool_telemetry)
+{
+    auto tp = txl::thread_pool{2};
+    for (auto i = 0; i < 10; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }));
+    }
+
+    // Queued but not started
+    auto stats = tp.stats();
+    assert_equal(stats.workers.size(), size_t{2});
+    assert_equal(stats.num_pending, size_t{10});
+    if constexpr (txl::telemetry_enabled)
+    {
+        assert_equal(stats.total.num_posted, uint64_t{10});
+        assert_equal(stats.total.queue_depth, uint64_t{10});
+        assert_equal(stats.workers[0].queue_depth + stats.workers[1].queue_depth, uint64_t{10});
+    }
+
+    tp.start_workers();
+    tp.wait_for_idle();
+    stats = tp.stats();
+    tp.stop_workers();
+
+    assert_equal(stats.num_pending, size_t{0});
+    if constexpr (txl::telemetry_enabled)
+    {
+        assert_equal(stats.total.num_dequeued, uint64_t{10});
+        assert_equal(stats.total.num_executed, uint64_t{10});
+        assert_equal(stats.total.queue_depth, uint64_t{0});
+        assert_equal(stats.total.queue_wait.count(), uint64_t{10});
+        assert_equal(stats.total.run_time.count(), uint64_t{10});
+        assert_greater_than_equal(stats.total.run_time.percentile(0.5), uint64_t{1000000});
+    }
+}
+
+TXL_UNIT_TEST(thread_pool_elastic)
+{
+    auto options = txl::thread_pool_options{};
+    options.num_threads = 4;
+    options.elastic = true;
+    options.min_threads = 1;
+    options.grow_threshold = std::chrono::milliseconds{2};
+    options.idle_timeout = std::chrono::milliseconds{20};
+    auto tp = txl::thread_pool{options};
+    assert_equal(tp.num_threads(), size_t{4});
+    assert_equal(tp.num_active_threads(), size_t{1});
+    tp.start_workers();
+
+    // A backlog of slow jobs makes the pool grow
+    auto c = std::atomic_int{0};
+    for (auto i = 0; i < 100; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&c]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{2});
+            c.fetch_add(1);
+        }));
+    }
+    size_t max_active = 0;
+    while (c.load() < 100)
+    {
+        max_active = std::max(max_active, tp.num_active_threads());
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    tp.wait_for_idle();
+    assert_greater_than(max_active, size_t{1});
+    assert_less_than_equal(max_active, size_t{4});
+
+    // And shrinks back once idle
+    for (auto i = 0; i < 500 and tp.num_active_threads() > 1; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    assert_equal(tp.num_active_threads(), size_t{1});
+    tp.stop_workers();
+}
+
+TXL_UNIT_TEST(thread_pool_elastic_handoff)
+{
+    // Workers come and go constantly, no work may be lost on the way
+    for (auto scheduling : {txl::thread_pool_scheduling::round_robin, txl::thread_pool_scheduling::work_stealing})
+    {
+        auto options = txl::thread_pool_options{};
+        options.num_threads = 3;
+        options.scheduling = scheduling;
+        options.elastic = true;
+        options.grow_threshold = std::chrono::microseconds{200};
+        options.idle_timeout = std::chrono::microseconds{200};
+        options.elastic_interval = std::chrono::microseconds{100};
+        auto tp = txl::thread_pool{options};
+        tp.start_workers();
+
+        auto c = std::atomic_int{0};
+        for (auto burst = 0; burst < 50; ++burst)
+        {
+            for (auto i = 0; i < 40; ++i)
+            {
+                tp.post_work(txl::make_thread_pool_lambda([&c, i]() {
+                    if (i % 10 == 0)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds{300});
+                    }
+                    c.fetch_add(1);
+                }));
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds{500});
+        }
+        tp.wait_for_idle();
+        tp.stop_workers();
+        assert_equal(c.load(), 50 * 40);
+    }
+}
+
+TXL_UNIT_TEST(thread_pool_try_run_one)
+{
+    // Workers not started, the caller runs the queued work itself
+    auto tp = txl::thread_pool{2};
+    auto num_calls = 0;
+    for (auto i = 0; i < 3; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&num_calls]() {
+            ++num_calls;
+        }));
+    }
+    while (tp.try_run_one())
+    {
+    }
+    assert_equal(num_calls, 3);
+    assert_false(tp.try_run_one());
+    tp.wait_for_idle();
+}
+
+TXL_UNIT_TEST(thread_pool_pinned)
+{
+    auto allowed = txl::get_current_thread_affinity();
+    assert_false(allowed.is_error());
+    auto cpu = allowed->front();
+
+    auto options = txl::thread_pool_options{};
+    options.num_threads = 2;
+    options.cpus = {cpu};
+    auto tp = txl::thread_pool{options};
+    tp.start_workers();
+
+    auto mut = std::mutex{};
+    auto seen = std::vector<std::vector<size_t>>{};
+    for (auto i = 0; i < 4; ++i)
+    {
+        tp.post_work(txl::make_thread_pool_lambda([&]() {
+            auto affinity = txl::get_current_thread_affinity();
+            auto lock = std::unique_lock<std::mutex>{mut};
+            seen.emplace_back(*affinity);
+        }));
+    }
+    tp.wait_for_idle();
+    tp.stop_workers();
+
+    assert_equal(seen.size(), size_t{4});
+    for (auto const & s : seen)
+    {
+        assert_true(s == std::vector<size_t>{cpu});
+    }
+}
+
+TXL_UNIT_TEST(thread_pool_numa_aware)
+{
+    // Two fake nodes sharing the CPU we are allowed on, so pinning succeeds
+    auto allowed = txl::get_current_thread_affinity();
+    assert_false(allowed.is_error());
+    auto cpu = std::to_string(allowed->front());
+
+    auto tmpl = (std::filesystem::temp_directory_path() / "txl_numa_XXXXXX").string();
+    auto root = std::filesystem::path{::mkdtemp(tmpl.data())};
+    std::ofstream{root / "online"} << "0,3\n";
+    for (auto node : {"node0", "node3"})
+    {
+        std::filesystem::create_directory(root / node);
+        std::ofstream{root / node / "cpulist"} << cpu << "\n";
+    }
+
+    auto options = txl::thread_pool_options{};
+    options.num_threads = 3;
+    options.numa_aware = true;
+    options.numa_sysfs_root = root.string();
+    auto tp = txl::thread_pool{options};
+    std::filesystem::remove_all(root);
+
+    assert_true(tp.numa_nodes() == std::vector<size_t>{0, 3});
+    assert_equal(tp.worker_placement(0).numa_node.value(), size_t{0});
+    assert_equal(tp.worker_placement(1).numa_node.value(), size_t{0});
+    assert_equal(tp.worker_placement(2).numa_node.value(), size_t{3});
+    assert_equal(tp.worker_placement(2).group, size_t{1});
+
+    tp.start_workers();
+    auto c = std::atomic_int{0};
+    for (auto i = 0; i < 10; ++i)
+    {
+        // Node 7 isn't in the pool and falls back to any worker
+        auto added = tp.post_work(txl::make_thread_pool_lambda([&c]() {
+            c.fetch_add(1);
+        }), txl::thread_pool_locality{i % 2 == 0 ? size_t{3} : size_t{7}});
+        assert_true(added);
+    }
+    tp.wait_for_idle();
+    tp.stop_workers();
+    assert_equal(c.load(), 10);
+}
+
 TXL_RUN_TESTS()
@@ -0,0 +1,93 @@
+#include <txl/unit_test.h>
+#include <txl/timer_wheel.h>
+
+#include <vector>
+
+TXL_UNIT_TEST(timer_wheel_empty)
+{
+    auto w = txl::timer_wheel<int>{};
+    assert_true(w.empty());
+    assert_equal(w.ticks_until_next(), 0);
+    w.advance(1000, [](int) {});
+    assert_equal(w.now(), 1000);
+}
+
+TXL_UNIT_TEST(timer_wheel_expired)
+{
+    auto w = txl::timer_wheel<int>{10};
+    assert_false(w.schedule(10, 1));
+    assert_false(w.schedule(5, 1));
+    assert_true(w.empty());
+}
+
+TXL_UNIT_TEST(timer_wheel_order)
+{
+    auto w = txl::timer_wheel<int>{};
+    w.schedule(3, 3);
+    w.schedule(1, 1);
+    w.schedule(2, 2);
+    assert_equal(w.size(), 3);
+    assert_equal(w.ticks_until_next(), 1);
+
+    std::vector<int> fired{};
+    auto on_expire = [&fired](int v) {
+        fired.emplace_back(v);
+    };
+    w.advance(1, on_expire);
+    assert_equal(fired, std::vector<int>{1});
+    w.advance(3, on_expire);
+    assert_equal(fired, std::vector<int>{1, 2, 3});
+    assert_true(w.empty());
+}
+
+TXL_UNIT_TEST(timer_wheel_cascade)
+{
+    // Deadlines spanning several levels must each fire on their exact tick
+    std::vector<uint64_t> deadlines{63, 64, 65, 100, 4095, 4096, 4097, 300000, 17000000};
+    auto w = txl::timer_wheel<uint64_t>{};
+    for (auto d : deadlines)
+    {
+        w.schedule(d, d);
+    }
+
+    std::vector<uint64_t> fired{};
+    for (size_t i = 0; i < deadlines.size(); ++i)
+    {
+        auto d = deadlines[i];
+        w.advance(d - 1, [&fired](uint64_t v) {
+            fired.emplace_back(v);
+        });
+        assert_equal(fired.size(), i);
+        w.advance(d, [this, &fired, &w](uint64_t v) {
+            assert_equal(v, w.now());
+            fired.emplace_back(v);
+        });
+    }
+    assert_equal(fired, deadlines);
+    assert_true(w.empty());
+}
+
+TXL_UNIT_TEST(timer_wheel_ticks_until_next)
+{
+    auto w = txl::timer_wheel<int>{};
+    w.schedule(1000, 1);
+    // Nothing in level 0, so the next stop is the level 0 wrap
+    assert_equal(w.ticks_until_next(), 64);
+    w.advance(960, [](int) {});
+    assert_equal(w.ticks_until_next(), 40);
+}
+
+TXL_UNIT_TEST(timer_wheel_clear)
+{
+    auto w = txl::timer_wheel<int>{};
+    w.schedule(5, 1);
+    w.schedule(500, 2);
+    auto num_cleared = 0;
+    w.clear([&num_cleared](int) {
+        ++num_cleared;
+    });
+    assert_equal(num_cleared, 2);
+    assert_true(w.empty());
+}
+
+TXL_RUN_TESTS()
@@ -203,5 +203,19 @@ TXL_UNIT_TEST(edge_case_5)
     assert_equal(bst.find(5)->second, "E");
 }
 
+TXL_UNIT_TEST(slab_nodes)
+{
+    txl::binary_search_tree<int, int, std::less, txl::slab_nodes> bst{};
+    for (auto i : {50, 25, 75, 10, 30, 60, 90})
+    {
+        bst.emplace(int{i}, i*10);
+    }
+    bst.remove(25);
+    bst.remove(50);
+    assert_equal(bst.find(25), nullptr);
+    assert_equal(bst.find(50), nullptr);
+    assert_equal(bst.find(30)->second, 300);
+    assert_equal(bst.find(90)->second, 900);
+}
 
 TXL_RUN_TESTS()
@@ -0,0 +1,125 @@
+#include <txl/unit_test.h>
+#include <txl/work_stealing_deque.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TXL_UNIT_TEST(work_stealing_deque_empty)
+{
+    auto d = txl::work_stealing_deque<int>{};
+    assert_true(d.empty());
+    assert_false(d.pop().has_value());
+    assert_false(d.steal().has_value());
+}
+
+TXL_UNIT_TEST(work_stealing_deque_push_pop)
+{
+    auto d = txl::work_stealing_deque<int>{};
+    d.push(1);
+    d.push(2);
+    d.push(3);
+    assert_equal(d.size(), 3);
+    // Owner pops LIFO
+    assert_equal(*d.pop(), 3);
+    assert_equal(*d.pop(), 2);
+    assert_equal(*d.pop(), 1);
+    assert_true(d.empty());
+}
+
+TXL_UNIT_TEST(work_stealing_deque_steal)
+{
+    auto d = txl::work_stealing_deque<int>{};
+    d.push(1);
+    d.push(2);
+    d.push(3);
+    // Thieves steal FIFO
+    assert_equal(*d.steal(), 1);
+    assert_equal(*d.pop(), 3);
+    assert_equal(*d.steal(), 2);
+    assert_false(d.steal().has_value());
+    assert_false(d.pop().has_value());
+}
+
+TXL_UNIT_TEST(work_stealing_deque_grow)
+{
+    auto d = txl::work_stealing_deque<int>{4};
+    assert_equal(d.capacity(), 4);
+    for (auto i = 0; i < 100; ++i)
+    {
+        d.push(i);
+    }
+    assert_equal(d.size(), 100);
+    assert_greater_than_equal(d.capacity(), 100);
+    for (auto i = 0; i < 50; ++i)
+    {
+        assert_equal(*d.steal(), i);
+    }
+    for (auto i = 99; i >= 50; --i)
+    {
+        assert_equal(*d.pop(), i);
+    }
+    assert_true(d.empty());
+}
+
+TXL_UNIT_TEST(work_stealing_deque_concurrent)
+{
+    static constexpr int num_items = 100000;
+    static constexpr int num_thieves = 3;
+
+    auto d = txl::work_stealing_deque<int>{8};
+    std::vector<std::atomic<int>> seen(num_items);
+    std::atomic<int> num_taken = 0;
+    std::atomic_bool done = false;
+
+    std::vector<std::thread> thieves{};
+    for (auto i = 0; i < num_thieves; ++i)
+    {
+        thieves.emplace_back([&]() {
+            while (not done.load(std::memory_order_acquire))
+            {
+                if (auto v = d.steal(); v)
+                {
+                    seen[*v].fetch_add(1, std::memory_order_relaxed);
+                    num_taken.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (auto i = 0; i < num_items; ++i)
+    {
+        d.push(i);
+        if (i % 3 == 0)
+        {
+            if (auto v = d.pop(); v)
+            {
+                seen[*v].fetch_add(1, std::memory_order_relaxed);
+                num_taken.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    while (auto v = d.pop())
+    {
+        seen[*v].fetch_add(1, std::memory_order_relaxed);
+        num_taken.fetch_add(1, std::memory_order_relaxed);
+    }
+    while (num_taken.load(std::memory_order_relaxed) < num_items)
+    {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto & t : thieves)
+    {
+        t.join();
+    }
+
+    // Every item must be taken exactly once
+    assert_equal(num_taken.load(), num_items);
+    for (auto const & s : seen)
+    {
+        assert_equal(s.load(), 1);
+    }
+}
+
+TXL_RUN_TESTS()